@@ -9,7 +9,7 @@ TEMPLATE = app
 # this pri must be sourced from all our applications
 include( ../../../externals/IBK/projects/Qt/IBK.pri )
 
-QT += printsupport widgets svg
+QT += printsupport widgets svg concurrent
 
 CONFIG += c++11
 
@@ -60,24 +60,56 @@ HEADERS += \
 	../../src/aboutdialog.h \
 	../../src/curvedata.h \
 	../../src/cxtsimfit.h \
+	../../src/cyclicsteadystate.h \
+	../../src/dataimporter.h \
+	../../src/gridstudy.h \
 	../../src/inspectprofiledialog.h \
 	../../src/levmaroptimizer.h \
+	../../src/parallelfor.h \
+	../../src/parareal.h \
+	../../src/podmodel.h \
+	../../src/profilerecorder.h \
+	../../src/profilestore.h \
+	../../src/resultcache.h \
+	../../src/resultfile.h \
 #	../../src/optimizer.h \
 	../../src/solver.h \
 	../../src/solverinput.h \
-	../../src/solverresults.h
+	../../src/solverobserver.h \
+	../../src/solverresults.h \
+	../../src/solverstatistics.h
 
 SOURCES += \
 	../../src/aboutdialog.cpp \
 	../../src/curvedata.cpp \
 	../../src/cxtsimfit.cpp \
+	../../src/cyclicsteadystate.cpp \
+	../../src/dataimporter.cpp \
+	../../src/gridstudy.cpp \
 	../../src/inspectprofiledialog.cpp \
 	../../src/levmaroptimizer.cpp \
 	../../src/main.cpp \
+	../../src/parallelfor.cpp \
+	../../src/parareal.cpp \
+	../../src/podmodel.cpp \
+	../../src/profilerecorder.cpp \
+	../../src/profilestore.cpp \
+	../../src/resultcache.cpp \
+	../../src/resultfile.cpp \
 #	../../src/optimizer.cpp \
 	../../src/solver.cpp \
+	../../src/solvercharacteristic.cpp \
+	../../src/solvercheckpoint.cpp \
+	../../src/solverimex.cpp \
+	../../src/solverkrylov.cpp \
+	../../src/solvermultirate.cpp \
+	../../src/solverprobe.cpp \
+	../../src/solversteadystate.cpp \
+	../../src/solverthreaded.cpp \
 	../../src/solverinput.cpp \
-	../../src/solverresults.cpp
+	../../src/solverobserver.cpp \
+	../../src/solverresults.cpp \
+	../../src/solverstatistics.cpp
 
 
 
@@ -0,0 +1,65 @@
+# Project file for CXTSimFitBench, the command line work-precision study
+#
+# remember to set DYLD_FALLBACK_LIBRARY_PATH on MacOSX
+# set LD_LIBRARY_PATH on Linux
+
+TARGET = CXTSimFitBench
+TEMPLATE = app
+
+# this pri must be sourced from all our applications
+include( ../../../externals/IBK/projects/Qt/IBK.pri )
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+unix {
+	QMAKE_CXXFLAGS += -Wno-deprecated-copy
+}
+
+LIBS += -L../../../lib$${DIR_PREFIX} \
+	-lIBK \
+	-lsundials
+
+INCLUDEPATH = \
+	../../src \
+	../../../externals/IBK/src \
+	../../../externals/sundials/src/include
+
+DEPENDPATH = $${INCLUDEPATH}
+
+win32 {
+PRE_TARGETDEPS += \
+	$$PWD/../../../externals/lib$${DIR_PREFIX}/IBK.lib \
+	$$PWD/../../../externals/lib$${DIR_PREFIX}/sundials.lib
+}
+
+HEADERS += \
+	../../src/parallelfor.h \
+	../../src/profilerecorder.h \
+	../../src/profilestore.h \
+	../../src/solver.h \
+	../../src/solverinput.h \
+	../../src/solverobserver.h \
+	../../src/solverstatistics.h \
+	../../src/workprecision.h
+
+SOURCES += \
+	../../src/cxtsimfitbench.cpp \
+	../../src/parallelfor.cpp \
+	../../src/profilerecorder.cpp \
+	../../src/profilestore.cpp \
+	../../src/solver.cpp \
+	../../src/solvercharacteristic.cpp \
+	../../src/solvercheckpoint.cpp \
+	../../src/solverimex.cpp \
+	../../src/solverkrylov.cpp \
+	../../src/solvermultirate.cpp \
+	../../src/solverprobe.cpp \
+	../../src/solversteadystate.cpp \
+	../../src/solverthreaded.cpp \
+	../../src/solverinput.cpp \
+	../../src/solverobserver.cpp \
+	../../src/solverstatistics.cpp \
+	../../src/workprecision.cpp
@@ -0,0 +1,40 @@
+# Project file for CXTSimFitImportBench, the command line benchmark of the data importer
+#
+# remember to set DYLD_FALLBACK_LIBRARY_PATH on MacOSX
+# set LD_LIBRARY_PATH on Linux
+
+TARGET = CXTSimFitImportBench
+TEMPLATE = app
+
+# this pri must be sourced from all our applications
+include( ../../../externals/IBK/projects/Qt/IBK.pri )
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+unix {
+	QMAKE_CXXFLAGS += -Wno-deprecated-copy
+}
+
+LIBS += -L../../../lib$${DIR_PREFIX} \
+	-lIBK
+
+INCLUDEPATH = \
+	../../src \
+	../../../externals/IBK/src
+
+DEPENDPATH = $${INCLUDEPATH}
+
+win32 {
+PRE_TARGETDEPS += \
+	$$PWD/../../../externals/lib$${DIR_PREFIX}/IBK.lib
+}
+
+HEADERS += \
+	../../src/dataimporter.h
+
+SOURCES += \
+	../../src/cxtsimfitimportbench.cpp \
+	../../src/dataimporter.cpp
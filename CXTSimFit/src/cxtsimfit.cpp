@@ -1,8 +1,13 @@
 #include <QtGui>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QtConcurrent>
+#include <QStandardPaths>
 
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 #include <qnandefaultchartseries.h>
 #include <qnanchartaxis.h>
@@ -14,17 +19,37 @@
 #include "inspectprofiledialog.h"
 #include "solverresults.h"
 #include "solver.h"
+#include "profilerecorder.h"
+#include "parareal.h"
+#include "cyclicsteadystate.h"
+#include "resultfile.h"
+#include "dataimporter.h"
 
 const char * PROGRAM_NAME = "CXT Sim-Fit";
 const char * PROGRAM_VERSION = "2.0";
+/// Maximum size of the result cache in bytes.
+const uint64_t RESULT_CACHE_SIZE = 1024ull*1024*1024;
+/// Interval in ms in which a followed outlet data file is checked for appended rows.
+const int OUTLET_DATA_POLL_INTERVAL = 1000;
 
 CXTSimFit::CXTSimFit(QWidget *parent)
 	: QDialog(parent, Qt::WindowMinMaxButtonsHint | Qt::Dialog)
 {
 	ui.setupUi(this);
+	lastRunCurves = 0;
+	outletSplinesOutdated = false;
 
 	setWindowTitle(QString("%1 %2").arg(PROGRAM_NAME).arg(PROGRAM_VERSION));
 
+	// results of previous runs (also of other sessions) are kept in the user's cache directory
+	try {
+		QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/results";
+		resultCache.open(cacheDir.toLocal8Bit().constData(), RESULT_CACHE_SIZE);
+	}
+	catch (std::exception & ex) {
+		qDebug() << "Result cache disabled:" << ex.what();
+	}
+
 	ui.tabWidget->setCurrentIndex(0);
 
 	// create data series for measured data
@@ -50,6 +75,35 @@ CXTSimFit::CXTSimFit(QWidget *parent)
 	ui.comboBoxModel->addItem(tr("Equilibrium Sorption (1 BE)") );
 	ui.comboBoxModel->addItem(tr("+ mass transfer (2 BE)") );
 
+	// setup the engine combo box, order must match SolverInput::engine_t
+	ui.comboBoxEngine->addItem(tr("CVODE (implicit multistep)") );
+	ui.comboBoxEngine->addItem(tr("Characteristics (D = 0 only)") );
+	ui.comboBoxEngine->addItem(tr("IMEX (explicit transport, implicit exchange)") );
+	ui.comboBoxEngine->addItem(tr("Multirate (slow immobile phase)") );
+
+	// setup the linear solver combo box, order must match SolverInput::linearSolver_t
+	ui.comboBoxLinearSolver->addItem(tr("Band (direct)") );
+	ui.comboBoxLinearSolver->addItem(tr("GMRES (matrix-free, large grids)") );
+
+	// setup the integrator combo box, order must match SolverInput::integrator_t
+	ui.comboBoxIntegrator->addItem(tr("BDF (stiff)") );
+	ui.comboBoxIntegrator->addItem(tr("Adams (non-stiff)") );
+	ui.comboBoxIntegrator->addItem(tr("Automatic (probe both)") );
+
+	// setup the steady state combo box, order must match SolverInput::steadyState_t
+	ui.comboBoxSteadyState->addItem(tr("Transient only") );
+	ui.comboBoxSteadyState->addItem(tr("Direct steady-state solution") );
+	ui.comboBoxSteadyState->addItem(tr("Stop transient at steady state") );
+	ui.comboBoxSteadyState->addItem(tr("Start from steady state") );
+	ui.comboBoxSteadyState->addItem(tr("Cyclic steady state (shooting)") );
+	ui.comboBoxSteadyState->addItem(tr("Cyclic steady state (direct cycling)") );
+
+	// setup the profile compression combo box, order must match SolverInput::profileCompression_t
+	ui.comboBoxProfileCompression->addItem(tr("None") );
+	ui.comboBoxProfileCompression->addItem(tr("Lossless") );
+	ui.comboBoxProfileCompression->addItem(tr("Float (32 bit)") );
+	ui.comboBoxProfileCompression->addItem(tr("Quantized (absolute tolerance)") );
+
 	ui.lineEditOutletData->setText("../../data/example/filter/outlet.txt");
 	ui.lineEditInletData->setText("../../data/example/filter/inlet.txt");
 	loadDataFiles();
@@ -84,122 +138,192 @@ CXTSimFit::CXTSimFit(QWidget *parent)
 	ui.lineEditRelTol->setText("1e-5");
 	ui.lineEditAbsTol->setText("1e-10");
 	ui.lineEditDigits->setText("1e-10");
+	ui.lineEditMacroDt->setText("600");
+	ui.lineEditCyclePeriod->setText("0");
+	ui.lineEditProfileChange->setText("0");
+	ui.lineEditBreakthroughFractions->setText("0.05 0.5 0.95");
 
 	connect(ui.lineEditp, SIGNAL(textChanged(const QString &)),
 		this, SLOT(on_lineEditq_textChanged(const QString &)));
 	connect(ui.lineEditA, SIGNAL(textChanged(const QString &)),
 		this, SLOT(on_lineEditq_textChanged(const QString &)));
 	on_lineEditq_textChanged(QString());
+
+	outletDataTimer.setInterval(OUTLET_DATA_POLL_INTERVAL);
+	connect(&outletDataTimer, SIGNAL(timeout()), this, SLOT(followOutletData()));
 }
 
 CXTSimFit::~CXTSimFit()
 {
+	// the grid study accesses this object
+	gridStudyWatcher.waitForFinished();
 }
 
 void CXTSimFit::solverRunCompleted(bool add_series, const SolverResults & res) {
 	QString desc = QString("R2=%3").arg(res.R2);
+	for (unsigned int k=0; k<res.breakthroughT.size(); ++k) {
+		if (res.breakthroughT[k] < 0)
+			desc += QString(", t(%1%) not reached").arg(res.input.breakthroughFractions[k]*100);
+		else
+			desc += QString(", t(%1%)=%2 h").arg(res.input.breakthroughFractions[k]*100).arg(res.breakthroughT[k]);
+	}
 
-	CurveData * c;
-	if (add_series) {
-		curves.append(CurveData());
-		ui.listWidgetCurveInfo->addItem(desc);
-		c = &curves.back();
-		c->init(ui.chart);
+	// the outlet curve is followed by one curve per probe
+	int count = 1 + (int)res.probes.size();
+	if (add_series || lastRunCurves != count) {
+		addCurve(desc, res.data.x(), res.data.y(), res);
+		for (unsigned int j=0; j<res.probes.size(); ++j)
+			addCurve(QString("Probe at %1 m").arg(res.input.probePositions[j]), res.probes[j].x(), res.probes[j].y());
+		lastRunCurves = count;
 	}
 	else {
-		// only add if curves list is empty
-		if (curves.isEmpty()) {
-			curves.append(CurveData());
-			ui.listWidgetCurveInfo->addItem(desc);
-			c = &curves.back();
-			c->init(ui.chart);
-		}
-		else {
-			QListWidgetItem * item = ui.listWidgetCurveInfo->item(ui.listWidgetCurveInfo->count()-1);
-			item->setText(desc);
-			// TODO : modify last item in list
-			c = &curves.back();
-		}
-	}
-	// use the last series
-	QList<double> x,y;
-	for (int i=0; i<res.data.x().size(); ++i) {
-		x.append(res.data.x()[i]);
-		y.append(res.data.y()[i]);
+		// update the curves of the last run
+		int first = curves.size() - count;
+		ui.listWidgetCurveInfo->item(first)->setText(desc);
+		setCurveData(first, res.data.x(), res.data.y());
+		curveResults[first] = res;
+		for (unsigned int j=0; j<res.probes.size(); ++j)
+			setCurveData(first + 1 + j, res.probes[j].x(), res.probes[j].y());
+		ui.chart->updateChart();
 	}
-	c->series->setData(x,y);
+}
+
+void CXTSimFit::addCurve(const QString & desc, const std::vector<double> & x, const std::vector<double> & y,
+						 const SolverResults & res)
+{
+	curves.append(CurveData());
+	curveResults.append(res);
+	ui.listWidgetCurveInfo->addItem(desc);
+	curves.back().init(ui.chart);
+	setCurveData(curves.size()-1, x, y);
 	ui.chart->updateChart();
+	lastRunCurves = 0; // curves of other sources follow the last run
+}
 
-	lastResults = res;
+void CXTSimFit::setCurveData(int idx, const std::vector<double> & x, const std::vector<double> & y) {
+	QList<double> xvals, yvals;
+	for (unsigned int i=0; i<x.size(); ++i) {
+		xvals.append(x[i]);
+		yvals.append(y[i]);
+	}
+	curves[idx].series->setData(xvals, yvals);
 }
 
-void CXTSimFit::loadDataFiles() {
-	// tell series that we don't have any data momentarily
-	outletCurve.series->clear();
-	inletCurve.series->clear();
+/// Copies values into a list for the chart series.
+static QList<double> toList(const std::vector<double> & values) {
+	QList<double> list;
+	list.reserve(static_cast<int>(values.size()));
+	for (unsigned int i=0; i<values.size(); ++i)
+		list.append(values[i]);
+	return list;
+}
+
+/// Points series to the values x and y without copying them, clears the series if there are no values.
+static void setSeriesData(QNANDefaultChartSeries * series, std::vector<double> & x, std::vector<double> & y) {
+	if (x.empty())
+		series->clear();
+	else
+		series->setData(static_cast<int>(x.size()), &x[0], &y[0]);
+}
 
-	// first outlet data
-	QFile f(ui.lineEditOutletData->text());
-	f.open(QIODevice::ReadOnly | QIODevice::Text);
-	QTextStream stream(&f);
-	QString line;
-	// read first section
-	QList<double> x;
-	QList<double> y;
-	do {
-		line = stream.readLine();
-		if (line.isEmpty()) break;
-		if (line[0] == '#') continue;
-		QTextStream linestrm(&line);
-		double t, val;
-		linestrm >> t >> val;
-		if (linestrm.status() != QTextStream::Ok) break;
-		x.append(t);
-		y.append(val);
-	} while (!line.isNull());
-	qDebug() << "Outlet data points = " << x.size();
-
-	if (!x.isEmpty()) {
-		outletCurve.series->setData(x,y);
-		outletCurveSpline.clear();
-		std::vector<double> xvals(x.begin(), x.end());
-		std::vector<double> yvals(y.begin(), y.end());
+void CXTSimFit::updateOutletCurves(size_t first) {
+	// the series point into outletData and the probe vectors, only the rows from first on are added
+	int probeColumns = outletData.m_values.empty() ? 0 : (int)outletData.m_values.size() - 1;
+	for (int j=probeColumns; j<probeCurves.size(); ++j)
+		probeCurves[j].series->clear();
+	probeT.resize(probeColumns);
+	probeC.resize(probeColumns);
+	probeRows.resize(probeColumns);
+	for (int j=0; j<probeColumns; ++j) {
+		// values of replaced rows are removed, rows without a value for the probe are skipped
+		size_t keep = std::lower_bound(probeRows[j].begin(), probeRows[j].end(), first) - probeRows[j].begin();
+		probeT[j].resize(keep);
+		probeC[j].resize(keep);
+		probeRows[j].resize(keep);
+		const std::vector<double> & c = outletData.m_values[j+1];
+		for (size_t i=first; i<c.size(); ++i) {
+			if (std::isnan(c[i]))
+				continue;
+			probeT[j].push_back(outletData.m_t[i]);
+			probeC[j].push_back(c[i]);
+			probeRows[j].push_back(i);
+		}
+		if (j == probeCurves.size()) {
+			probeCurves.append(CurveData());
+			probeCurves.back().init(ui.chart);
+			probeCurves.back().series->setColor(QColor(204, 130, 45));
+			probeCurves.back().series->setMarkerStyle(QNANDefaultChartSeries::Diamond);
+			probeCurves.back().series->setMarkerSize(4);
+			probeCurves.back().series->setSeriesType(QNANDefaultChartSeries::LineAndMarker);
+		}
+		setSeriesData(probeCurves[j].series, probeT[j], probeC[j]);
+	}
+
+	// the vectors may have been reallocated, hence the outlet series is set again
+	if (outletData.m_values.empty())
+		outletCurve.series->clear();
+	else
+		setSeriesData(outletCurve.series, outletData.m_t, outletData.m_values[0]);
+	outletSplinesOutdated = true;
+}
+
+void CXTSimFit::updateOutletSplines() {
+	if (!outletSplinesOutdated)
+		return;
+	outletSplinesOutdated = false;
+	outletCurveSpline.clear();
+	if (!outletData.m_t.empty()) {
 		try {
-			outletCurveSpline.setValues(xvals,yvals);
+			outletCurveSpline.setValues(outletData.m_t, outletData.m_values[0]);
 		}
 		catch (...) {
 			outletCurveSpline.clear();
 		}
 	}
-	f.close();
-	QFile f2(ui.lineEditInletData->text());
-	f2.open(QIODevice::ReadOnly | QIODevice::Text);
-	QTextStream stream2(&f2);
+	probeCurveSplines.clear();
+	for (unsigned int j=0; j<probeT.size(); ++j) {
+		probeCurveSplines.push_back(IBK::LinearSpline());
+		try {
+			probeCurveSplines.back().setValues(probeT[j], probeC[j]);
+		}
+		catch (...) {
+			probeCurveSplines.back().clear();
+		}
+	}
+}
+
+void CXTSimFit::loadDataFiles() {
+	// tell series that we don't have any data momentarily
+	inletCurve.series->clear();
+
+	// first outlet data: time, outlet concentration and further columns with the probe concentrations
+	try {
+		outletData.read(ui.lineEditOutletData->text().toLocal8Bit().constData());
+	}
+	catch (std::exception & ex) {
+		qDebug() << ex.what();
+	}
+	qDebug() << "Outlet data points = " << outletData.m_t.size() << ", probe columns = "
+			 << (outletData.m_values.empty() ? 0 : (int)outletData.m_values.size() - 1);
+	updateOutletCurves(0);
 
-	// read second section
-	x.clear();
-	y.clear();
+	// inlet data: time and inlet concentration
+	DataImporter inletData;
+	inletData.m_valueColumns.push_back(1);
+	try {
+		inletData.read(ui.lineEditInletData->text().toLocal8Bit().constData());
+	}
+	catch (std::exception & ex) {
+		qDebug() << ex.what();
+	}
 	inletCurveSpline.clear();
-	do {
-		line = stream2.readLine();
-		if (line.isEmpty()) break;
-		if (line[0] == '#') continue;
-		QTextStream linestrm(&line);
-		double t, val;
-		linestrm >> t >> val;
-		if (linestrm.status() != QTextStream::Ok) break;
-		x.append(t);
-		y.append(val);
-	} while (!line.isNull());
-	qDebug() << "Inlet data points = " << x.size();
-
-	if (!x.isEmpty()) {
-		inletCurve.series->setData(x,y);
-
-		std::vector<double> xvals(x.begin(), x.end());
-		std::vector<double> yvals(y.begin(), y.end());
+	qDebug() << "Inlet data points = " << inletData.m_t.size();
+
+	if (!inletData.m_t.empty()) {
+		inletCurve.series->setData(toList(inletData.m_t), toList(inletData.m_values[0]));
+
 		try {
-			inletCurveSpline.setValues(xvals,yvals);
+			inletCurveSpline.setValues(inletData.m_t, inletData.m_values[0]);
 		}
 		catch (...) {
 			inletCurveSpline.clear();
@@ -363,8 +487,105 @@ bool CXTSimFit::getInput(SolverInput & input, bool silent) {
 			QMessageBox::information(this, PROGRAM_NAME, tr("Invalid input for optimizer tolerance!"));
 		return false;
 	}
+	input.reducedOrderFit = ui.checkBoxReducedOrderFit->isChecked();
 
 	input.n = ui.spinBoxBedElements->value();
+	input.activeWindow = ui.checkBoxActiveWindow->isChecked();
+	input.engine = static_cast<SolverInput::engine_t>(ui.comboBoxEngine->currentIndex());
+	input.linearSolver = static_cast<SolverInput::linearSolver_t>(ui.comboBoxLinearSolver->currentIndex());
+	input.integrator = static_cast<SolverInput::integrator_t>(ui.comboBoxIntegrator->currentIndex());
+	input.pararealSlices = ui.spinBoxPararealSlices->value();
+	input.threads = ui.spinBoxThreads->value();
+	input.mappedProfiles = ui.checkBoxMappedProfiles->isChecked();
+	input.profileCompression = static_cast<SolverInput::profileCompression_t>(ui.comboBoxProfileCompression->currentIndex());
+	input.profileChange = ui.lineEditProfileChange->text().toDouble(&ok);
+	if (!ok || input.profileChange < 0) {
+		if (!silent)
+			QMessageBox::information(this, PROGRAM_NAME, tr("Invalid input for profile change limit!"));
+		return false;
+	}
+	input.maxProfiles = ui.spinBoxMaxProfiles->value();
+	input.steadyState = static_cast<SolverInput::steadyState_t>(ui.comboBoxSteadyState->currentIndex());
+	if (input.steadyState == SolverInput::SS_TERMINATION && input.engine != SolverInput::ENGINE_CVODE) {
+		if (!silent)
+			QMessageBox::information(this, PROGRAM_NAME, tr("The steady-state termination check requires the CVODE engine!"));
+		return false;
+	}
+	if (input.steadyState == SolverInput::SS_DIRECT && input.pararealSlices > 1) {
+		if (!silent)
+			QMessageBox::information(this, PROGRAM_NAME, tr("Parallel-in-time integration requires a transient simulation!"));
+		return false;
+	}
+	input.cyclePeriod = ui.lineEditCyclePeriod->text().toDouble(&ok)*3600;
+	if (!ok || input.cyclePeriod < 0) {
+		if (!silent)
+			QMessageBox::information(this, PROGRAM_NAME, tr("Invalid input for inlet cycle period!"));
+		return false;
+	}
+	input.breakthroughFractions.clear();
+	QStringList fractions = ui.lineEditBreakthroughFractions->text().split(' ', QString::SkipEmptyParts);
+	for (int i=0; i<fractions.count(); ++i) {
+		double f = fractions[i].toDouble(&ok);
+		if (!ok || f <= 0 || f > 1) {
+			if (!silent)
+				QMessageBox::information(this, PROGRAM_NAME, tr("Breakthrough fractions must be in the range (0,1]!"));
+			return false;
+		}
+		input.breakthroughFractions.push_back(f);
+	}
+	input.probePositions.clear();
+	QStringList positions = ui.lineEditProbePositions->text().split(' ', QString::SkipEmptyParts);
+	for (int i=0; i<positions.count(); ++i) {
+		double x = positions[i].toDouble(&ok);
+		if (!ok || x < 0 || x > input.L) {
+			if (!silent)
+				QMessageBox::information(this, PROGRAM_NAME, tr("Probe positions must be in the range [0,L]!"));
+			return false;
+		}
+		input.probePositions.push_back(x);
+	}
+	input.probeWeights.clear();
+	QStringList weights = ui.lineEditProbeWeights->text().split(' ', QString::SkipEmptyParts);
+	for (int i=0; i<weights.count(); ++i) {
+		double w = weights[i].toDouble(&ok);
+		if (!ok || w < 0) {
+			if (!silent)
+				QMessageBox::information(this, PROGRAM_NAME, tr("Invalid input for probe weights!"));
+			return false;
+		}
+		input.probeWeights.push_back(w);
+	}
+	input.stopAtBreakthrough = ui.checkBoxStopAtBreakthrough->isChecked();
+	if (input.steadyState == SolverInput::SS_CYCLIC || input.steadyState == SolverInput::SS_CYCLIC_DIRECT) {
+		if (input.cyclePeriod == 0 || input.engine != SolverInput::ENGINE_CVODE || input.pararealSlices > 1) {
+			if (!silent)
+				QMessageBox::information(this, PROGRAM_NAME, tr("The cyclic steady state requires an inlet cycle period and the CVODE engine without parallel-in-time integration!"));
+			return false;
+		}
+	}
+	if (input.pararealSlices > 1 && input.engine != SolverInput::ENGINE_CVODE) {
+		if (!silent)
+			QMessageBox::information(this, PROGRAM_NAME, tr("Parallel-in-time integration requires the CVODE engine!"));
+		return false;
+	}
+	if (input.engine == SolverInput::ENGINE_CHARACTERISTIC && input.D != 0) {
+		if (!silent)
+			QMessageBox::information(this, PROGRAM_NAME, tr("The characteristics engine requires a zero diffusion coefficient!"));
+		return false;
+	}
+	if (input.engine == SolverInput::ENGINE_MULTIRATE) {
+		if (input.model != SolverInput::PLUS_EXCHANGE) {
+			if (!silent)
+				QMessageBox::information(this, PROGRAM_NAME, tr("The multirate engine requires the mass transfer model!"));
+			return false;
+		}
+		input.macroDt = ui.lineEditMacroDt->text().toDouble(&ok);
+		if (!ok || input.macroDt <= 0) {
+			if (!silent)
+				QMessageBox::information(this, PROGRAM_NAME, tr("Invalid input for macro time step!"));
+			return false;
+		}
+	}
 	return true;
 }
 
@@ -410,11 +631,98 @@ void CXTSimFit::calculatePartitionCoefficient() {
 void CXTSimFit::updateCurve(bool add_series) {
 	SolverInput input;
 	if (!getInput(input, false)) return;
-	// create solver object
+	updateOutletSplines();
+	input.tEnd = input.tEnd * 3600;
+
+	SolverResults res;
+	if (input.pararealSlices > 1) {
+		// parallel-in-time integration
+		Parareal parareal(input.pararealSlices);
+		try {
+			std::cout << "Parareal solver started...";
+			parareal.run(input);
+			qDebug() << "Done after" << parareal.m_iterations << "iterations.";
+		}
+		catch (std::exception& ex) {
+			QMessageBox::critical(this, PROGRAM_NAME, QString::fromLatin1(ex.what()) );
+			return;
+		}
+		res.input = input;
+		res.profiles = parareal.m_profiles;
+		res.breakthroughT = parareal.m_breakthroughT;
+		res.data.setValues(parareal.m_outletT, parareal.m_outletC);
+		res.calculateRSquare(outletCurveSpline);
+		solverRunCompleted(add_series, res);
+		return;
+	}
+
+	if (input.steadyState == SolverInput::SS_CYCLIC || input.steadyState == SolverInput::SS_CYCLIC_DIRECT) {
+		// cyclic steady state, results cover one period
+		CyclicSteadyState css;
+		try {
+			std::cout << "Cyclic steady-state solver started...";
+			if (input.steadyState == SolverInput::SS_CYCLIC) {
+				css.run(input);
+				qDebug() << "Done after" << css.m_periodIntegrations << "period integrations ("
+						 << css.m_newtonIterations << "Newton iterations," << css.m_linearIterations << "linear iterations).";
+			}
+			else {
+				css.runCycling(input);
+				qDebug() << "Done after" << css.m_periodIntegrations << "period integrations (direct cycling).";
+			}
+		}
+		catch (std::exception& ex) {
+			QMessageBox::critical(this, PROGRAM_NAME, QString::fromLatin1(ex.what()) );
+			return;
+		}
+		res.input = input;
+		res.input.tEnd = input.cyclePeriod;
+		res.profiles = css.m_profiles;
+		res.data.setValues(css.m_outletT, css.m_outletC);
+		res.calculateRSquare(outletCurveSpline);
+		solverRunCompleted(add_series, res);
+		return;
+	}
+
+	// results of an identical earlier run are taken from the cache (entries of fits have no profiles)
+	ResultFile cached;
+	if (resultCache.find(input, cached) && cached.size() > 0) {
+		std::shared_ptr<ProfileStore> store;
+		try {
+			store = Solver::newProfileStore(input);
+			for (unsigned int k=0; k<cached.size(); ++k)
+				store->append(cached.t()[k], cached.cc(k), cached.sc(k));
+		}
+		catch (std::exception& ex) {
+			QMessageBox::critical(this, PROGRAM_NAME, QString::fromLatin1(ex.what()) );
+			return;
+		}
+		qDebug() << "Results taken from cache.";
+		res.input = input;
+		res.profiles = store;
+		res.breakthroughT = cached.breakthroughT();
+		res.data.setValues(std::vector<double>(cached.outletT(), cached.outletT() + cached.outletSize()),
+						   std::vector<double>(cached.outletC(), cached.outletC() + cached.outletSize()));
+		res.probes.resize(cached.probeCount());
+		std::vector<double> probeT(cached.probeT(), cached.probeT() + cached.probeSize());
+		for (unsigned int j=0; j<cached.probeCount(); ++j)
+			res.probes[j].setValues(probeT, std::vector<double>(cached.probeC(j), cached.probeC(j) + cached.probeSize()));
+		res.calculateRSquare(outletCurveSpline);
+		solverRunCompleted(add_series, res);
+		return;
+	}
+
+	// create solver object, profiles, probes and outlet moments are recorded for the curve
 	Solver solv;
+	ProfileRecorder profiles;
+	ProbeSampler probes(input);
+	MomentAccumulator moments;
 	try {
-		input.tEnd = input.tEnd * 3600;
 		solv.init(input);
+		profiles.init(Solver::newProfileStore(input), input);
+		solv.addObserver(&profiles);
+		solv.addObserver(&probes);
+		solv.addObserver(&moments);
 	}
 	catch (std::exception& ex) {
 		QMessageBox::critical(this, PROGRAM_NAME, QString::fromLatin1(ex.what()) );
@@ -425,19 +733,30 @@ void CXTSimFit::updateCurve(bool add_series) {
 		std::cout << "Solver started...";
 		solv.run();
 		qDebug() << "Done.";
+		if (input.engine == SolverInput::ENGINE_CVODE)
+			solv.statistics().write(std::cout);
+		moments.write(std::cout);
 	}
 	catch (std::exception& ex) {
 		QMessageBox::critical(this, PROGRAM_NAME, QString::fromLatin1(ex.what()) );
 		return;
 	}
 
+	try {
+		resultCache.store(input, solv, profiles.store().get(), &probes);
+	}
+	catch (std::exception& ex) {
+		qDebug() << "Warning:" << ex.what();
+	}
+
 	// store results
-	SolverResults res;
 	res.input = solv.input();
-	res.ccProfiles = solv.ccProfile();
-	res.scProfiles = solv.scProfile();
-	res.tProfiles = solv.tProfile();
+	res.profiles = profiles.store();
+	res.breakthroughT = solv.m_breakthroughT;
 	res.data.setValues(solv.m_outletT, solv.m_outletC); // should never throw, or?
+	res.probes.resize(probes.size());
+	for (unsigned int j=0; j<probes.size(); ++j)
+		res.probes[j].setValues(probes.t(), probes.c(j));
 	res.calculateRSquare(outletCurveSpline);
 	solverRunCompleted(add_series, res);
 }
@@ -462,6 +781,29 @@ void CXTSimFit::on_pushButtonBrowseOutletData_clicked() {
 	}
 }
 
+void CXTSimFit::on_checkBoxFollowOutletData_toggled(bool checked) {
+	if (checked)
+		outletDataTimer.start();
+	else
+		outletDataTimer.stop();
+}
+
+void CXTSimFit::followOutletData() {
+	size_t rows = outletData.m_t.size();
+	size_t first;
+	try {
+		first = outletData.readAppended();
+	}
+	catch (std::exception & ex) {
+		qDebug() << ex.what();
+		return;
+	}
+	if (first == rows && outletData.m_t.size() == rows)
+		return;
+	updateOutletCurves(first);
+	ui.chart->updateChart();
+}
+
 void CXTSimFit::on_lineEditq_textChanged(const QString & text) {
 	bool ok;
 	double flowrate = ui.lineEditq->text().toDouble(&ok);
@@ -488,6 +830,75 @@ void CXTSimFit::on_pushButtonAddFit_clicked() {
 	updateCurve(true);
 }
 
+void CXTSimFit::on_pushButtonGridStudy_clicked() {
+	SolverInput input;
+	if (!getInput(input, false)) return;
+	input.tEnd = input.tEnd * 3600;
+	if (input.pararealSlices > 1 || input.steadyState == SolverInput::SS_CYCLIC || input.steadyState == SolverInput::SS_CYCLIC_DIRECT) {
+		QMessageBox::information(this, PROGRAM_NAME, tr("The grid study requires a transient simulation without parallel-in-time integration!"));
+		return;
+	}
+
+	bool ok;
+	int levels = QInputDialog::getInt(this, tr("Grid study"), tr("Number of grids (starting with %1 elements):").arg(input.n),
+									  3, 3, 8, 1, &ok);
+	if (!ok) return;
+	int ratio = QInputDialog::getInt(this, tr("Grid study"), tr("Refinement ratio between grids:"), 2, 2, 10, 1, &ok);
+	if (!ok) return;
+
+	gridStudy.m_levels = levels;
+	gridStudy.m_ratio = ratio;
+	gridStudyError.clear();
+	ui.pushButtonGridStudy->setEnabled(false);
+	std::cout << "Grid study started..." << std::endl;
+	// all grids run concurrently in the background, the GUI remains responsive
+	connect(&gridStudyWatcher, SIGNAL(finished()), this, SLOT(gridStudyFinished()), Qt::UniqueConnection);
+	gridStudyWatcher.setFuture(QtConcurrent::run([this, input]() {
+		try {
+			gridStudy.run(input);
+		}
+		catch (std::exception & ex) {
+			gridStudyError = QString::fromLatin1(ex.what());
+		}
+	}));
+}
+
+void CXTSimFit::gridStudyFinished() {
+	ui.pushButtonGridStudy->setEnabled(true);
+	if (!gridStudyError.isEmpty()) {
+		QMessageBox::critical(this, PROGRAM_NAME, gridStudyError);
+		return;
+	}
+	qDebug() << "Done.";
+
+	updateOutletSplines();
+	for (unsigned int i=0; i<gridStudy.m_results.size(); ++i) {
+		SolverResults & res = gridStudy.m_results[i];
+		res.calculateRSquare(outletCurveSpline);
+		addCurve(QString("n=%1, R2=%2").arg(res.input.n).arg(res.R2), res.data.x(), res.data.y(), res);
+	}
+	unsigned int nFinest = gridStudy.m_results.back().input.n;
+
+	if (gridStudy.m_order == 0) {
+		QMessageBox::information(this, PROGRAM_NAME, tr("The outlet curves do not converge monotonically with grid refinement, "
+			"no Richardson extrapolation is possible. Try finer grids."));
+		return;
+	}
+	double maxError = *std::max_element(gridStudy.m_errorEstimate.begin(), gridStudy.m_errorEstimate.end());
+	addCurve(QString("Richardson extrapolation, observed order %1, max. error estimate %2")
+			 .arg(gridStudy.m_order, 0, 'g', 3).arg(maxError, 0, 'g', 3),
+			 gridStudy.m_outletT, gridStudy.m_extrapolatedC);
+	// error band of the finest grid solution
+	std::vector<double> lower, upper;
+	const std::vector<double> & finest = gridStudy.m_results.back().data.y();
+	for (unsigned int k=0; k<gridStudy.m_outletT.size(); ++k) {
+		lower.push_back(finest[k] - gridStudy.m_errorEstimate[k]);
+		upper.push_back(finest[k] + gridStudy.m_errorEstimate[k]);
+	}
+	addCurve(QString("n=%1 - error estimate").arg(nFinest), gridStudy.m_outletT, lower);
+	addCurve(QString("n=%1 + error estimate").arg(nFinest), gridStudy.m_outletT, upper);
+}
+
 void CXTSimFit::on_pushButtonOptimize_clicked() {
 	SolverInput input;
 	if (!getInput(input, false)) return;
@@ -540,8 +951,22 @@ void CXTSimFit::on_pushButtonOptimize_clicked() {
 		return;
 	}
 
-	LevMarOptimizer f(input, outletCurveSpline.x(), outletCurveSpline.y());
+	// the outlet series and the measured series of the defined probe positions are fitted together
+	updateOutletSplines();
+	std::vector<LevMarOptimizer::MeasuredSeries> series;
+	series.push_back(LevMarOptimizer::MeasuredSeries(-1, outletCurveSpline.x(), outletCurveSpline.y()));
+	for (unsigned int j=0; j<probeCurveSplines.size() && j<input.probePositions.size(); ++j) {
+		if (!probeCurveSplines[j].valid())
+			continue;
+		double w = (j < input.probeWeights.size()) ? input.probeWeights[j] : 1;
+		series.push_back(LevMarOptimizer::MeasuredSeries(j, probeCurveSplines[j].x(), probeCurveSplines[j].y(), w));
+	}
+	if (series.size() > 1)
+		qDebug() << "Fitting outlet and" << series.size() - 1 << "probe series.";
+
+	LevMarOptimizer f(input, series);
 	f.optimizablePars = optimizableParams;
+	f.m_cache = &resultCache;
 	try {
 		f.optimize(par);
 	}
@@ -660,10 +1085,37 @@ void CXTSimFit::on_pushButtonConfigQt_clicked() {
 
 
 void CXTSimFit::on_pushButtonProfiles_clicked() {
-	if (lastResults.data.empty()) {
+	// profiles of the selected curve, without selection those of the last calculated curve
+	int idx = ui.listWidgetCurveInfo->currentRow();
+	if (idx < 0 || idx >= curveResults.size()) {
+		idx = curveResults.size() - 1;
+		while (idx >= 0 && !curveResults[idx].profiles)
+			--idx;
+	}
+	if (idx < 0 || curveResults[idx].data.empty()) {
 		QMessageBox::critical(this, PROGRAM_NAME, tr("A valid simulation run is needed before you can expect profiles. Please update the curve first and fix any error messages you may get!"));
 		return;
 	}
-	InspectProfileDialog dlg(this, lastResults);
+	if (!curveResults[idx].profiles || curveResults[idx].profiles->empty()) {
+		QMessageBox::information(this, PROGRAM_NAME, tr("No profiles are available for the selected curve."));
+		return;
+	}
+	InspectProfileDialog dlg(this, curveResults[idx]);
 	dlg.exec();
 }
+
+void CXTSimFit::on_pushButtonExportInput_clicked() {
+	SolverInput input;
+	if (!getInput(input, false))
+		return;
+	input.tEnd = input.tEnd * 3600;
+	QString fname = QFileDialog::getSaveFileName(this, tr("Export solver input"), QString(), tr("Solver input files (*.input);;All files (*.*)"));
+	if (fname.isEmpty())
+		return;
+	try {
+		input.write(fname.toLocal8Bit().constData());
+	}
+	catch (std::exception& ex) {
+		QMessageBox::critical(this, PROGRAM_NAME, QString::fromLatin1(ex.what()) );
+	}
+}
@@ -3,11 +3,16 @@
 
 #include <QDialog>
 #include <QList>
+#include <QFutureWatcher>
+#include <QTimer>
 
 #include "ui_cxtsimfit.h"
 
 #include "curvedata.h"
 #include "solverresults.h"
+#include "gridstudy.h"
+#include "resultcache.h"
+#include "dataimporter.h"
 
 #include <IBK_LinearSpline.h>
 
@@ -22,6 +27,8 @@ public:
 
 	IBK::LinearSpline		outletCurveSpline;
 	IBK::LinearSpline		inletCurveSpline;
+	/// Measured concentrations at the probe positions (further columns of the outlet data file).
+	std::vector<IBK::LinearSpline>	probeCurveSplines;
 
 public slots:
 	void solverRunCompleted(bool add_series, const SolverResults & res);
@@ -29,6 +36,14 @@ public slots:
 private:
 	void loadDataFiles();
 
+	/// Updates the outlet and probe curves for the rows of outletData from first on (0 after read(),
+	/// the index returned by readAppended() otherwise), the splines are only marked as outdated.
+	void updateOutletCurves(size_t first);
+
+	/// Rebuilds outletCurveSpline and probeCurveSplines if outletData has changed since the last call,
+	/// called before curve updates and fits.
+	void updateOutletSplines();
+
 	/// Grabs the input data from the widgets and stores it in 'input'.
 	/// If 'silent' is false, the function pops up error messages in case of invalid input.
 	/// if 'silent' is true, the function just returns with false on error.
@@ -45,27 +60,65 @@ private:
 	/// Calculates the partition coefficient from measured data and input data.
 	void calculatePartitionCoefficient();
 
+	/// Adds a new curve with the given description to the chart and the list of curves.
+	/// res holds the solver results for the curve (empty for derived curves like error bands).
+	void addCurve(const QString & desc, const std::vector<double> & x, const std::vector<double> & y,
+				  const SolverResults & res = SolverResults());
+
+	/// Sets the data of curve idx (without updating the chart).
+	void setCurveData(int idx, const std::vector<double> & x, const std::vector<double> & y);
+
 	Ui::CXTSimFit ui;
 
 	CurveData				inletCurve;
 	CurveData				outletCurve;
+	QList<CurveData>		probeCurves;	///< Measured probe concentrations, one curve per column.
+
+	/// Outlet data file, kept to read the rows appended by a running experiment.
+	DataImporter			outletData;
+	/// Polls the outlet data file for appended rows while 'Follow' is checked.
+	QTimer					outletDataTimer;
+	/// Time points in h of the rows of outletData with a value in each probe column (the probe curves
+	/// point into these vectors).
+	std::vector<std::vector<double> >	probeT;
+	/// Probe concentrations in kg/m3 at the time points in probeT.
+	std::vector<std::vector<double> >	probeC;
+	/// Row of outletData of each value in probeT.
+	std::vector<std::vector<size_t> >	probeRows;
+	/// True if outletData has changed since the splines were built (see updateOutletSplines()).
+	bool					outletSplinesOutdated;
 
 	double					meanInletC;
 
 	QList<CurveData>		curves;
+	/// Number of curves added by the last solver run (outlet and probe curves), updated together.
+	int						lastRunCurves;
+	/// Solver results of each curve in 'curves', the profiles are shared with the solver runs.
+	QList<SolverResults>	curveResults;
+
+	GridStudy				gridStudy;			///< Grid convergence study, runs in the background.
+	QFutureWatcher<void>	gridStudyWatcher;	///< Signals the end of the grid study.
+	QString					gridStudyError;		///< Error message of the last grid study, empty on success.
 
-	SolverResults			lastResults;	///< Caches results from the last solver run.
+	/// Results of previous runs (also of other sessions and processes), consulted by updateCurve() and fits.
+	ResultCache				resultCache;
 
 private slots:
 	void on_pushButtonProfiles_clicked();
+	void on_pushButtonExportInput_clicked();
 	void on_pushButtonConfigQt_clicked();
 	void on_pushButtonAbout_clicked();
 	void on_checkBoxInletC_toggled(bool);
 	void on_pushButtonBrowseOutletData_clicked();
+	void on_checkBoxFollowOutletData_toggled(bool);
+	/// Adds the rows appended to the outlet data file to the outlet and probe curves.
+	void followOutletData();
 	void on_pushButtonBrowseInletData_clicked();
 	void on_comboBoxModel_currentIndexChanged(int index);
 	void on_pushButtonOptimize_clicked();
 	void on_pushButtonAddFit_clicked();
+	void on_pushButtonGridStudy_clicked();
+	void gridStudyFinished();
 	void on_pushButtonUpdateFit_clicked();
 	void on_pushButtonQuit_clicked();
 	void on_lineEditq_textChanged(const QString & text);
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+
+#include <IBK_ArgParser.h>
+#include <IBK_Exception.h>
+#include <IBK_StringUtils.h>
+
+#include "workprecision.h"
+
+/// Converts a comma-separated list of numbers from the command line.
+static std::vector<double> sweepValues(const std::string & str) {
+	std::string values = str;
+	std::replace(values.begin(), values.end(), ',', ' ');
+	std::vector<double> vec;
+	IBK::string2valueVector(values, vec);
+	return vec;
+}
+
+
+/// Command line tool for the work-precision study of a solver input file (see WorkPrecision).
+int main(int argc, char * argv[]) {
+	IBK::ArgParser args;
+	args.setAppName("CXTSimFitBench");
+	args.addOption(0, "n", "Comma-separated list of element numbers.", "n1,n2,...", "");
+	args.addOption(0, "relTol", "Comma-separated list of relative tolerances.", "tol1,tol2,...", "");
+	args.addOption(0, "absTol", "Comma-separated list of absolute tolerances.", "tol1,tol2,...", "");
+	args.addOption(0, "maxDt", "Comma-separated list of maximum time steps in s.", "dt1,dt2,...", "");
+	args.addOption('e', "error", "Requested maximum outlet error relative to the feed concentration.", "error", "1e-3");
+	args.addOption('t', "threads", "Number of concurrent runs, 0 = number of cores (use 1 for reliable timings).", "threads", "0");
+	args.addOption('r', "repeats", "Number of runs per sweep point, the fastest run counts.", "repeats", "1");
+	args.addOption('o', "output", "Base name of output files (default: input file name).", "basename", "");
+	args.parse(argc, argv);
+	if (args.flagEnabled("help") || args.args().size() != 2) {
+		std::cout << "Work-precision study for a CXTSimFit solver input file.\n"
+				  << "Writes <basename>.wp.tsv (table), <basename>.wp.plt (gnuplot script) and\n"
+				  << "<basename>.recommended.input (cheapest setting meeting the requested error).\n\n";
+		args.printHelp(std::cout);
+		return args.flagEnabled("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	try {
+		std::string inputFile = args.args()[1];
+		SolverInput input;
+		input.read(inputFile);
+
+		WorkPrecision wp(IBK::string2val<unsigned int>(args.option('t')));
+		std::vector<double> n = sweepValues(args.option("n"));
+		for (unsigned int i=0; i<n.size(); ++i)
+			wp.m_n.push_back(static_cast<unsigned int>(n[i]));
+		wp.m_relTol = sweepValues(args.option("relTol"));
+		wp.m_absTol = sweepValues(args.option("absTol"));
+		wp.m_maxDt = sweepValues(args.option("maxDt"));
+		wp.m_repeats = IBK::string2val<unsigned int>(args.option('r'));
+		double maxError = IBK::string2val<double>(args.option('e'));
+
+		std::string basename = args.option('o');
+		if (basename.empty()) {
+			basename = inputFile;
+			std::string::size_type pos = basename.rfind('.');
+			if (pos != std::string::npos && basename.find_first_of("/\\", pos) == std::string::npos)
+				basename.erase(pos);
+		}
+
+		wp.run(input);
+
+		wp.writeTable(std::cout);
+		std::ofstream table((basename + ".wp.tsv").c_str());
+		wp.writeTable(table);
+		std::ofstream plot((basename + ".wp.plt").c_str());
+		wp.writeGnuplot(plot, basename + ".wp.tsv", basename + ".wp.png", maxError);
+
+		int best = wp.recommendation(maxError);
+		if (best == -1) {
+			std::cout << "\nNo setting meets the requested error of " << maxError << ".\n";
+			return EXIT_FAILURE;
+		}
+		const WorkPrecision::Point & p = wp.m_points[best];
+		std::cout << "\nRecommended: n = " << p.n << ", relTol = " << p.relTol << ", absTol = " << p.absTol
+				  << ", maxDt = " << p.maxDt << " s (error " << p.error << ", " << p.wallTime << " s)\n";
+		wp.pointInput(best).write(basename + ".recommended.input");
+	}
+	catch (IBK::Exception & ex) {
+		ex.writeMsgStackToError();
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include <IBK_ArgParser.h>
+#include <IBK_Exception.h>
+#include <IBK_StringUtils.h>
+#include <IBK_StopWatch.h>
+#include <IBK_Path.h>
+#include <IBK_Unit.h>
+#include <IBK_UnitList.h>
+
+#include "dataimporter.h"
+
+/// Converts a comma-separated list of numbers from the command line.
+static std::vector<double> sweepValues(const std::string & str) {
+	std::string values = str;
+	std::replace(values.begin(), values.end(), ',', ' ');
+	std::vector<double> vec;
+	IBK::string2valueVector(values, vec);
+	return vec;
+}
+
+
+/// Benchmark of the data importer (see DataImporter) against line-by-line reading with streams (like
+/// the previous loader of the user interface), fastest of repeats runs each. The importer runs with one
+/// thread and with the given number of threads, the results of all readers are compared.
+static void importBenchmark(const std::string & filename, const std::vector<double> & columns, const std::string & timeUnit,
+							unsigned int threads, unsigned int repeats, std::ostream & out)
+{
+	FUNCID(importBenchmark);
+	DataImporter importer;
+	for (unsigned int j=0; j<columns.size(); ++j)
+		importer.m_valueColumns.push_back(static_cast<unsigned int>(columns[j]));
+	importer.m_timeUnit = timeUnit;
+
+	double timeFactor = 1;
+	IBK::UnitList::instance().convert(IBK::Unit(timeUnit), IBK::Unit("h"), timeFactor);
+
+	// reference: one line after another, all columns as in the previous loader
+	double timeStream = std::numeric_limits<double>::max();
+	std::vector<std::vector<double> > rows;
+	for (unsigned int r=0; r<repeats; ++r) {
+		IBK::StopWatch w;
+		std::ifstream in(filename.c_str());
+		if (!in)
+			throw IBK::Exception(IBK::FormatString("Cannot open data file '%1'.").arg(filename), FUNC_ID);
+		rows.clear();
+		std::string line;
+		while (std::getline(in, line)) {
+			if (line.empty() || line == "\r")
+				break;
+			if (line[0] == '#')
+				continue;
+			std::istringstream linestrm(line);
+			std::vector<double> row;
+			double val;
+			while (linestrm >> val)
+				row.push_back(val);
+			if (row.size() < 2)
+				break;
+			rows.push_back(row);
+		}
+		timeStream = std::min(timeStream, w.stop()*1e-3);
+	}
+
+	out << "Reader\tThreads\tTime [s]\tRows/s\tMB/s\tMax. deviation\n";
+	double mb = IBK::Path(filename).fileSize()/1048576.0;
+	out << "stream\t1\t" << timeStream << "\t" << rows.size()/timeStream << "\t" << mb/timeStream << "\t0\n";
+	unsigned int threadCounts[2] = { 1, threads };
+	for (unsigned int i=0; i<2; ++i) {
+		importer.m_threads = threadCounts[i];
+		double time = std::numeric_limits<double>::max();
+		for (unsigned int r=0; r<repeats; ++r) {
+			IBK::StopWatch w;
+			importer.read(filename);
+			time = std::min(time, w.stop()*1e-3);
+		}
+		// compare with the streams
+		double deviation = (importer.m_t.size() == rows.size()) ? 0 : std::numeric_limits<double>::infinity();
+		for (unsigned int k=0; k<rows.size() && deviation == 0; ++k) {
+			deviation = std::max(deviation, std::fabs(importer.m_t[k] - rows[k][0]*timeFactor));
+			for (unsigned int j=0; j<importer.m_values.size(); ++j) {
+				unsigned int col = columns.empty() ? j + 1 : static_cast<unsigned int>(columns[j]);
+				if (col < rows[k].size())
+					deviation = std::max(deviation, std::fabs(importer.m_values[j][k] - rows[k][col]));
+			}
+		}
+		out << "import\t" << importer.m_threads << "\t" << time << "\t" << importer.m_t.size()/time << "\t"
+			<< mb/time << "\t" << deviation << "\n";
+		if (threads == 1)
+			break;
+	}
+}
+
+
+/// Command line tool for the benchmark of the data importer.
+int main(int argc, char * argv[]) {
+	IBK::ArgParser args;
+	args.setAppName("CXTSimFitImportBench");
+	args.addOption('t', "threads", "Number of importer threads, 0 = number of cores.", "threads", "0");
+	args.addOption('r', "repeats", "Number of runs per reader, the fastest run counts.", "repeats", "1");
+	args.addOption(0, "columns", "Comma-separated list of value columns (0 = first column), "
+				   "default: all columns after the first.", "c1,c2,...", "");
+	args.addOption(0, "timeUnit", "Unit of the time points.", "unit", "h");
+	args.parse(argc, argv);
+	if (args.flagEnabled("help") || args.args().size() != 2) {
+		std::cout << "Compares the data importer with line-by-line reading for a measured data file.\n\n";
+		args.printHelp(std::cout);
+		return args.flagEnabled("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	try {
+		unsigned int threads = IBK::string2val<unsigned int>(args.option('t'));
+		if (threads == 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		importBenchmark(args.args()[1], sweepValues(args.option("columns")), args.option("timeUnit"), threads,
+						IBK::string2val<unsigned int>(args.option('r')), std::cout);
+	}
+	catch (IBK::Exception & ex) {
+		ex.writeMsgStackToError();
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+
+#include <IBK_ArgParser.h>
+#include <IBK_Exception.h>
+#include <IBK_StringUtils.h>
+#include <IBK_StopWatch.h>
+
+#include "solver.h"
+#include "profilerecorder.h"
+#include "resultfile.h"
+#include "resultcache.h"
+
+/// Converts a comma-separated list of numbers from the command line.
+static std::vector<double> sweepValues(const std::string & str) {
+	std::string values = str;
+	std::replace(values.begin(), values.end(), ',', ' ');
+	std::vector<double> vec;
+	IBK::string2valueVector(values, vec);
+	return vec;
+}
+
+
+/// Strong-scaling study of the threaded execution mode (SolverInput::threads): the input is simulated
+/// with each number of threads (fastest of repeats runs) and wall time, speedup and parallel efficiency
+/// relative to the first entry are written as table. The last column shows the maximum deviation of
+/// the outlet concentrations from the first run, which is zero unless the vector reductions differ.
+static void strongScaling(const SolverInput & input, const std::vector<double> & threads, unsigned int repeats,
+						  std::ostream & out)
+{
+	SolverInput in = input;
+	in.pararealSlices = 1;
+	in.stopAtBreakthrough = false;
+	in.outputN = std::numeric_limits<unsigned int>::max();
+
+	out << "# n = " << in.n << "\n";
+	out << "# threads\twall time [s]\tspeedup [-]\tefficiency [-]\tmax. deviation [kg/m3]\n";
+	double wallTime1 = 0;
+	std::vector<double> outletC1;
+	for (unsigned int i=0; i<threads.size(); ++i) {
+		in.threads = static_cast<unsigned int>(threads[i]);
+		double wallTime = std::numeric_limits<double>::max();
+		std::vector<double> outletC;
+		for (unsigned int r=0; r<std::max(1u, repeats); ++r) {
+			IBK::StopWatch watch;
+			Solver solver;
+			solver.init(in);
+			solver.run();
+			wallTime = std::min(wallTime, watch.stop()*1e-3);
+			outletC = solver.m_outletC;
+		}
+		if (i == 0) {
+			wallTime1 = wallTime;
+			outletC1 = outletC;
+		}
+		double deviation = 0;
+		for (unsigned int k=0; k<std::min(outletC.size(), outletC1.size()); ++k)
+			deviation = std::max(deviation, std::fabs(outletC[k] - outletC1[k]));
+		double speedup = wallTime1/wallTime;
+		out << in.threads << "\t" << wallTime << "\t" << speedup << "\t"
+			<< speedup*threads[0]/in.threads << "\t" << deviation << "\n";
+	}
+}
+
+
+/// Single run of the input with checkpoints (see Solver::setCheckpoints()), optionally continued from
+/// a checkpoint of a previous run, and/or with a result file (see ResultFileWriter). The outlet series
+/// is written as table. Without checkpoints and result file, the results are taken from the cache if
+/// possible; the results of complete runs are stored in the cache.
+static void singleRun(const SolverInput & input, const std::string & checkpointFile, double checkpointDt,
+					  const std::string & restartFile, const std::string & resultFile, const ResultCache & cache,
+					  std::ostream & out)
+{
+	SolverInput in = input;
+	in.pararealSlices = 1;
+
+	ResultFile cached;
+	if (checkpointFile.empty() && restartFile.empty() && resultFile.empty() && cache.find(in, cached)) {
+		std::cout << "Results taken from cache.\n";
+		cached.statistics().write(std::cout);
+		out << "# t [h]\tc [kg/m3]\n";
+		for (unsigned int k=0; k<cached.outletSize(); ++k)
+			out << cached.outletT()[k] << "\t" << cached.outletC()[k] << "\n";
+		return;
+	}
+
+	Solver solver;
+	ProbeSampler probes(in);
+	solver.init(in);
+	solver.addObserver(&probes);
+	if (!restartFile.empty()) {
+		solver.restoreCheckpoint(restartFile);
+		std::cout << "Continuing from checkpoint at " << solver.m_outletT.back() << " h.\n";
+	}
+	if (!checkpointFile.empty())
+		solver.setCheckpoints(checkpointFile, checkpointDt);
+	// profiles are selected like in the GUI (see ProfileRecorder) and written to the result file after the run
+	ResultFileWriter writer;
+	ProfileRecorder profiles;
+	if (!resultFile.empty()) {
+		writer.open(resultFile, in);
+		profiles.init(Solver::newProfileStore(in), in);
+		solver.addObserver(&profiles);
+	}
+	solver.run();
+	std::cout << "\n";
+	SolverStatistics stats = solver.statistics();
+	stats.write(std::cout);
+	if (!resultFile.empty()) {
+		writer.appendProfiles(*profiles.store());
+		writer.writeProbes(probes);
+		writer.close(solver.m_outletT, solver.m_outletC, solver.m_breakthroughT, stats);
+	}
+	// a continued run lacks the probe series and counters of the first part
+	if (restartFile.empty())
+		cache.store(in, solver, profiles.store().get(), &probes);
+
+	out << "# t [h]\tc [kg/m3]\n";
+	for (unsigned int k=0; k<solver.m_outletT.size(); ++k)
+		out << solver.m_outletT[k] << "\t" << solver.m_outletC[k] << "\n";
+}
+
+
+/// Command line tool for single runs of a solver input file (checkpoints, result files, result cache)
+/// and the strong-scaling study of the threaded solver.
+int main(int argc, char * argv[]) {
+	IBK::ArgParser args;
+	args.setAppName("CXTSimFitRun");
+	args.addOption(0, "checkpoint", "Writes checkpoints to the given file.", "file", "");
+	args.addOption(0, "checkpointDt", "Checkpoint interval in h, 0 = at the end of the run only.", "dt", "0");
+	args.addOption(0, "restart", "Continues the run from the given checkpoint file (e.g. with a later end time).", "file", "");
+	args.addOption(0, "results", "Writes outlet series and profiles to the given binary result file.", "file", "");
+	args.addOption(0, "cache", "Result cache directory.", "directory", "");
+	args.addOption(0, "cacheSize", "Maximum size of the result cache in MB, 0 = unlimited.", "size", "1024");
+	args.addOption(0, "scaling", "Comma-separated list of thread numbers for a strong-scaling study of the "
+				   "threaded solver instead of the single run.", "t1,t2,...", "");
+	args.addOption(0, "n", "Comma-separated list of element numbers for --scaling (default: from the input file).", "n1,n2,...", "");
+	args.addOption('r', "repeats", "Number of runs per thread number for --scaling, the fastest run counts.", "repeats", "1");
+	args.addOption('o', "output", "Base name of output files (default: input file name).", "basename", "");
+	args.parse(argc, argv);
+	if (args.flagEnabled("help") || args.args().size() != 2) {
+		std::cout << "Single run of a CXTSimFit solver input file.\n"
+				  << "Writes the outlet series to <basename>.outlet.tsv.\n"
+				  << "With --scaling, the strong-scaling table of the threaded solver is written to\n"
+				  << "<basename>.scaling.tsv instead (one block per element number of --n).\n\n";
+		args.printHelp(std::cout);
+		return args.flagEnabled("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	try {
+		std::string inputFile = args.args()[1];
+		SolverInput input;
+		input.read(inputFile);
+
+		std::string basename = args.option('o');
+		if (basename.empty()) {
+			basename = inputFile;
+			std::string::size_type pos = basename.rfind('.');
+			if (pos != std::string::npos && basename.find_first_of("/\\", pos) == std::string::npos)
+				basename.erase(pos);
+		}
+
+		if (!args.option("scaling").empty()) {
+			std::vector<double> threads = sweepValues(args.option("scaling"));
+			if (threads.empty() || *std::min_element(threads.begin(), threads.end()) < 1)
+				throw IBK::Exception("Invalid thread numbers for the strong-scaling study.", "[main]");
+			std::vector<double> n = sweepValues(args.option("n"));
+			if (n.empty())
+				n.push_back(input.n);
+			unsigned int repeats = IBK::string2val<unsigned int>(args.option('r'));
+			std::ofstream table((basename + ".scaling.tsv").c_str());
+			for (unsigned int i=0; i<n.size(); ++i) {
+				input.n = static_cast<unsigned int>(n[i]);
+				std::stringstream strm;
+				strongScaling(input, threads, repeats, strm);
+				std::cout << strm.str();
+				table << strm.str();
+			}
+			return EXIT_SUCCESS;
+		}
+
+		ResultCache cache;
+		if (!args.option("cache").empty())
+			cache.open(args.option("cache"), IBK::string2val<uint64_t>(args.option("cacheSize"))*1024*1024);
+		std::ofstream table((basename + ".outlet.tsv").c_str());
+		singleRun(input, args.option("checkpoint"), IBK::string2val<double>(args.option("checkpointDt"))*3600,
+				  args.option("restart"), args.option("results"), cache, table);
+	}
+	catch (IBK::Exception & ex) {
+		ex.writeMsgStackToError();
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,258 @@
+#include "cyclicsteadystate.h"
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include <kinsol/kinsol.h>
+#include <kinsol/kinsol_spgmr.h>
+
+#include <IBK_Exception.h>
+#include <IBK_StringUtils.h>
+
+#include "solver.h"
+#include "profilerecorder.h"
+
+// Wrapper function called from KINSOL for the residual of the period map.
+static int f_cyclic(N_Vector y0, N_Vector F, void *user_data) {
+	return static_cast<CyclicSteadyState*>(user_data)->residual(y0, F);
+}
+
+
+// Wrapper function called from KINSOL for the Jacobian-vector product.
+static int jtimes_cyclic(N_Vector v, N_Vector Jv, N_Vector /*u*/, booleantype * /*new_u*/, void *user_data) {
+	return static_cast<CyclicSteadyState*>(user_data)->jacobianTimesVector(v, Jv);
+}
+
+
+CyclicSteadyState::CyclicSteadyState() :
+	m_maxIterations(20),
+	m_maxKrylov(50),
+	m_maxCycles(1000),
+	m_tolerance(1),
+	m_periodIntegrations(0),
+	m_newtonIterations(0),
+	m_linearIterations(0),
+	m_nEquations(0),
+	m_reference(nullptr),
+	m_referenceEnd(nullptr),
+	m_referenceValid(false),
+	m_perturbed(nullptr),
+	m_scale(nullptr)
+{
+}
+
+
+CyclicSteadyState::~CyclicSteadyState() {
+	clear();
+}
+
+
+void CyclicSteadyState::clear() {
+	N_Vector * vecs[] = { &m_reference, &m_referenceEnd, &m_perturbed, &m_scale };
+	for (unsigned int i=0; i<4; ++i) {
+		if (*vecs[i] != nullptr) {
+			N_VDestroy_Serial(*vecs[i]);
+			*vecs[i] = nullptr;
+		}
+	}
+	m_referenceValid = false;
+}
+
+
+void CyclicSteadyState::init(const SolverInput & input) {
+	FUNCID(CyclicSteadyState::init);
+	if (input.engine != SolverInput::ENGINE_CVODE)
+		throw IBK::Exception("The cyclic steady state requires the CVODE engine.", FUNC_ID);
+	if (input.cyclePeriod <= 0)
+		throw IBK::Exception("The cyclic steady state requires a period > 0.", FUNC_ID);
+
+	clear();
+	m_input = input;
+	m_input.tEnd = input.cyclePeriod;
+	m_input.activeWindow = false;
+	m_input.steadyState = SolverInput::SS_NONE;
+	m_input.stopAtBreakthrough = false;
+	// period states are exchanged with the serial vectors of the Newton-Krylov iteration
+	m_input.threads = 1;
+
+	m_periodIntegrations = 0;
+	m_newtonIterations = 0;
+	m_linearIterations = 0;
+
+	unsigned int nVars = (m_input.model == SolverInput::PLUS_EXCHANGE) ? 2 : 1;
+	m_nEquations = m_input.n*nVars;
+	m_reference = N_VNew_Serial(m_nEquations);
+	m_referenceEnd = N_VNew_Serial(m_nEquations);
+	m_perturbed = N_VNew_Serial(m_nEquations);
+	m_scale = N_VNew_Serial(m_nEquations);
+	if (!m_reference || !m_referenceEnd || !m_perturbed || !m_scale)
+		throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+
+	// reference state and weights: plateau values for the maximum inlet concentration
+	double cMax = m_input.cInlet;
+	if (!m_input.cInletData.empty())
+		cMax = *std::max_element(m_input.cInletData.y().begin(), m_input.cInletData.y().end());
+	if (cMax <= 0)
+		cMax = 1;
+	for (unsigned int i=0; i<m_input.n; ++i) {
+		for (unsigned int k=0; k<nVars; ++k) {
+			double S = ((k == 0) ? m_input.Rc : m_input.Rs)*cMax;
+			NV_DATA_S(m_reference)[i*nVars + k] = S;
+			NV_DATA_S(m_scale)[i*nVars + k] = 1/(m_input.relTol*S + m_input.absTol);
+		}
+	}
+}
+
+
+void CyclicSteadyState::run(const SolverInput & input) {
+	FUNCID(CyclicSteadyState::run);
+	init(input);
+
+	// start with an empty column
+	N_Vector y = N_VNew_Serial(m_nEquations);
+	if (!y)
+		throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+	N_VConst(0, y);
+
+	// F is a difference of states, hence states and residuals use the same scaling
+	void * kinMem = KINCreate();
+	int result = KINInit(kinMem, f_cyclic, y);
+	if (result == KIN_SUCCESS) {
+		KINSetUserData(kinMem, (void*)this);
+		result = KINSpgmr(kinMem, m_maxKrylov);
+		if (result != KINSPILS_SUCCESS) {
+			KINFree(&kinMem);
+			N_VDestroy_Serial(y);
+			throw IBK::Exception("KINSpgmr init error.", FUNC_ID);
+		}
+	}
+	else {
+		KINFree(&kinMem);
+		N_VDestroy_Serial(y);
+		throw IBK::Exception("KINInit init error.", FUNC_ID);
+	}
+	KINSpilsSetJacTimesVecFn(kinMem, jtimes_cyclic);
+	KINSetPrintLevel(kinMem, 0);
+	KINSetFuncNormTol(kinMem, m_tolerance);
+	KINSetScaledStepTol(kinMem, 1e-2*m_tolerance);
+	KINSetNumMaxIters(kinMem, m_maxIterations);
+	// the period map is affine, the Newton steps need not be limited
+	KINSetMaxNewtonStep(kinMem, std::numeric_limits<double>::max());
+
+	// residual evaluations store the outputs, the last one is the period starting with the solution
+	result = KINSol(kinMem, y, KIN_NONE, m_scale, m_scale);
+	long int nni = 0, nli = 0;
+	KINGetNumNonlinSolvIters(kinMem, &nni);
+	KINSpilsGetNumLinIters(kinMem, &nli);
+	m_newtonIterations = static_cast<unsigned int>(nni);
+	m_linearIterations = static_cast<unsigned int>(nli);
+	KINFree(&kinMem);
+	N_VDestroy_Serial(y);
+	if (result < 0)
+		throw IBK::Exception("Cyclic steady-state solver failed (KINSOL error code " + IBK::val2string(result) + ").", FUNC_ID);
+}
+
+
+void CyclicSteadyState::runCycling(const SolverInput & input) {
+	FUNCID(CyclicSteadyState::runCycling);
+	init(input);
+
+	N_Vector y0 = N_VNew_Serial(m_nEquations);
+	N_Vector y1 = N_VNew_Serial(m_nEquations);
+	if (!y0 || !y1) {
+		if (y0)
+			N_VDestroy_Serial(y0);
+		if (y1)
+			N_VDestroy_Serial(y1);
+		throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+	}
+	N_VConst(0, y0);
+
+	bool converged = false;
+	try {
+		while (!converged && m_periodIntegrations < m_maxCycles) {
+			propagate(y0, y1, true);
+			// same convergence test as used by KINSOL for the residual
+			N_VLinearSum(1, y1, -1, y0, y0);
+			N_VProd(y0, m_scale, y0);
+			converged = (N_VMaxNorm(y0) <= m_tolerance);
+			N_VScale(1, y1, y0);
+		}
+	}
+	catch (...) {
+		N_VDestroy_Serial(y0);
+		N_VDestroy_Serial(y1);
+		throw;
+	}
+	N_VDestroy_Serial(y0);
+	N_VDestroy_Serial(y1);
+	if (!converged)
+		throw IBK::Exception("Cyclic steady state not reached after " + IBK::val2string(m_maxCycles) + " periods.", FUNC_ID);
+}
+
+
+int CyclicSteadyState::residual(N_Vector y0, N_Vector F) {
+	try {
+		propagate(y0, F, true);
+	}
+	catch (std::exception &) {
+		return -1;
+	}
+	N_VLinearSum(1, F, -1, y0, F);
+	return 0;
+}
+
+
+int CyclicSteadyState::jacobianTimesVector(N_Vector v, N_Vector Jv) {
+	try {
+		if (!m_referenceValid) {
+			propagate(m_reference, m_referenceEnd, false);
+			m_referenceValid = true;
+		}
+		// largest increment that keeps the perturbed state non-negative
+		const double * vd = NV_DATA_S(v);
+		const double * S = NV_DATA_S(m_reference);
+		double sigma = std::numeric_limits<double>::max();
+		for (unsigned int i=0; i<m_nEquations; ++i) {
+			if (vd[i] != 0)
+				sigma = std::min(sigma, 0.5*S[i]/std::fabs(vd[i]));
+		}
+		if (sigma == std::numeric_limits<double>::max()) {
+			N_VConst(0, Jv);
+			return 0;
+		}
+		N_VLinearSum(1, m_reference, sigma, v, m_perturbed);
+		propagate(m_perturbed, Jv, false);
+		N_VLinearSum(1/sigma, Jv, -1/sigma, m_referenceEnd, Jv);
+		N_VLinearSum(1, Jv, -1, v, Jv);
+	}
+	catch (std::exception &) {
+		return -1;
+	}
+	return 0;
+}
+
+
+void CyclicSteadyState::propagate(N_Vector y0, N_Vector y1, bool storeResults) {
+	// profiles are only recorded for the results, not for the Newton-Krylov iterations
+	Solver solver;
+	ProfileRecorder profiles;
+	solver.init(m_input);
+	if (storeResults) {
+		profiles.init(Solver::newProfileStore(m_input), m_input);
+		solver.addObserver(&profiles);
+	}
+	solver.setState(0, y0);
+	solver.run();
+	// the solver state is not a serial vector (see Solver::newVector()), copy the data directly
+	const double * yEnd = N_VGetArrayPointer(solver.state());
+	std::copy(yEnd, yEnd + NV_LENGTH_S(y1), NV_DATA_S(y1));
+	++m_periodIntegrations;
+
+	if (storeResults) {
+		m_outletT = solver.m_outletT;
+		m_outletC = solver.m_outletC;
+		m_profiles = profiles.store();
+	}
+}
@@ -0,0 +1,86 @@
+#ifndef cyclicsteadystate_h
+#define cyclicsteadystate_h
+
+#include <vector>
+#include <memory>
+
+#include <nvector/nvector_serial.h>
+
+#include "solverinput.h"
+#include "profilestore.h"
+
+/// Driver for the cyclic steady state of periodic operation (inlet schedule repeats with SolverInput::cyclePeriod).
+///
+/// One period is treated as map y(T) = P(y0), where P integrates the model with CVODE (Solver)
+/// from t = 0 to T. The cyclic steady state is the root of F(y0) = P(y0) - y0.
+///
+/// The shooting method (run()) solves F(y0) = 0 with the Newton-Krylov solver of KINSOL (GMRES).
+/// Since the model is linear (apart from clipping of negative mass densities), P is affine and its
+/// derivative is independent of y0. Jacobian-vector products are computed as
+///   J v = (P(S + sigma v) - P(S))/sigma - v
+/// with a fixed, positive reference state S (plateau values for the maximum inlet concentration), so
+/// that the perturbed runs never need clipping and sigma can be large. P(S) is computed only once,
+/// each linear iteration costs one period integration.
+///
+/// Direct cycling (runCycling()) integrates period after period until the state no longer changes,
+/// it is provided as reference. Both methods count the period integrations.
+///
+/// The results contain the outputs of the last period integration, i.e. the period starting with the
+/// cyclic steady state (time points 0...T).
+class CyclicSteadyState {
+public:
+	/// Constructor.
+	CyclicSteadyState();
+	/// Destructor, releases state vectors.
+	~CyclicSteadyState();
+
+	/// Computes the cyclic steady state with the shooting method.
+	/// Input must use ENGINE_CVODE and a period > 0. Throws an IBK::Exception if the
+	/// Newton iteration or any of the solver runs fails.
+	void run(const SolverInput & input);
+
+	/// Computes the cyclic steady state by direct cycling, starting with an empty column.
+	/// Throws an IBK::Exception if the state has not converged after m_maxCycles periods.
+	void runCycling(const SolverInput & input);
+
+	/// Computes the residual F(y0) = P(y0) - y0 (called from KINSOL).
+	int residual(N_Vector y0, N_Vector F);
+
+	/// Computes the product of the Jacobian of F with vector v (called from KINSOL).
+	int jacobianTimesVector(N_Vector v, N_Vector Jv);
+
+	unsigned int		m_maxIterations;	///< Maximum number of Newton iterations.
+	unsigned int		m_maxKrylov;		///< Maximum Krylov subspace dimension (GMRES).
+	unsigned int		m_maxCycles;		///< Maximum number of periods for direct cycling.
+	double				m_tolerance;		///< Convergence limit for F (maximum norm with solver tolerances).
+
+	unsigned int		m_periodIntegrations;	///< Number of period integrations in the last run.
+	unsigned int		m_newtonIterations;		///< Number of Newton iterations in the last run (shooting only).
+	unsigned int		m_linearIterations;		///< Number of GMRES iterations in the last run (shooting only).
+
+	std::vector<double>		m_outletT;	///< Vector with time points of outlet data in [h]
+	std::vector<double>		m_outletC;	///< Vector with concentrations at outlet in [kg/m3]
+
+	std::shared_ptr<const ProfileStore>	m_profiles;	///< Concentration profiles of the last period.
+
+private:
+	/// Checks input and allocates state vectors and scaling.
+	void init(const SolverInput & input);
+
+	/// Integrates one period starting with state y0 and stores the final state in y1.
+	/// If storeResults is true, the outputs of the run are stored in the result vectors.
+	void propagate(N_Vector y0, N_Vector y1, bool storeResults);
+
+	/// Releases all state vectors.
+	void clear();
+
+	SolverInput			m_input;		///< Input data for a single period (end time = period).
+	unsigned int		m_nEquations;	///< Number of unknowns (elements times variables per element).
+	N_Vector			m_reference;	///< Reference state S for the Jacobian-vector products.
+	N_Vector			m_referenceEnd;	///< P(S), computed on first use.
+	bool				m_referenceValid;	///< True, once P(S) has been computed.
+	N_Vector			m_perturbed;	///< Temporary state vector.
+	N_Vector			m_scale;		///< Inverse weights 1/(relTol*S + absTol) used for scaling and convergence tests.
+};
+
+#endif // cyclicsteadystate_h
@@ -0,0 +1,411 @@
+#include "dataimporter.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+// fast_float is used like in IBK::string2val<double>(), 32 bit Windows builds use strtod()
+#if defined(_WIN32) && !defined(_WIN64)
+	#define DATAIMPORTER_USE_STRTOD
+#else
+	#include "fast_float/fast_float.h"
+#endif
+
+#include <IBK_Exception.h>
+#include <IBK_FormatString.h>
+#include <IBK_Unit.h>
+#include <IBK_UnitList.h>
+
+/// Files below this size (in bytes) are parsed by a single thread.
+static const size_t MIN_CHUNK_SIZE = 1 << 20;
+/// Number of lines after which a chunk checks whether a preceding chunk has ended the table.
+static const unsigned int STOP_CHECK_LINES = 4096;
+
+
+/// Read-only mapping of a file, released by the destructor.
+class MappedFile {
+public:
+	MappedFile() : m_data(nullptr), m_size(0) {
+#if defined(_WIN32)
+		m_file = INVALID_HANDLE_VALUE;
+		m_mapping = nullptr;
+#else
+		m_file = -1;
+#endif
+	}
+
+	~MappedFile() {
+#if defined(_WIN32)
+		if (m_data != nullptr)
+			UnmapViewOfFile(m_data);
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+#else
+		if (m_data != nullptr)
+			munmap(const_cast<char *>(m_data), m_size);
+		if (m_file != -1)
+			::close(m_file);
+#endif
+	}
+
+	/// Maps the file (also while another process writes it), an empty file has no data. Throws an
+	/// IBK::Exception if the file cannot be mapped.
+	void open(const std::string & filename) {
+		FUNCID(MappedFile::open);
+#if defined(_WIN32)
+		m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+							 FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			throw IBK::Exception(IBK::FormatString("Cannot open data file '%1'.").arg(filename), FUNC_ID);
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size))
+			throw IBK::Exception(IBK::FormatString("Cannot read data file '%1'.").arg(filename), FUNC_ID);
+		m_size = static_cast<size_t>(size.QuadPart);
+		if (m_size == 0)
+			return;
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping != nullptr)
+			m_data = static_cast<const char *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+		m_file = ::open(filename.c_str(), O_RDONLY);
+		if (m_file == -1)
+			throw IBK::Exception(IBK::FormatString("Cannot open data file '%1'.").arg(filename), FUNC_ID);
+		struct stat st;
+		if (fstat(m_file, &st) != 0)
+			throw IBK::Exception(IBK::FormatString("Cannot read data file '%1'.").arg(filename), FUNC_ID);
+		m_size = static_cast<size_t>(st.st_size);
+		if (m_size == 0)
+			return;
+		void * p = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_file, 0);
+		if (p != MAP_FAILED) {
+			m_data = static_cast<const char *>(p);
+			madvise(p, m_size, MADV_SEQUENTIAL);
+		}
+#endif
+		if (m_data == nullptr)
+			throw IBK::Exception(IBK::FormatString("Cannot map data file '%1'.").arg(filename), FUNC_ID);
+	}
+
+	const char * begin() const { return m_data; }
+	const char * end() const { return m_data + m_size; }
+
+private:
+	const char	*m_data;		///< Start of the mapping, nullptr for an empty file.
+	size_t		m_size;			///< Size of the file in bytes.
+#if defined(_WIN32)
+	HANDLE		m_file;			///< Handle of the file.
+	HANDLE		m_mapping;		///< Handle of the file mapping.
+#else
+	int			m_file;			///< Descriptor of the file, -1 if not open.
+#endif
+};
+
+
+/// Returns true for column separators (the carriage return of Windows line ends is treated as separator).
+static inline bool isSeparator(char c) {
+	return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+}
+
+
+/// Converts the token [p, end) into val, returns false if it is not a number.
+static inline bool parseValue(const char * p, const char * end, double & val) {
+	if (p != end && *p == '+')
+		++p;
+#if defined(DATAIMPORTER_USE_STRTOD)
+	char buf[64];
+	size_t len = static_cast<size_t>(end - p);
+	if (len == 0 || len >= sizeof(buf))
+		return false;
+	std::memcpy(buf, p, len);
+	buf[len] = 0;
+	char * last;
+	val = std::strtod(buf, &last);
+	return last == buf + len;
+#else
+	fast_float::from_chars_result res = fast_float::from_chars(p, end, val);
+	return res.ec == std::errc() && res.ptr == end;
+#endif
+}
+
+
+/// Returns the end of the line starting at p (position of '\n' or end).
+static inline const char * lineEnd(const char * p, const char * end) {
+	// memchr is vectorized by the C runtime libraries
+	const char * e = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+	return e == nullptr ? end : e;
+}
+
+
+/// Returns true if the line [p, end) ends the table (empty line).
+static inline bool isEmptyLine(const char * p, const char * end) {
+	return p == end || (p + 1 == end && *p == '\r');
+}
+
+
+/// Part of the file parsed by one thread.
+struct Chunk {
+	const char							*begin;		///< First line.
+	const char							*end;		///< End of the last line.
+	std::vector<double>					t;			///< Time points in h.
+	std::vector<std::vector<double> >	values;		///< Values of the selected columns.
+	bool								stopped;	///< True if the table ends within the chunk.
+};
+
+
+/// Parses the lines of chunk k. Chunks after the first chunk that ends the table (firstStop) are abandoned.
+/// @param slot Index of each column in Chunk::values up to the last selected column, -1 for columns
+///		not selected, -2 for the time column.
+static void parseChunk(Chunk & chunk, unsigned int k, const std::vector<int> & slot, unsigned int valueCount,
+					   double timeFactor, std::atomic<unsigned int> & firstStop)
+{
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	chunk.values.resize(valueCount);
+	chunk.stopped = false;
+	std::vector<double> row(valueCount);
+	unsigned int lines = 0;
+	for (const char * line = chunk.begin; line < chunk.end; ) {
+		const char * eol = lineEnd(line, chunk.end);
+		if (++lines % STOP_CHECK_LINES == 0 && firstStop.load() < k)
+			return;
+		if (*line == '#') {
+			line = eol + 1;
+			continue;
+		}
+		if (isEmptyLine(line, eol)) {
+			chunk.stopped = true;
+			break;
+		}
+
+		// split the line into columns up to the last selected one
+		double t = nan;
+		bool timeValid = false, firstValid = false;
+		std::fill(row.begin(), row.end(), nan);
+		const char * p = line;
+		for (unsigned int col=0; col<slot.size(); ++col) {
+			while (p < eol && isSeparator(*p))
+				++p;
+			if (p == eol)
+				break;
+			const char * tokenEnd = p;
+			while (tokenEnd < eol && !isSeparator(*tokenEnd))
+				++tokenEnd;
+			int s = slot[col];
+			if (s == -2)
+				timeValid = parseValue(p, tokenEnd, t);
+			else if (s >= 0) {
+				double val;
+				if (parseValue(p, tokenEnd, val)) {
+					row[s] = val;
+					if (s == 0)
+						firstValid = true;
+				}
+			}
+			p = tokenEnd;
+		}
+		if (!timeValid || !firstValid) {
+			chunk.stopped = true;
+			break;
+		}
+		chunk.t.push_back(t*timeFactor);
+		for (unsigned int j=0; j<valueCount; ++j)
+			chunk.values[j].push_back(row[j]);
+		line = eol + 1;
+	}
+
+	if (chunk.stopped) {
+		unsigned int prev = firstStop.load();
+		while (k < prev && !firstStop.compare_exchange_weak(prev, k))
+			;
+	}
+}
+
+
+/// Parses the lines [first, end) concurrently and appends the rows to t and values. Returns true if the
+/// table ends within the range.
+static bool parseRange(const char * first, const char * end, unsigned int threads, const std::vector<int> & slot,
+					   double timeFactor, std::vector<double> & t, std::vector<std::vector<double> > & values)
+{
+	// chunks start at line boundaries
+	size_t size = static_cast<size_t>(end - first);
+	threads = static_cast<unsigned int>(std::max<size_t>(1, std::min<size_t>(threads, size/MIN_CHUNK_SIZE)));
+	std::vector<Chunk> chunks(threads);
+	for (unsigned int k=0; k<threads; ++k) {
+		chunks[k].begin = (k == 0) ? first : std::min(end, lineEnd(first + size/threads*k, end) + 1);
+		if (k > 0)
+			chunks[k-1].end = chunks[k].begin;
+	}
+	chunks.back().end = end;
+
+	unsigned int valueCount = static_cast<unsigned int>(values.size());
+	std::atomic<unsigned int> firstStop(threads);
+	std::vector<std::thread> workers;
+	for (unsigned int k=1; k<threads; ++k)
+		workers.push_back(std::thread(parseChunk, std::ref(chunks[k]), k, std::cref(slot), valueCount, timeFactor,
+									  std::ref(firstStop)));
+	parseChunk(chunks[0], 0, slot, valueCount, timeFactor, firstStop);
+	for (unsigned int i=0; i<workers.size(); ++i)
+		workers[i].join();
+
+	// the table ends with the first chunk that stopped
+	unsigned int last = std::min(firstStop.load(), threads - 1);
+	size_t rows = t.size();
+	for (unsigned int k=0; k<=last; ++k)
+		rows += chunks[k].t.size();
+	t.reserve(rows);
+	for (unsigned int j=0; j<valueCount; ++j)
+		values[j].reserve(rows);
+	for (unsigned int k=0; k<=last; ++k) {
+		t.insert(t.end(), chunks[k].t.begin(), chunks[k].t.end());
+		for (unsigned int j=0; j<valueCount; ++j)
+			values[j].insert(values[j].end(), chunks[k].values[j].begin(), chunks[k].values[j].end());
+	}
+	return firstStop.load() < threads;
+}
+
+
+DataImporter::DataImporter() :
+	m_timeColumn(0),
+	m_timeUnit("h"),
+	m_threads(0),
+	m_offset(0),
+	m_partialRow(false),
+	m_ended(false),
+	m_timeFactor(1)
+{
+}
+
+
+void DataImporter::read(const std::string & filename) {
+	FUNCID(DataImporter::read);
+	m_filename = filename;
+	m_t.clear();
+	m_values.clear();
+	m_slot.clear();
+	m_offset = 0;
+	m_partialRow = false;
+	m_ended = false;
+
+	try {
+		IBK::UnitList::instance().convert(IBK::Unit(m_timeUnit), IBK::Unit("h"), m_timeFactor);
+	}
+	catch (IBK::Exception & ex) {
+		throw IBK::Exception(ex, IBK::FormatString("Invalid time unit '%1'.").arg(m_timeUnit), FUNC_ID);
+	}
+
+	readAppended();
+}
+
+
+size_t DataImporter::readAppended() {
+	FUNCID(DataImporter::readAppended);
+	MappedFile file;
+	file.open(m_filename);
+	const char * begin = file.begin();
+	const char * end = file.end();
+
+	// a shorter file has been replaced or truncated, so all rows are read again
+	if (static_cast<size_t>(end - begin) < m_offset) {
+		read(m_filename);
+		return 0;
+	}
+	if (m_ended)
+		return m_t.size();
+
+	// the row of an incomplete last line is parsed again
+	if (m_partialRow) {
+		m_t.pop_back();
+		for (unsigned int j=0; j<m_values.size(); ++j)
+			m_values[j].pop_back();
+		m_partialRow = false;
+	}
+	size_t firstChanged = m_t.size();
+	const char * first = begin + m_offset;
+
+	// the first row gives the columns
+	bool columnsFromPartialRow = false;
+	if (m_slot.empty()) {
+		while (first < end && *first == '#' && lineEnd(first, end) < end)
+			first = lineEnd(first, end) + 1;
+		m_offset = static_cast<size_t>(first - begin);
+		if (first == end || *first == '#')
+			return firstChanged;
+		const char * eol = lineEnd(first, end);
+		if (isEmptyLine(first, eol)) {
+			m_ended = (eol < end);
+			return firstChanged;
+		}
+		unsigned int columns = 0;
+		for (const char * p = first; p < eol; ++columns) {
+			while (p < eol && isSeparator(*p))
+				++p;
+			if (p == eol)
+				break;
+			while (p < eol && !isSeparator(*p))
+				++p;
+		}
+		std::vector<unsigned int> valueColumns = m_valueColumns;
+		if (valueColumns.empty()) {
+			for (unsigned int col=0; col<columns; ++col)
+				if (col != m_timeColumn)
+					valueColumns.push_back(col);
+		}
+		if (valueColumns.empty() || m_timeColumn >= columns ||
+			*std::max_element(valueColumns.begin(), valueColumns.end()) >= columns)
+		{
+			// the first row may still be written
+			if (eol == end)
+				return firstChanged;
+			throw IBK::Exception(IBK::FormatString("Data file '%1' has only %2 columns.").arg(m_filename).arg(columns), FUNC_ID);
+		}
+		m_slot.assign(columns, -1);
+		for (unsigned int j=0; j<valueColumns.size(); ++j)
+			m_slot[valueColumns[j]] = static_cast<int>(j);
+		m_slot[m_timeColumn] = -2;
+		// columns after the last selected one are not split
+		while (m_slot.back() == -1)
+			m_slot.pop_back();
+		m_values.assign(valueColumns.size(), std::vector<double>());
+		columnsFromPartialRow = (eol == end);
+	}
+
+	// complete lines are parsed concurrently
+	const char * complete = end;
+	while (complete > first && complete[-1] != '\n')
+		--complete;
+	unsigned int threads = m_threads;
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	if (first < complete && parseRange(first, complete, threads, m_slot, m_timeFactor, m_t, m_values))
+		m_ended = true;
+	m_offset = static_cast<size_t>(complete - begin);
+
+	// a last line without line end may still be written, its row is replaced by the next call
+	if (!m_ended && complete < end) {
+		std::vector<double> t;
+		std::vector<std::vector<double> > values(m_values.size());
+		parseRange(complete, end, 1, m_slot, m_timeFactor, t, values);
+		if (!t.empty()) {
+			m_t.push_back(t[0]);
+			for (unsigned int j=0; j<m_values.size(); ++j)
+				m_values[j].push_back(values[j][0]);
+			m_partialRow = true;
+		}
+	}
+	if (columnsFromPartialRow)
+		m_slot.clear();
+	return firstChanged;
+}
@@ -0,0 +1,56 @@
+#ifndef dataimporter_h
+#define dataimporter_h
+
+#include <string>
+#include <vector>
+
+/// Reads measured data tables (e.g. inlet or outlet logs of a filter test) with one row per time point.
+///
+/// Columns are separated by spaces, tabs, commas or semicolons. Lines starting with '#' are skipped,
+/// the table ends with the first empty line or the first line whose time point or first selected value
+/// cannot be read. Selected columns missing in a row are set to NaN.
+///
+/// The file is mapped into memory and split into chunks at line boundaries, which are parsed
+/// concurrently (numbers are converted with fast_float).
+///
+/// Files of running experiments are followed with readAppended(), which parses only the lines appended
+/// since the previous call.
+class DataImporter {
+public:
+	/// Constructor, sets the defaults (time points in h in the first column, all further columns as values).
+	DataImporter();
+
+	/// Reads the file. Throws an IBK::Exception if the file cannot be mapped, the time unit is invalid or
+	/// a selected column does not exist in the first row (unless the file ends within the first row).
+	void read(const std::string & filename);
+
+	/// Reads the rows appended to the file since the last call of read() or readAppended() and returns
+	/// the index of the first new or replaced row (m_t.size() if there is none). The row of a last line without line
+	/// end is replaced by the next call, a file that has become shorter is read again (returns 0).
+	/// Nothing is added once the table has ended. Throws an IBK::Exception like read().
+	size_t readAppended();
+
+	// Settings
+	unsigned int				m_timeColumn;	///< Column of the time points (0 = first column).
+	/// Columns of the values (0 = first column), empty means all columns of the first row after the time column.
+	std::vector<unsigned int>	m_valueColumns;
+	std::string					m_timeUnit;		///< Unit of the time points in the file (IBK unit name, e.g. s, min, h, d).
+	unsigned int				m_threads;		///< Number of threads, 0 means the number of cores.
+
+	// Results
+	std::vector<double>					m_t;		///< Time points in h.
+	/// Values of each selected column (same size as m_t), NaN where a row lacks the column.
+	std::vector<std::vector<double> >	m_values;
+
+private:
+	std::string			m_filename;		///< File given to read().
+	size_t				m_offset;		///< Position after the last complete line that has been read.
+	bool				m_partialRow;	///< True if the last row stems from a line without line end.
+	bool				m_ended;		///< True if the table has ended.
+	double				m_timeFactor;	///< Factor converting the time points into h.
+	/// Index of each column in m_values up to the last selected column, -1 for columns not selected,
+	/// -2 for the time column. Empty until the first row is complete.
+	std::vector<int>	m_slot;
+};
+
+#endif // dataimporter_h
@@ -0,0 +1,88 @@
+#include "gridstudy.h"
+
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+#include <IBK_Exception.h>
+
+#include "solver.h"
+#include "profilerecorder.h"
+#include "parallelfor.h"
+
+GridStudy::GridStudy(unsigned int threads) :
+	m_levels(3),
+	m_ratio(2),
+	m_order(0),
+	m_threads(threads)
+{
+	if (m_threads == 0)
+		m_threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+void GridStudy::run(const SolverInput & input) {
+	FUNCID(GridStudy::run);
+	if (m_levels < 3 || m_ratio < 2)
+		throw IBK::Exception("The grid study needs at least 3 grids and a refinement ratio of at least 2.", FUNC_ID);
+	if (input.steadyState == SolverInput::SS_CYCLIC || input.steadyState == SolverInput::SS_CYCLIC_DIRECT)
+		throw IBK::Exception("The grid study does not support the cyclic steady state.", FUNC_ID);
+
+	m_results.assign(m_levels, SolverResults());
+	m_order = 0;
+	m_outletT.clear();
+	m_extrapolatedC.clear();
+	m_errorEstimate.clear();
+	unsigned int n = input.n;
+	for (unsigned int i=0; i<m_levels; ++i) {
+		m_results[i].input = input;
+		m_results[i].input.n = n;
+		// outlet curves must have the same time points
+		m_results[i].input.pararealSlices = 1;
+		m_results[i].input.stopAtBreakthrough = false;
+		n *= m_ratio;
+	}
+
+	try {
+		// the finest (most expensive) grids first
+		parallelFor(m_levels, m_threads, [&](unsigned int j) {
+			SolverResults & res = m_results[m_levels - 1 - j];
+			Solver solver;
+			ProfileRecorder profiles;
+			solver.init(res.input);
+			profiles.init(Solver::newProfileStore(res.input), res.input);
+			solver.addObserver(&profiles);
+			solver.run();
+			res.profiles = profiles.store();
+			res.breakthroughT = solver.m_breakthroughT;
+			res.data.setValues(solver.m_outletT, solver.m_outletC);
+		});
+	}
+	catch (IBK::Exception & ex) {
+		throw IBK::Exception(ex, "Simulation of a grid failed.", FUNC_ID);
+	}
+
+	// observed order from the three finest grids
+	const std::vector<double> & f1 = m_results[m_levels-3].data.y();
+	const std::vector<double> & f2 = m_results[m_levels-2].data.y();
+	const std::vector<double> & f3 = m_results[m_levels-1].data.y();
+	unsigned int nOut = std::min(f1.size(), std::min(f2.size(), f3.size()));
+	double d12 = 0, d23 = 0;
+	for (unsigned int k=0; k<nOut; ++k) {
+		d12 += (f1[k] - f2[k])*(f1[k] - f2[k]);
+		d23 += (f2[k] - f3[k])*(f2[k] - f3[k]);
+	}
+	if (d23 == 0 || d12 <= d23)
+		return; // converged already or no monotonic convergence
+	m_order = std::log(std::sqrt(d12/d23))/std::log((double)m_ratio);
+
+	double factor = 1/(std::pow((double)m_ratio, m_order) - 1);
+	const std::vector<double> & t = m_results[m_levels-1].data.x();
+	for (unsigned int k=0; k<nOut; ++k) {
+		m_outletT.push_back(t[k]);
+		double correction = (f3[k] - f2[k])*factor;
+		// mass densities are non-negative, extrapolation of fronts on coarse grids may overshoot
+		m_extrapolatedC.push_back(std::max(0.0, f3[k] + correction));
+		m_errorEstimate.push_back(std::fabs(correction));
+	}
+}
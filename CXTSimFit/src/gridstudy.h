@@ -0,0 +1,43 @@
+#ifndef gridstudy_h
+#define gridstudy_h
+
+#include <vector>
+
+#include "solverinput.h"
+#include "solverresults.h"
+
+/// Grid convergence study with Richardson extrapolation of the outlet curve.
+///
+/// The simulation is run on a geometric sequence of grids n, r*n, r^2*n, ... (n from the input,
+/// r = m_ratio) concurrently. The three finest grids give the observed order of convergence
+///   p = ln(|f1 - f2|/|f2 - f3|)/ln(r)
+/// (f1 coarsest, f3 finest, L2 norms over all output time points) and the extrapolated outlet curve
+///   f_ext = f3 + (f3 - f2)/(r^p - 1).
+/// The correction |f3 - f2|/(r^p - 1) serves as error estimate of the finest grid solution per time point.
+/// Note: for sharp fronts (D = 0) the observed order of the upwind scheme is well below 1, so the
+/// extrapolation is large near the front (negative values are clipped).
+class GridStudy {
+public:
+	/// Constructor.
+	/// @param threads Number of concurrent solver runs, 0 means number of cores.
+	GridStudy(unsigned int threads = 0);
+
+	/// Runs the simulation on all grids (input.n is the coarsest grid) and computes the extrapolation.
+	/// Throws an IBK::Exception if the input is not suitable or any of the runs fails. If the solutions do
+	/// not converge monotonically, m_order is 0 and no extrapolation is computed.
+	void run(const SolverInput & input);
+
+	unsigned int			m_levels;		///< Number of grids (at least 3).
+	unsigned int			m_ratio;		///< Refinement ratio between successive grids (at least 2).
+
+	std::vector<SolverResults>	m_results;	///< Results of all grids, coarsest first (R2 is not computed).
+	double					m_order;		///< Observed order of convergence, 0 if not determinable.
+	std::vector<double>		m_outletT;		///< Output time points in [h].
+	std::vector<double>		m_extrapolatedC;	///< Richardson-extrapolated outlet concentrations in [kg/m3].
+	std::vector<double>		m_errorEstimate;	///< Error estimate of the finest grid outlet concentrations in [kg/m3].
+
+private:
+	unsigned int			m_threads;		///< Number of concurrent solver runs.
+};
+
+#endif // gridstudy_h
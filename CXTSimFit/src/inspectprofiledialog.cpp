@@ -9,12 +9,14 @@ InspectProfileDialog::InspectProfileDialog(QWidget *parent, const SolverResults
 
 	resize(600,500);
 
-	// setup the time range
+	// one slider step per snapshot, so that closely spaced snapshots (adaptive profile recording)
+	// can be reached as well, the title shows the time of the snapshot
 	ui.horizontalSlider->setValue(0);
-	ui.horizontalSlider->setMaximum(results.ccProfiles.size()-1);
+	ui.horizontalSlider->setMaximum(results.profiles->size() - 1);
 
-	// set the maximum time label
-	ui.labelMaxSimTime->setText(QString("%1 h").arg(results.input.tEnd/3600));
+	// set the time labels
+	ui.label->setText(QString("%1 h").arg(results.profiles->t().front()));
+	ui.labelMaxSimTime->setText(QString("%1 h").arg(results.profiles->t().back()));
 
 	// setup the chart
 	ui.chart->setMarginRight(60);
@@ -50,18 +52,13 @@ InspectProfileDialog::InspectProfileDialog(QWidget *parent, const SolverResults
 	}
 	x.front() = 0;
 	x.back() = results.input.L; // to avoid rounding errors
+	cc.resize(results.input.n);
+	sc.resize(results.input.n);
+	shownSnapshot = -1;
 
-	// find global max values
-	double maxcc = 0;
-	double maxsc = 0;
-	for (int i=0; i<results.ccProfiles.size(); ++i) {
-		for (int j=0; j<results.input.n; ++j) {
-			maxcc = std::max(maxcc, results.ccProfiles[i][j]);
-			if (results.input.model == SolverInput::PLUS_EXCHANGE) {
-				maxsc = std::max(maxsc, results.scProfiles[i][j]);
-			}
-		}
-	}
+	// global max values, tracked while the profiles were stored
+	double maxcc = results.profiles->maxCc();
+	double maxsc = results.profiles->maxSc();
 
 	ui.chart->x1Axis()->setAutomaticScaling(false);
 	ui.chart->x1Axis()->setMinVal(0);
@@ -87,17 +84,22 @@ void InspectProfileDialog::on_pushButtonClose_clicked() {
 }
 
 void InspectProfileDialog::on_horizontalSlider_valueChanged(int) {
-	// update chart caption
-	int val = ui.horizontalSlider->value();
-	Q_ASSERT(val < results.tProfiles.size());
-	double t = results.tProfiles[val];
+	// slider position is the snapshot index
+	const std::vector<double> & t = results.profiles->t();
+	int k = ui.horizontalSlider->value();
+	if (k == shownSnapshot)
+		return; // still the same snapshot, no need to decode again
+	shownSnapshot = k;
 
-	ui.labelTitle->setText(QString("Profiles at %1 h").arg(t));
+	// update chart caption
+	ui.labelTitle->setText(QString("Profiles at %1 h (snapshot %2 of %3)").arg(t[k]).arg(k+1).arg(t.size()));
 
 	// now set the data values in the series
-	ccCurve.series->setData(results.input.n, &x[0], &(results.ccProfiles[val][0]));
+	// decode the snapshot, the series only keep pointers to the data
+	results.profiles->profile(k, &cc[0], &sc[0]);
+	ccCurve.series->setData(results.input.n, &x[0], &cc[0]);
 	if (results.input.model == SolverInput::PLUS_EXCHANGE) {
-		scCurve.series->setData(results.input.n, &x[0], &(results.scProfiles[val][0]));
+		scCurve.series->setData(results.input.n, &x[0], &sc[0]);
 	}
 	ui.chart->updateChart();
 }
@@ -14,18 +14,22 @@ class InspectProfileDialog : public QDialog {
 	Q_OBJECT
 
 public:
+	/// Constructor, res must hold profiles.
 	InspectProfileDialog(QWidget *parent, const SolverResults & res);
 	~InspectProfileDialog();
 
 private:
 	Ui::InspectProfileDialog ui;
 
-	SolverResults results;
+	SolverResults results;		///< Results of the inspected curve, the profiles are shared and decoded on demand.
 
 	CurveData				ccCurve;	///< Data for the mobile concentration.
 	CurveData				scCurve;	///< Data for the mobile concentration.
 
 	std::vector<double>		x;			///< The x-coordinates in [m].
+	std::vector<double>		cc;			///< Mobile phase concentrations of the shown snapshot in [kg/m3].
+	std::vector<double>		sc;			///< Immobile phase concentrations of the shown snapshot in [kg/m3].
+	int						shownSnapshot;	///< Index of the shown snapshot, -1 if none.
 
 private slots:
 	void on_horizontalSlider_valueChanged(int);
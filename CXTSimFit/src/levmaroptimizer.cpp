@@ -9,6 +9,22 @@
 
 #include "solverinput.h"
 #include "solver.h"
+#include "solverobserver.h"
+#include "resultcache.h"
+#include "resultfile.h"
+
+/// Passes a stored outlet series (of the reduced-order model or a cache entry) to the residual
+/// accumulators, like the outputs of a solver run.
+static void replayOutlet(const double * t, const double * c, size_t size, std::vector<ResidualAccumulator> & residuals) {
+	SolverOutput out = SolverOutput();
+	for (size_t i=0; i<size; ++i) {
+		out.t = t[i];
+		out.outletC = c[i];
+		for (unsigned int k=0; k<residuals.size(); ++k)
+			residuals[k].observe(out);
+	}
+}
+
 
 /// Function that get's passed to the levmar library
 void solver_fit(double *p, double *x, int m, int n, void *data) {
@@ -20,8 +36,22 @@ void solver_fit(double *p, double *x, int m, int n, void *data) {
 LevMarOptimizer::LevMarOptimizer(const SolverInput & input,
 								 const std::vector<double> & t,
 								 const std::vector<double> & c_out)
-	: m_input(&input), max_iters(1000), m_c(c_out), m_t(t)
+	: m_input(&input), max_iters(1000), m_cache(nullptr), m_c(c_out)
 {
+	m_series.push_back(MeasuredSeries(-1, t, c_out));
+}
+
+
+LevMarOptimizer::LevMarOptimizer(const SolverInput & input, const std::vector<MeasuredSeries> & series)
+	: m_input(&input), max_iters(1000), m_cache(nullptr), m_series(series)
+{
+	// the measured values are weighted like the calculated values in calculate()
+	for (unsigned int k=0; k<m_series.size(); ++k) {
+		if (m_series[k].probe >= (int)input.probePositions.size())
+			throw std::runtime_error("Measured series refers to an undefined probe position.");
+		for (unsigned int i=0; i<m_series[k].c.size(); ++i)
+			m_c.push_back(m_series[k].weight*m_series[k].c[i]);
+	}
 }
 
 
@@ -60,6 +90,11 @@ void LevMarOptimizer::optimize(std::vector<double> & parameters) {
 		std::cout << "Levenberg-Marquardt returned after " << ret << " iterations." << std::endl;
 		std::cout << "    " << info[7] << " function evaluations (solver runs)" << std::endl;
 		std::cout << "    " << info[8] << " Jacobian evaluations" << std::endl;
+		if (m_input->reducedOrderFit) {
+			std::cout << "    " << m_reducedModel.m_fullRuns << " full-order runs, "
+					  << m_reducedModel.m_reducedRuns << " reduced-order runs, "
+					  << m_reducedModel.m_enrichments << " basis enrichments" << std::endl;
+		}
 		std::cout << "Reason for terminating:";
 		switch ((int)(info[6])) {
 			case 1 : std::cout << "   Stopped by small gradient J^T e"; break;
@@ -78,8 +113,6 @@ void LevMarOptimizer::optimize(std::vector<double> & parameters) {
 }
 
 void LevMarOptimizer::calculate(double * p, double * c) {
-	FUNCID(LevMarOptimizer::calculate);
-
 	SolverInput input = *m_input;
 
 	double penalty = 0;
@@ -131,38 +164,104 @@ void LevMarOptimizer::calculate(double * p, double * c) {
 
 	input.tEnd = 30*3600;
 
-	Solver solv;
-	try {
-		solv.init(input);
+	// probe series are only recorded by the full-order model
+	bool probes = false;
+	for (unsigned int k=0; k<m_series.size(); ++k)
+		probes = probes || (m_series[k].probe >= 0);
+
+	// outlet series are interpolated at their measured time points by observers while the solver runs,
+	// probe series afterwards from the sampled probe concentrations
+	std::vector<ResidualAccumulator> residuals;
+	for (unsigned int k=0; k<m_series.size(); ++k)
+		residuals.push_back(ResidualAccumulator(m_series[k].probe < 0 ? m_series[k].t : std::vector<double>()));
+
+	std::vector<double> probeT;
+	std::vector<std::vector<double> > probeC;
+	ResultFile cached;
+	if (input.reducedOrderFit && !probes) {
+		try {
+			m_reducedModel.run(input);
+			std::cout << std::endl;
+		}
+		catch (std::exception& ex) {
+			std::cout << "Error running the solver: "<< ex.what() << std::endl;
+			throw std::runtime_error("Can't continue minimization!");
+		}
+		replayOutlet(m_reducedModel.m_outletT.data(), m_reducedModel.m_outletC.data(),
+					 m_reducedModel.m_outletT.size(), residuals);
 	}
-	catch (std::exception& ex) {
-		std::cout << "Error initializing the solver: "<< ex.what() << std::endl;
-		throw std::runtime_error("Can't continiue minimization!");
+	else if (m_cache != nullptr && m_cache->find(input, cached)) {
+		std::cout << "Results taken from cache." << std::endl;
+		replayOutlet(cached.outletT(), cached.outletC(), cached.outletSize(), residuals);
+		probeT.assign(cached.probeT(), cached.probeT() + cached.probeSize());
+		for (unsigned int j=0; j<cached.probeCount(); ++j)
+			probeC.push_back(std::vector<double>(cached.probeC(j), cached.probeC(j) + cached.probeSize()));
 	}
+	else {
+		// probes are always sampled, so that a cache entry is complete for other uses of the input
+		Solver solv;
+		ProbeSampler probeSampler(input);
+		try {
+			solv.init(input);
+			solv.addObserver(&probeSampler);
+			for (unsigned int k=0; k<residuals.size(); ++k)
+				solv.addObserver(&residuals[k]);
+		}
+		catch (std::exception& ex) {
+			std::cout << "Error initializing the solver: "<< ex.what() << std::endl;
+			throw std::runtime_error("Can't continiue minimization!");
+		}
 
-	try {
-		solv.run();
-		std::cout << std::endl;
+		try {
+			solv.run();
+			std::cout << std::endl;
+		}
+		catch (std::exception& ex) {
+			std::cout << "Error running the solver: "<< ex.what() << std::endl;
+			throw std::runtime_error("Can't continue minimization!");
+		}
+		probeT = probeSampler.t();
+		for (unsigned int j=0; j<probeSampler.size(); ++j)
+			probeC.push_back(probeSampler.c(j));
+
+		if (m_cache != nullptr) {
+			try {
+				m_cache->store(input, solv, nullptr, &probeSampler);
+			}
+			catch (std::exception& ex) {
+				std::cout << "Warning: " << ex.what() << std::endl;
+			}
+		}
 	}
-	catch (std::exception& ex) {
-		std::cout << "Error running the solver: "<< ex.what() << std::endl;
-		throw std::runtime_error("Can't continue minimization!");
+
+	// compute concentrations at measurment locations, one series after another
+	for (unsigned int k=0; k<m_series.size(); ++k) {
+		if (m_series[k].probe < 0) {
+			for (unsigned int i=0; i<m_series[k].t.size(); ++i)
+				*c++ = m_series[k].weight*residuals[k].value(i) + penalty*penalty*1e6;
+		}
+		else
+			interpolate(m_series[k], probeT, probeC[m_series[k].probe], penalty, c);
 	}
+}
+
 
-	// compute concentrations at measurment locations
+void LevMarOptimizer::interpolate(const MeasuredSeries & series, const std::vector<double> & t,
+								  const std::vector<double> & cCalc, double penalty, double *& c) const
+{
+	FUNCID(LevMarOptimizer::interpolate);
 	IBK::LinearSpline spl;
 	try {
-		spl.setValues(solv.m_outletT, solv.m_outletC);
+		spl.setValues(t, cCalc);
 	} catch (IBK::Exception & ex) {
 		throw IBK::Exception(ex, "Error creating linear spline.", FUNC_ID);
 
 	}
 
 	// we need to interpolate the results at the measurement locations
-	for (unsigned int i=0; i<m_t.size(); ++i) {
-		double t = m_t[i];
-		double val = spl.value(t);
-		c[i] = val + penalty*penalty*1e6;
+	for (unsigned int i=0; i<series.t.size(); ++i) {
+		double val = spl.value(series.t[i]);
+		*c++ = series.weight*val + penalty*penalty*1e6;
 	}
 }
 
@@ -5,7 +5,10 @@
 
 #include <levmar.h>
 
+#include "podmodel.h"
+
 class SolverInput;
+class ResultCache;
 
 /// This class nicely wraps the call to the levmar library and the simulation solver.
 class LevMarOptimizer {
@@ -22,6 +25,20 @@ public:
 		PAR_beta
 	};
 
+	/// A measured concentration series, at the outlet or at a probe position.
+	struct MeasuredSeries {
+		/// Constructor.
+		MeasuredSeries(int probeIndex, const std::vector<double> & tMeas, const std::vector<double> & cMeas, double w = 1) :
+			probe(probeIndex), t(tMeas), c(cMeas), weight(w)
+		{
+		}
+
+		int						probe;	///< Index in SolverInput::probePositions, -1 for the outlet.
+		std::vector<double>		t;		///< Time points in h.
+		std::vector<double>		c;		///< Measured concentrations in kg/m3.
+		double					weight;	///< Factor for the residuals of the series.
+	};
+
 	/// Constructor, takes all properties required for the simulation later
 	/// as arguments.
 	/// @param input
@@ -29,6 +46,10 @@ public:
 		const std::vector<double> & t,
 		const std::vector<double> & c_out);
 
+	/// Constructor for fits against several measured series at once (outlet and/or probes). The weighted
+	/// residuals of all series are concatenated into one residual vector.
+	LevMarOptimizer(const SolverInput & input, const std::vector<MeasuredSeries> & series);
+
 	/// The main optimization function.
 	/// Call this function to optimize the parameters passed in the parameters vector.
 	/// Once the function returns the parameters vector contains the optimized parameters,
@@ -39,7 +60,7 @@ public:
 	/// Simulates the break-through curve using the parameters in p
 	/// and calculates solutions at points x.
 	/// @param p Contains the parameters adjusted by LevMar.
-	/// @param c Vector with calculated outlet concentrations.
+	/// @param c Vector with calculated concentrations of all series (multiplied with the series weights).
 	void calculate(double * p, double * c);
 
 	const SolverInput * m_input;	///< Pointer to original solver input data (the physical constants).
@@ -50,10 +71,24 @@ public:
 
 	std::vector<optimizable_parameter_t> optimizablePars;
 
+	/// Reduced-order model used for the evaluations if SolverInput::reducedOrderFit is set and only
+	/// the outlet series is fitted (probe series require the full-order model).
+	PODModel	m_reducedModel;
+
+	/// Cache consulted before each full-order evaluation, the results of new runs are stored in it
+	/// (nullptr: no cache).
+	ResultCache	*m_cache;
+
 private:
+	/// Appends the calculated concentrations of a probe series at its measured time points to c, multiplied
+	/// with the weight of the series (linear interpolation between the output time points t, cCalc).
+	/// Outlet series are evaluated by ResidualAccumulator observers instead.
+	void interpolate(const MeasuredSeries & series, const std::vector<double> & t,
+					 const std::vector<double> & cCalc, double penalty, double *& c) const;
+
 	std::vector<double>		m_p;	///< Contains the parameters to be optimized.
-	std::vector<double>		m_c;	///< Contains the outlet concentrations.
-	std::vector<double>		m_t;	///< Contains the time points of the measured outlet concentrations.
+	std::vector<double>		m_c;	///< Contains the weighted measured concentrations of all series.
+	std::vector<MeasuredSeries>	m_series;	///< Measured series.
 };
 
 /// Function that get's passed to the levmar library.
@@ -0,0 +1,46 @@
+#include "parallelfor.h"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <exception>
+
+#include <IBK_Exception.h>
+
+void parallelFor(unsigned int count, unsigned int threads, const std::function<void(unsigned int)> & fn) {
+	FUNCID(parallelFor);
+	std::atomic<unsigned int> next(0);
+	std::mutex errorMutex;
+	std::vector<std::pair<unsigned int, std::string> > errors;
+	auto worker = [&]() {
+		for (unsigned int i = next++; i < count; i = next++) {
+			try {
+				fn(i);
+			}
+			catch (std::exception & ex) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				errors.push_back(std::make_pair(i, std::string(ex.what())));
+			}
+		}
+	};
+
+	unsigned int nThreads = std::min(std::max(1u, threads), count);
+	std::vector<std::thread> workers;
+	for (unsigned int i=1; i<nThreads; ++i)
+		workers.push_back(std::thread(worker));
+	worker(); // the calling thread works as well
+	for (unsigned int i=0; i<workers.size(); ++i)
+		workers[i].join();
+
+	if (!errors.empty()) {
+		std::sort(errors.begin(), errors.end());
+		std::string errmsg = errors[0].second;
+		for (unsigned int k=1; k<errors.size(); ++k)
+			errmsg += "\n" + errors[k].second;
+		throw IBK::Exception(errmsg, FUNC_ID);
+	}
+}
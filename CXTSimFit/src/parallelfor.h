@@ -0,0 +1,12 @@
+#ifndef parallelfor_h
+#define parallelfor_h
+
+#include <functional>
+
+/// Calls fn(i) for i = 0, ..., count-1 with up to threads threads, the calling thread works as well.
+/// Each thread picks the next index until all indexes are done, so that expensive calls should come first.
+/// Exceptions thrown by fn do not stop the other calls; once all calls are done, an IBK::Exception with
+/// the messages of all failed calls (in index order) is thrown.
+void parallelFor(unsigned int count, unsigned int threads, const std::function<void(unsigned int)> & fn);
+
+#endif // parallelfor_h
@@ -0,0 +1,272 @@
+#include "parareal.h"
+
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+#include <IBK_Exception.h>
+
+#include "solver.h"
+#include "profilerecorder.h"
+#include "parallelfor.h"
+
+Parareal::Parareal(unsigned int slices, unsigned int threads) :
+	m_maxIterations(10),
+	m_tolerance(1),
+	m_coarsening(10),
+	m_iterations(0),
+	m_slices(std::max(1u, slices)),
+	m_threads(threads),
+	m_nVars(1),
+	m_coarseState(nullptr)
+{
+	if (m_threads == 0)
+		m_threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+Parareal::~Parareal() {
+	clear();
+}
+
+
+void Parareal::clear() {
+	for (unsigned int j=0; j<m_U.size(); ++j) {
+		N_VDestroy_Serial(m_U[j]);
+		N_VDestroy_Serial(m_G[j]);
+		N_VDestroy_Serial(m_F[j]);
+	}
+	m_U.clear();
+	m_G.clear();
+	m_F.clear();
+	if (m_coarseState != nullptr) {
+		N_VDestroy_Serial(m_coarseState);
+		m_coarseState = nullptr;
+	}
+}
+
+
+void Parareal::run(const SolverInput & input) {
+	FUNCID(Parareal::run);
+	if (input.engine != SolverInput::ENGINE_CVODE)
+		throw IBK::Exception("Parareal requires the CVODE engine.", FUNC_ID);
+	if (input.steadyState == SolverInput::SS_DIRECT)
+		throw IBK::Exception("Parareal requires a transient simulation.", FUNC_ID);
+
+	m_input = input;
+	m_input.activeWindow = false;
+	// slices must cover the whole time range
+	m_input.stopAtBreakthrough = false;
+	// slices run concurrently and their states are exchanged with serial vectors
+	m_input.threads = 1;
+	clear();
+
+	// slice boundaries on output time points
+	double dt_out = m_input.outputDt;
+	unsigned int outputs = static_cast<unsigned int>(std::ceil(m_input.tEnd/dt_out - 1e-10));
+	unsigned int outputsPerSlice = std::max(1u, (outputs + m_slices - 1)/m_slices);
+	m_slices = (outputs + outputsPerSlice - 1)/outputsPerSlice;
+	m_sliceT.resize(m_slices + 1);
+	for (unsigned int j=0; j<m_slices; ++j)
+		m_sliceT[j] = j*outputsPerSlice*dt_out;
+	m_sliceT[m_slices] = m_input.tEnd;
+
+	m_nVars = (m_input.model == SolverInput::PLUS_EXCHANGE) ? 2 : 1;
+	unsigned int nEquations = m_input.n*m_nVars;
+	m_coarseInput = m_input;
+	m_coarseInput.n = std::max(1u, m_input.n/std::max(1u, m_coarsening));
+	m_coarseState = N_VNew_Serial(m_coarseInput.n*m_nVars);
+	m_U.resize(m_slices + 1);
+	m_G.resize(m_slices + 1);
+	m_F.resize(m_slices + 1);
+	for (unsigned int j=0; j<=m_slices; ++j) {
+		m_U[j] = N_VNew_Serial(nEquations);
+		m_G[j] = N_VNew_Serial(nEquations);
+		m_F[j] = N_VNew_Serial(nEquations);
+		if (!m_U[j] || !m_G[j] || !m_F[j])
+			throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+	}
+	m_sliceResults.clear();
+	m_sliceResults.resize(m_slices);
+
+	// initial condition is completely empty, same as in Solver::init()
+	N_VConst(0, m_U[0]);
+
+	N_Vector coarse = N_VNew_Serial(nEquations);
+	N_Vector weights = N_VNew_Serial(nEquations);
+	// work vectors are released on all paths, also if a coarse or fine propagation throws
+	auto destroyWorkVectors = [&]() {
+		if (coarse != nullptr)
+			N_VDestroy_Serial(coarse);
+		if (weights != nullptr)
+			N_VDestroy_Serial(weights);
+	};
+	if (coarse == nullptr || weights == nullptr) {
+		destroyWorkVectors();
+		throw IBK::Exception("Work vector allocation error!", FUNC_ID);
+	}
+
+	try {
+		// initial coarse prediction
+		for (unsigned int j=0; j<m_slices; ++j) {
+			propagateCoarse(j, m_U[j], m_G[j]);
+			N_VScale(1, m_G[j], m_U[j+1]);
+		}
+
+		m_iterations = 0;
+		bool converged = false;
+		while (!converged && m_iterations < std::min(m_maxIterations, m_slices)) {
+			// after k iterations the first k slices start with the exact state
+			unsigned int k = m_iterations;
+			runFine(k);
+			++m_iterations;
+
+			// sequential correction
+			double change = 0;
+			for (unsigned int j=k; j<m_slices; ++j) {
+				// coarse propagation of the corrected start state (unchanged for the first slice)
+				if (j > k)
+					propagateCoarse(j, m_U[j], coarse);
+				else
+					N_VScale(1, m_G[j], coarse);
+				// U_j+1,new = G(U_j,new) + F(U_j,old) - G(U_j,old), stored in m_G[j]
+				N_VLinearSum(1, m_F[j], -1, m_G[j], m_G[j]);
+				N_VLinearSum(1, coarse, 1, m_G[j], m_G[j]);
+
+				// change of the start state, measured with the solver's error weights
+				N_VAbs(m_G[j], weights);
+				N_VScale(m_input.relTol, weights, weights);
+				N_VAddConst(weights, m_input.absTol, weights);
+				N_VInv(weights, weights);
+				N_VLinearSum(1, m_G[j], -1, m_U[j+1], m_U[j+1]);
+				change = std::max(change, N_VWrmsNorm(m_U[j+1], weights));
+
+				N_VScale(1, m_G[j], m_U[j+1]);
+				N_VScale(1, coarse, m_G[j]);
+			}
+			converged = (change < m_tolerance);
+		}
+		// fine runs of the unconverged slices used the previous start states, repeat them with
+		// the final start states if the iteration limit was hit
+		if (!converged && m_iterations < m_slices)
+			runFine(m_iterations);
+	}
+	catch (...) {
+		destroyWorkVectors();
+		throw;
+	}
+	destroyWorkVectors();
+
+	// concatenate slice results, the first output of each slice is the last output of the previous slice
+	m_outletT.clear();
+	m_outletC.clear();
+	ProfileRecorder profiles;
+	profiles.init(Solver::newProfileStore(m_input), m_input);
+	std::vector<double> cc(m_input.n), sc(m_input.n);
+	m_breakthroughT.assign(m_input.breakthroughFractions.size(), -1);
+	for (unsigned int j=0; j<m_slices; ++j) {
+		SliceResults & res = m_sliceResults[j];
+		// first crossing in the earliest slice
+		for (unsigned int k=0; k<m_breakthroughT.size(); ++k) {
+			if (m_breakthroughT[k] < 0)
+				m_breakthroughT[k] = res.breakthroughT[k];
+		}
+		unsigned int first = (j == 0) ? 0 : 1;
+		for (unsigned int i=first; i<res.outletT.size(); ++i) {
+			m_outletT.push_back(res.outletT[i]);
+			m_outletC.push_back(res.outletC[i]);
+		}
+		// the slices already follow the output schedule, with adaptive recording the change limit and the
+		// maximum number of profiles are applied again to the concatenated profiles
+		const ProfileStore & store = *profiles.store();
+		for (unsigned int i=0; i<res.profiles->size(); ++i) {
+			if (!store.empty() && std::fabs(res.profiles->t(i) - store.t().back()) < 1e-10)
+				continue;
+			res.profiles->profile(i, &cc[0], &sc[0]);
+			profiles.record(res.profiles->t(i), &cc[0], &sc[0], true, j + 1 == m_slices && i + 1 == res.profiles->size());
+		}
+		res.profiles.reset(); // slice profiles are no longer needed
+	}
+	m_profiles = profiles.store();
+}
+
+
+void Parareal::propagateFine(unsigned int j, N_Vector y0, N_Vector y1) {
+	SolverInput input = m_input;
+	input.tEnd = m_sliceT[j+1];
+
+	Solver solver;
+	ProfileRecorder profiles;
+	solver.init(input);
+	profiles.init(Solver::newProfileStore(input), input);
+	solver.addObserver(&profiles);
+	if (j > 0)
+		solver.setState(m_sliceT[j], y0);
+	solver.run();
+	// the solver state is not a serial vector (see Solver::newVector()), copy the data directly
+	const double * yEnd = N_VGetArrayPointer(solver.state());
+	std::copy(yEnd, yEnd + NV_LENGTH_S(y1), NV_DATA_S(y1));
+
+	SliceResults & res = m_sliceResults[j];
+	res.outletT = solver.m_outletT;
+	res.outletC = solver.m_outletC;
+	res.profiles = profiles.store();
+	res.breakthroughT = solver.m_breakthroughT;
+}
+
+
+void Parareal::propagateCoarse(unsigned int j, N_Vector y0, N_Vector y1) {
+	SolverInput input = m_coarseInput;
+	input.tEnd = m_sliceT[j+1];
+	unsigned int n = m_input.n;
+	unsigned int nc = input.n;
+
+	Solver solver;
+	solver.init(input);
+	if (j > 0) {
+		// restriction: average of the fine elements within each coarse element (conserves mass)
+		const double * yf = NV_DATA_S(y0);
+		double * yc = NV_DATA_S(m_coarseState);
+		N_VConst(0, m_coarseState);
+		std::vector<unsigned int> count(nc, 0);
+		for (unsigned int i=0; i<n; ++i) {
+			unsigned int ic = i*nc/n;
+			for (unsigned int k=0; k<m_nVars; ++k)
+				yc[ic*m_nVars + k] += yf[i*m_nVars + k];
+			++count[ic];
+		}
+		for (unsigned int ic=0; ic<nc; ++ic)
+			for (unsigned int k=0; k<m_nVars; ++k)
+				yc[ic*m_nVars + k] /= count[ic];
+		solver.setState(m_sliceT[j], m_coarseState);
+	}
+	solver.run();
+
+	// prolongation: linear interpolation between coarse element centers
+	const double * yc = N_VGetArrayPointer(solver.state());
+	double * yf = NV_DATA_S(y1);
+	for (unsigned int i=0; i<n; ++i) {
+		// position of the fine element center in coarse element coordinates
+		double x = (i + 0.5)*nc/n - 0.5;
+		x = std::min(std::max(x, 0.0), nc - 1.0);
+		unsigned int ic = std::min(static_cast<unsigned int>(x), nc - 1);
+		unsigned int ic2 = std::min(ic + 1, nc - 1);
+		double alpha = x - ic;
+		for (unsigned int k=0; k<m_nVars; ++k)
+			yf[i*m_nVars + k] = (1 - alpha)*yc[ic*m_nVars + k] + alpha*yc[ic2*m_nVars + k];
+	}
+}
+
+
+void Parareal::runFine(unsigned int first) {
+	FUNCID(Parareal::runFine);
+
+	try {
+		parallelFor(m_slices - first, m_threads, [&](unsigned int j) {
+			propagateFine(first + j, m_U[first + j], m_F[first + j]);
+		});
+	}
+	catch (IBK::Exception & ex) {
+		throw IBK::Exception(ex, "Fine propagation of a time slice failed.", FUNC_ID);
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef parareal_h
+#define parareal_h
+
+#include <vector>
+#include <memory>
+
+#include <nvector/nvector_serial.h>
+
+#include "solverinput.h"
+#include "profilestore.h"
+
+/// Parallel-in-time driver for long simulations (Parareal algorithm, Lions, Maday, Turinici, 2001).
+///
+/// The simulation time is split into time slices (ending on output time points). A coarse
+/// propagator (CVODE on a grid with fewer elements) sequentially computes initial states for all slices,
+/// afterwards the fine propagator (CVODE on the requested grid) runs on all slices
+/// concurrently. The slice start states are corrected with
+///   U_j+1 = G(U_j) + F(U_j,old) - G(U_j,old)
+/// until they no longer change, where G includes restriction to and prolongation from the coarse grid.
+/// After k iterations the first k slices are exact, hence the algorithm terminates after at most
+/// as many iterations as there are slices. The results are concatenated from the fine runs of
+/// the last iteration.
+/// Note: a coarse propagator with loose tolerance is not an option for this model, since CVODE
+/// needs many more steps at loose tolerances (clipping of negative mass densities).
+class Parareal {
+public:
+	/// Constructor.
+	/// @param slices Number of time slices.
+	/// @param threads Number of concurrent fine solver runs, 0 means number of cores.
+	Parareal(unsigned int slices, unsigned int threads = 0);
+	/// Destructor, releases slice states.
+	~Parareal();
+
+	/// Runs the simulation described by input (input.engine must be ENGINE_CVODE).
+	/// Throws an IBK::Exception if any of the solver runs fails.
+	void run(const SolverInput & input);
+
+	unsigned int		m_maxIterations;	///< Maximum number of Parareal iterations.
+	double				m_tolerance;		///< Convergence limit for the change of slice states (WRMS norm with solver tolerances).
+	unsigned int		m_coarsening;		///< Ratio of fine to coarse grid elements for the coarse propagator.
+
+	unsigned int		m_iterations;		///< Number of Parareal iterations performed in the last run.
+
+	std::vector<double>		m_outletT;	///< Vector with time points of outlet data in [h]
+	std::vector<double>		m_outletC;	///< Vector with concentrations at outlet in [kg/m3]
+	std::vector<double>		m_breakthroughT;	///< First crossing times of the breakthrough fractions in [h], -1 if not reached.
+
+	std::shared_ptr<const ProfileStore>	m_profiles;	///< Concentration profiles of all slices.
+
+private:
+	/// Integrates slice j on the fine grid, starting from state y0 and stores the
+	/// final state in y1. The outputs of the run are stored in the slice results.
+	void propagateFine(unsigned int j, N_Vector y0, N_Vector y1);
+
+	/// Integrates slice j on the coarse grid, starting from state y0 (fine grid) and stores the
+	/// final state in y1 (fine grid).
+	void propagateCoarse(unsigned int j, N_Vector y0, N_Vector y1);
+
+	/// Runs the fine propagator on slices first...m_slices-1 concurrently.
+	void runFine(unsigned int first);
+
+	/// Releases all slice states.
+	void clear();
+
+	unsigned int			m_slices;		///< Number of time slices.
+	unsigned int			m_threads;		///< Number of concurrent fine solver runs.
+	SolverInput				m_input;		///< Input data (with end time in s).
+	SolverInput				m_coarseInput;	///< Input data for the coarse propagator.
+	unsigned int			m_nVars;		///< Number of variables per element.
+	N_Vector				m_coarseState;	///< Coarse grid state used for restriction.
+	std::vector<double>		m_sliceT;		///< Slice boundaries in s (size m_slices+1).
+
+	std::vector<N_Vector>	m_U;			///< Slice start states.
+	std::vector<N_Vector>	m_G;			///< Coarse propagator results G(U_j) (end state of slice j).
+	std::vector<N_Vector>	m_F;			///< Fine propagator results F(U_j) (end state of slice j).
+
+	/// Outputs of the fine runs per slice (outlet time points, concentrations and profiles).
+	struct SliceResults {
+		std::vector<double>					outletT;
+		std::vector<double>					outletC;
+		std::shared_ptr<const ProfileStore>	profiles;
+		std::vector<double>					breakthroughT;
+	};
+	std::vector<SliceResults>	m_sliceResults;
+};
+
+#endif // parareal_h
@@ -0,0 +1,550 @@
+#include "podmodel.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include <cvode/cvode.h>
+#include <cvode/cvode_dense.h>
+
+#include <IBK_Exception.h>
+
+#include "solver.h"
+#include "profilerecorder.h"
+
+/// Data of the Galerkin-projected system a' = A a + cIn(t)*bInlet + bConst.
+struct ReducedSystem {
+	unsigned int			r;			///< Number of basis vectors (mobile and immobile phase).
+	std::vector<double>		A;			///< Projected Jacobian (r x r, row-wise).
+	std::vector<double>		bInlet;		///< Projected inlet vector.
+	std::vector<double>		bConst;		///< Projected sources/sinks.
+	std::vector<double>		outlet;		///< Outlet concentration per unit coefficient.
+	const Solver *			solver;		///< Full-order solver, provides the inlet concentration.
+};
+
+
+/// Collects the uncompressed profiles of all outputs of a full-order run as snapshots.
+class SnapshotCollector : public SolverObserver {
+public:
+	SnapshotCollector(std::vector<std::vector<double> > & ccSnapshots, std::vector<std::vector<double> > & scSnapshots) :
+		m_ccSnapshots(ccSnapshots), m_scSnapshots(scSnapshots)
+	{
+		m_ccSnapshots.clear();
+		m_scSnapshots.clear();
+	}
+
+	virtual unsigned int quantities() const { return Q_PROFILES; }
+	virtual void observe(const SolverOutput & out) {
+		m_t.push_back(out.t);
+		m_ccSnapshots.push_back(std::vector<double>(out.cc, out.cc + out.n));
+		m_scSnapshots.push_back(out.sc != nullptr ? std::vector<double>(out.sc, out.sc + out.n) : std::vector<double>());
+	}
+
+	std::vector<double>						m_t;			///< Time points of the snapshots in h.
+	std::vector<std::vector<double> > &		m_ccSnapshots;	///< Mobile phase profiles.
+	std::vector<std::vector<double> > &		m_scSnapshots;	///< Immobile phase profiles (empty for a single component).
+};
+
+
+// Wrapper function called from CVode solver for the reduced system.
+static int f_reduced(realtype t, N_Vector y, N_Vector ydot, void *f_data) {
+	const ReducedSystem * sys = static_cast<const ReducedSystem*>(f_data);
+	const double * a = NV_DATA_S(y);
+	double * adot = NV_DATA_S(ydot);
+	double cIn = sys->solver->inletConcentration(t);
+	for (unsigned int i=0; i<sys->r; ++i) {
+		double res = cIn*sys->bInlet[i] + sys->bConst[i];
+		const double * row = &sys->A[i*sys->r];
+		for (unsigned int j=0; j<sys->r; ++j)
+			res += row[j]*a[j];
+		adot[i] = res;
+	}
+	return 0;
+}
+
+
+// Jacobian of the reduced system, the constant projected Jacobian.
+static int jac_reduced(long int /*N*/, realtype /*t*/, N_Vector /*y*/, N_Vector /*fy*/, DlsMat Jac,
+					   void *user_data, N_Vector /*tmp1*/, N_Vector /*tmp2*/, N_Vector /*tmp3*/)
+{
+	const ReducedSystem * sys = static_cast<const ReducedSystem*>(user_data);
+	for (unsigned int j=0; j<sys->r; ++j) {
+		double * col = DENSE_COL(Jac, j);
+		for (unsigned int i=0; i<sys->r; ++i)
+			col[i] = sys->A[i*sys->r + j];
+	}
+	return 0;
+}
+
+
+/// Computes eigenvalues and eigenvectors of the symmetric matrix C (m x m, row-wise) with the cyclic
+/// Jacobi method. On return the diagonal of C holds the eigenvalues and the columns of V the eigenvectors.
+static void jacobiEigen(unsigned int m, std::vector<double> & C, std::vector<double> & V) {
+	V.assign(m*m, 0);
+	for (unsigned int i=0; i<m; ++i)
+		V[i*m + i] = 1;
+	for (unsigned int sweep=0; sweep<100; ++sweep) {
+		double off = 0;
+		double diag = 0;
+		for (unsigned int p=0; p<m; ++p) {
+			diag += C[p*m + p]*C[p*m + p];
+			for (unsigned int q=p+1; q<m; ++q)
+				off += C[p*m + q]*C[p*m + q];
+		}
+		if (off <= 1e-30*diag)
+			break;
+		for (unsigned int p=0; p<m; ++p) {
+			for (unsigned int q=p+1; q<m; ++q) {
+				double apq = C[p*m + q];
+				if (apq == 0)
+					continue;
+				// rotation angle that annihilates C(p,q)
+				double theta = (C[q*m + q] - C[p*m + p])/(2*apq);
+				double t = (theta >= 0 ? 1 : -1)/(std::fabs(theta) + std::sqrt(theta*theta + 1));
+				double c = 1/std::sqrt(t*t + 1);
+				double s = t*c;
+				for (unsigned int k=0; k<m; ++k) {
+					double ckp = C[k*m + p];
+					double ckq = C[k*m + q];
+					C[k*m + p] = c*ckp - s*ckq;
+					C[k*m + q] = s*ckp + c*ckq;
+				}
+				for (unsigned int k=0; k<m; ++k) {
+					double cpk = C[p*m + k];
+					double cqk = C[q*m + k];
+					C[p*m + k] = c*cpk - s*cqk;
+					C[q*m + k] = s*cpk + c*cqk;
+				}
+				for (unsigned int k=0; k<m; ++k) {
+					double vkp = V[k*m + p];
+					double vkq = V[k*m + q];
+					V[k*m + p] = c*vkp - s*vkq;
+					V[k*m + q] = s*vkp + c*vkq;
+				}
+			}
+		}
+	}
+}
+
+
+static double dot(const std::vector<double> & a, const std::vector<double> & b) {
+	double res = 0;
+	for (unsigned int i=0; i<a.size(); ++i)
+		res += a[i]*b[i];
+	return res;
+}
+
+
+/// Integrates the reduced system and stores the outlet concentrations at the output time points of the
+/// full-order model. If coefficients is not nullptr, the reduced solution at the profile output time
+/// points is stored as well. Returns false if the integration failed.
+static bool integrateReduced(ReducedSystem & sys, const SolverInput & input, std::vector<double> & outletC,
+							 std::vector<std::vector<double> > * coefficients)
+{
+	FUNCID(integrateReduced);
+	N_Vector a = N_VNew_Serial(sys.r);
+	if (!a)
+		throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+	N_VConst(0, a);
+	void * cvodeMem = CVodeCreate(CV_BDF, CV_NEWTON);
+	if (cvodeMem == nullptr) {
+		N_VDestroy_Serial(a);
+		throw IBK::Exception("CVodeCreate init error.", FUNC_ID);
+	}
+	int result = CVodeInit(cvodeMem, f_reduced, 0, a);
+	if (result != CV_SUCCESS) {
+		CVodeFree(&cvodeMem);
+		N_VDestroy_Serial(a);
+		throw IBK::Exception("CVodeInit init error.", FUNC_ID);
+	}
+	CVodeSetUserData(cvodeMem, (void*)&sys);
+	result = CVDense(cvodeMem, sys.r);
+	if (result != CVDLS_SUCCESS) {
+		CVodeFree(&cvodeMem);
+		N_VDestroy_Serial(a);
+		throw IBK::Exception("CVDense init error", FUNC_ID);
+	}
+	CVDlsSetDenseJacFn(cvodeMem, jac_reduced);
+	CVodeSetMaxOrd(cvodeMem, 5);
+	CVodeSetMaxNumSteps(cvodeMem, 100000);
+	CVodeSetMaxStep(cvodeMem, input.maxDt);
+	CVodeSetMinStep(cvodeMem, input.minDt);
+	CVodeSStolerances(cvodeMem, input.relTol, input.absTol);
+
+	// same output time points as in Solver::run()
+	outletC.clear();
+	if (coefficients != nullptr)
+		coefficients->clear();
+	// with adaptive profile recording every output is a candidate (see ProfileRecorder)
+	unsigned int outputN = (input.profileChange > 0) ? 1 : std::max(1u, input.outputN);
+	double t = 0;
+	unsigned int outputs = 0;
+	bool success = true;
+	while (true) {
+		const double * ad = NV_DATA_S(a);
+		double c = 0;
+		for (unsigned int k=0; k<sys.r; ++k)
+			c += sys.outlet[k]*ad[k];
+		outletC.push_back(std::max(0.0, c));
+		if (coefficients != nullptr && outputs % outputN == 0)
+			coefficients->push_back(std::vector<double>(ad, ad + sys.r));
+		++outputs;
+
+		if (t >= input.tEnd)
+			break;
+		result = CVode(cvodeMem, outputs*input.outputDt, a, &t, CV_NORMAL);
+		if (result < 0) {
+			success = false;
+			break;
+		}
+	}
+	CVodeFree(&cvodeMem);
+	N_VDestroy_Serial(a);
+	return success;
+}
+
+
+PODModel::PODModel() :
+	m_energyLimit(1 - 1e-10),
+	m_maxModes(100),
+	m_snapshotRefinement(4),
+	m_trainingRuns(1),
+	m_verificationInterval(10),
+	m_tolerance(1e-3),
+	m_maxFailedVerifications(3)
+{
+	clear();
+}
+
+
+void PODModel::clear() {
+	m_fullRuns = 0;
+	m_reducedRuns = 0;
+	m_enrichments = 0;
+	m_errorEstimate = 0;
+	m_verificationError = 0;
+	m_runs = 0;
+	m_failedVerifications = 0;
+	m_effectivity = 1;
+	m_modesC.clear();
+	m_sigmaC.clear();
+	m_modesS.clear();
+	m_sigmaS.clear();
+}
+
+
+bool PODModel::compatible(const SolverInput & input) const {
+	return input.n == m_input.n && input.model == m_input.model && input.tEnd == m_input.tEnd &&
+		input.outputDt == m_input.outputDt;
+}
+
+
+void PODModel::run(const SolverInput & input) {
+	if (!compatible(input))
+		clear();
+	m_input = input;
+	++m_runs;
+
+	std::vector<std::vector<double> > ccSnapshots, scSnapshots;
+	if (m_failedVerifications >= m_maxFailedVerifications) {
+		// the reduced-order model does not reach the requested accuracy, e.g. for sharp fronts
+		runFull(input, ccSnapshots, scSnapshots);
+		return;
+	}
+	if (input.steadyState == SolverInput::SS_DIRECT || input.steadyState == SolverInput::SS_INITIAL) {
+		// the reduced-order model always starts with an empty domain
+		runFull(input, ccSnapshots, scSnapshots);
+		return;
+	}
+	if (m_runs <= m_trainingRuns || m_modesC.empty()) {
+		runFull(input, ccSnapshots, scSnapshots);
+		updateBasis(m_modesC, m_sigmaC, ccSnapshots);
+		if (input.model == SolverInput::PLUS_EXCHANGE)
+			updateBasis(m_modesS, m_sigmaS, scSnapshots);
+		return;
+	}
+
+	bool reducedOk = runReduced(input);
+	bool verify = !reducedOk || m_effectivity*m_errorEstimate > m_tolerance ||
+		(m_verificationInterval > 0 && m_runs % m_verificationInterval == 0);
+	if (!verify) {
+		++m_reducedRuns;
+		return;
+	}
+
+	std::vector<double> reducedC = m_outletC;
+	runFull(input, ccSnapshots, scSnapshots);
+
+	// maximum deviation of the outlet concentrations, relative to the maximum outlet concentration
+	double maxC = 0;
+	double maxDev = 0;
+	for (unsigned int i=0; i<m_outletC.size(); ++i) {
+		maxC = std::max(maxC, std::fabs(m_outletC[i]));
+		if (i < reducedC.size())
+			maxDev = std::max(maxDev, std::fabs(m_outletC[i] - reducedC[i]));
+	}
+	m_verificationError = (maxC > 0) ? maxDev/maxC : maxDev;
+	// calibrate the error estimate with the actual deviation
+	if (reducedOk && m_errorEstimate > 0)
+		m_effectivity = std::min(10.0, std::max(0.1, m_verificationError/m_errorEstimate));
+	if (!reducedOk || reducedC.size() != m_outletC.size() || m_verificationError > m_tolerance) {
+		updateBasis(m_modesC, m_sigmaC, ccSnapshots);
+		if (input.model == SolverInput::PLUS_EXCHANGE)
+			updateBasis(m_modesS, m_sigmaS, scSnapshots);
+		++m_enrichments;
+		++m_failedVerifications;
+	}
+	else {
+		m_failedVerifications = 0;
+	}
+}
+
+
+void PODModel::runFull(const SolverInput & input, std::vector<std::vector<double> > & ccSnapshots,
+					   std::vector<std::vector<double> > & scSnapshots)
+{
+	FUNCID(PODModel::runFull);
+	// Store profiles at m_snapshotRefinement times as many output time points, profiles are cheap compared to
+	// the simulation. Since CVODE interpolates the outputs, the integration itself is not affected. The end time is
+	// rounded up to the last output time point of the original run.
+	unsigned int refinement = std::max(1u, m_snapshotRefinement);
+	SolverInput in = input;
+	in.outputN = 1;
+	in.outputDt = input.outputDt/refinement;
+	in.tEnd = std::ceil(input.tEnd/input.outputDt - 1e-10)*input.outputDt;
+	Solver solver;
+	SnapshotCollector snapshots(ccSnapshots, scSnapshots);
+	try {
+		solver.init(in);
+		solver.addObserver(&snapshots);
+		solver.run();
+	}
+	catch (IBK::Exception & ex) {
+		throw IBK::Exception(ex, "Error in full-order model run.", FUNC_ID);
+	}
+	++m_fullRuns;
+
+	// results as with the original output settings
+	m_outletT.clear();
+	m_outletC.clear();
+	ProfileRecorder profiles;
+	profiles.init(Solver::newProfileStore(input), input);
+	unsigned int outputN = std::max(1u, input.outputN);
+	for (unsigned int i=0; i<solver.m_outletT.size(); i += refinement) {
+		m_outletT.push_back(solver.m_outletT[i]);
+		m_outletC.push_back(solver.m_outletC[i]);
+		profiles.record(snapshots.m_t[i], &ccSnapshots[i][0], scSnapshots[i].empty() ? nullptr : &scSnapshots[i][0],
+						(i/refinement) % outputN == 0, i + refinement >= solver.m_outletT.size());
+	}
+	m_profiles = profiles.store();
+}
+
+
+void PODModel::updateBasis(std::vector<std::vector<double> > & modes, std::vector<double> & sigma,
+						   const std::vector<std::vector<double> > & snapshots)
+{
+	// Snapshots are added in chunks, so that the eigenvalue problems remain small. Each chunk is merged
+	// with the current basis, whose modes enter the snapshot matrix weighted with their singular values.
+	const unsigned int CHUNK_SIZE = 50;
+	for (unsigned int first=0; first<snapshots.size(); first += CHUNK_SIZE) {
+		std::vector<const std::vector<double> *> chunk;
+		for (unsigned int k=first; k<std::min<size_t>(first + CHUNK_SIZE, snapshots.size()); ++k) {
+			if (!snapshots[k].empty())
+				chunk.push_back(&snapshots[k]);
+		}
+		unsigned int r = modes.size();
+		unsigned int m = r + chunk.size();
+		if (m == 0)
+			continue;
+
+		// method of snapshots, eigenvalues of the correlation matrix are the squared singular values;
+		// the modes are orthonormal, hence their block is diagonal
+		std::vector<double> C(m*m, 0);
+		for (unsigned int i=0; i<r; ++i) {
+			C[i*m + i] = sigma[i]*sigma[i];
+			for (unsigned int j=0; j<chunk.size(); ++j)
+				C[i*m + r + j] = C[(r + j)*m + i] = sigma[i]*dot(modes[i], *chunk[j]);
+		}
+		for (unsigned int i=0; i<chunk.size(); ++i)
+			for (unsigned int j=i; j<chunk.size(); ++j)
+				C[(r + i)*m + r + j] = C[(r + j)*m + r + i] = dot(*chunk[i], *chunk[j]);
+		std::vector<double> V;
+		jacobiEigen(m, C, V);
+
+		std::vector<unsigned int> order(m);
+		for (unsigned int i=0; i<m; ++i)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&C, m](unsigned int a, unsigned int b) { return C[a*m + a] > C[b*m + b]; });
+		double total = 0;
+		for (unsigned int i=0; i<m; ++i)
+			total += std::max(0.0, C[i*m + i]);
+		if (total == 0)
+			continue;
+
+		std::vector<std::vector<double> > newModes;
+		std::vector<double> newSigma;
+		double lambdaMax = C[order[0]*m + order[0]];
+		double energy = 0;
+		unsigned int n = (r > 0) ? modes[0].size() : chunk[0]->size();
+		for (unsigned int k=0; k<m && newModes.size() < m_maxModes && energy < m_energyLimit*total; ++k) {
+			double lambda = C[order[k]*m + order[k]];
+			// eigenvalues close to the round-off limit of the correlation matrix yield inaccurate modes
+			if (lambda <= 1e-13*lambdaMax)
+				break;
+			energy += lambda;
+			std::vector<double> phi(n, 0);
+			for (unsigned int j=0; j<m; ++j) {
+				double v = V[j*m + order[k]];
+				if (j < r)
+					v *= sigma[j];
+				const std::vector<double> & x = (j < r) ? modes[j] : *chunk[j - r];
+				for (unsigned int i=0; i<n; ++i)
+					phi[i] += v*x[i];
+			}
+			// re-orthogonalize against previous modes (modified Gram-Schmidt)
+			for (unsigned int l=0; l<newModes.size(); ++l) {
+				double proj = dot(phi, newModes[l]);
+				for (unsigned int i=0; i<n; ++i)
+					phi[i] -= proj*newModes[l][i];
+			}
+			double norm = std::sqrt(dot(phi, phi));
+			if (norm < 1e-8*std::sqrt(lambda))
+				continue;
+			for (unsigned int i=0; i<n; ++i)
+				phi[i] /= norm;
+			newModes.push_back(phi);
+			newSigma.push_back(std::sqrt(lambda));
+		}
+		modes.swap(newModes);
+		sigma.swap(newSigma);
+	}
+}
+
+
+bool PODModel::runReduced(const SolverInput & input) {
+	unsigned int n = input.n;
+	unsigned int nVars = (input.model == SolverInput::PLUS_EXCHANGE) ? 2 : 1;
+	unsigned int nEquations = n*nVars;
+	unsigned int rc = m_modesC.size();
+	unsigned int rs = (nVars == 2) ? m_modesS.size() : 0;
+	unsigned int r = rc + rs;
+	if (rc == 0)
+		return false;
+
+	// the full-order solver provides the Jacobian and the affine terms of the model for the current parameters
+	SolverInput in = input;
+	in.engine = SolverInput::ENGINE_CVODE;
+	in.linearSolver = SolverInput::LES_GMRES; // no band matrix needed
+	in.activeWindow = false;
+	in.threads = 1;
+	Solver solver;
+	solver.init(in);
+	// the initial state is empty, hence the Jacobian is computed without clipping
+	solver.updateJacobian(N_VGetArrayPointer(solver.state()), N_VGetArrayPointer(solver.state()), 0);
+
+	// basis vector k in the full state (interleaved), component comp, values in the modes vector
+	std::vector<const std::vector<double> *> basis(r);
+	std::vector<unsigned int> comp(r);
+	for (unsigned int k=0; k<r; ++k) {
+		basis[k] = (k < rc) ? &m_modesC[k] : &m_modesS[k - rc];
+		comp[k] = (k < rc) ? 0 : 1;
+	}
+	// projection of a full state vector onto basis vector k
+	auto project = [&](unsigned int k, const std::vector<double> & v) {
+		const std::vector<double> & phi = *basis[k];
+		double res = 0;
+		for (unsigned int i=0; i<n; ++i)
+			res += phi[i]*v[i*nVars + comp[k]];
+		return res;
+	};
+
+	// Galerkin projection
+	ReducedSystem sys;
+	sys.r = r;
+	sys.solver = &solver;
+	sys.A.resize(r*r);
+	sys.bInlet.resize(r);
+	sys.bConst.resize(r);
+	sys.outlet.assign(r, 0);
+	std::vector<double> v(nEquations), Jv(nEquations), b(nEquations), bConst(nEquations);
+	for (unsigned int k=0; k<r; ++k) {
+		std::fill(v.begin(), v.end(), 0.0);
+		for (unsigned int i=0; i<n; ++i)
+			v[i*nVars + comp[k]] = (*basis[k])[i];
+		solver.jacobianTimesVector(&v[0], &Jv[0]);
+		for (unsigned int j=0; j<r; ++j)
+			sys.A[j*r + k] = project(j, Jv);
+	}
+	solver.affineTerms(&b[0], &bConst[0]);
+	for (unsigned int k=0; k<r; ++k) {
+		sys.bInlet[k] = project(k, b);
+		sys.bConst[k] = project(k, bConst);
+	}
+	for (unsigned int k=0; k<rc; ++k)
+		sys.outlet[k] = m_modesC[k][n-1]/input.Rc;
+
+	// Error estimate: the leading modes of both phases form a smaller reduced model, whose projected system
+	// is the leading part of the full projected system. The deviation of its outlet concentrations
+	// estimates the truncation error of the smaller model and thus usually overestimates the error
+	// of the reduced model with all modes.
+	std::vector<unsigned int> sel;
+	for (unsigned int k=0; k<r; ++k) {
+		if ((k < rc && k < (3*rc + 3)/4) || (k >= rc && k - rc < (3*rs + 3)/4))
+			sel.push_back(k);
+	}
+	ReducedSystem coarse;
+	coarse.r = sel.size();
+	coarse.solver = &solver;
+	coarse.A.resize(coarse.r*coarse.r);
+	for (unsigned int i=0; i<coarse.r; ++i) {
+		coarse.bInlet.push_back(sys.bInlet[sel[i]]);
+		coarse.bConst.push_back(sys.bConst[sel[i]]);
+		coarse.outlet.push_back(sys.outlet[sel[i]]);
+		for (unsigned int j=0; j<coarse.r; ++j)
+			coarse.A[i*coarse.r + j] = sys.A[sel[i]*r + sel[j]];
+	}
+	std::vector<double> coarseOutletC;
+	std::vector<std::vector<double> > coefficients;
+	if (!integrateReduced(coarse, input, coarseOutletC, nullptr) ||
+		!integrateReduced(sys, input, m_outletC, &coefficients))
+	{
+		return false;
+	}
+
+	double maxC = 0;
+	double maxDev = 0;
+	for (unsigned int i=0; i<m_outletC.size(); ++i) {
+		maxC = std::max(maxC, m_outletC[i]);
+		maxDev = std::max(maxDev, std::fabs(m_outletC[i] - coarseOutletC[i]));
+	}
+	m_errorEstimate = (maxC > 0) ? maxDev/maxC : maxDev;
+
+	// outputs like Solver::storeOutput(), profiles are reconstructed from the basis
+	m_outletT.clear();
+	for (unsigned int i=0; i<m_outletC.size(); ++i)
+		m_outletT.push_back(i*input.outputDt/3600);
+	ProfileRecorder profiles;
+	profiles.init(Solver::newProfileStore(input), input);
+	unsigned int outputN = (input.profileChange > 0) ? 1 : std::max(1u, input.outputN); // see integrateReduced()
+	std::vector<double> y(nEquations);
+	for (unsigned int j=0; j<coefficients.size(); ++j) {
+		const std::vector<double> & a = coefficients[j];
+		std::fill(y.begin(), y.end(), 0.0);
+		for (unsigned int k=0; k<r; ++k) {
+			const std::vector<double> & phi = *basis[k];
+			for (unsigned int i=0; i<n; ++i)
+				y[i*nVars + comp[k]] += phi[i]*a[k];
+		}
+		std::vector<double> cc(n), sc;
+		for (unsigned int i=0; i<n; ++i)
+			cc[i] = std::max(0.0, y[i*nVars]/input.Rc);
+		if (nVars == 2) {
+			sc.resize(n);
+			for (unsigned int i=0; i<n; ++i)
+				sc[i] = std::max(0.0, y[i*nVars + 1]/input.Rs);
+		}
+		profiles.record(m_outletT[j*outputN], &cc[0], sc.empty() ? nullptr : &sc[0], true, j + 1 == coefficients.size());
+	}
+	m_profiles = profiles.store();
+	return true;
+}
@@ -0,0 +1,91 @@
+#ifndef podmodel_h
+#define podmodel_h
+
+#include <vector>
+#include <memory>
+
+#include "solverinput.h"
+#include "profilestore.h"
+
+class Solver;
+
+/// Reduced-order model for repeated simulations with varying parameters (e.g. during fits).
+///
+/// The profiles of full-order runs (Solver) are used as snapshots. A proper orthogonal
+/// decomposition (POD, method of snapshots) yields separate bases for the mobile and the
+/// immobile phase. Subsequent runs integrate the Galerkin projection of the model onto these
+/// bases, i.e. a small dense system of ODEs, whose size does not depend on the number of elements.
+/// The projected system is the linear model without clipping of negative mass densities.
+///
+/// Every m_verificationInterval-th run is verified against the full-order model. If the deviation
+/// of the outlet concentrations exceeds m_tolerance, the snapshots of the full-order run are added
+/// to the basis (enrichment). Between verifications, the outlet concentrations of a reduced model with
+/// only the leading three quarters of the modes serve as error estimate. The estimate is scaled with the ratio
+/// of actual to estimated deviation found in the last verification. If it exceeds m_tolerance, the run is
+/// verified as well. If the enriched basis still fails m_maxFailedVerifications verifications
+/// in a row (transport-dominated runs with sharp fronts need too many modes), only the full-order model is used.
+///
+/// Changes of the grid, model or time settings discard the basis.
+class PODModel {
+public:
+	/// Constructor.
+	PODModel();
+
+	/// Runs the simulation described by input with the reduced-order model or, if needed, with
+	/// the full-order model. Results are stored in the output vectors below.
+	/// Throws an IBK::Exception if the full-order run fails.
+	void run(const SolverInput & input);
+
+	/// Discards the basis and resets all counters.
+	void clear();
+
+	double					m_energyLimit;			///< Fraction of snapshot energy captured by the basis.
+	unsigned int			m_maxModes;				///< Maximum number of basis vectors per phase.
+	unsigned int			m_snapshotRefinement;	///< Ratio of snapshots to outputs in full-order runs.
+	unsigned int			m_trainingRuns;			///< Number of full-order runs before the reduced model is used.
+	unsigned int			m_verificationInterval;	///< Every nth run is verified against the full model, 0 disables verification.
+	double					m_tolerance;			///< Permitted outlet deviation relative to the maximum outlet concentration.
+	unsigned int			m_maxFailedVerifications;	///< After this many failed verifications in a row only the full model is used.
+
+	unsigned int			m_fullRuns;				///< Number of full-order runs.
+	unsigned int			m_reducedRuns;			///< Number of runs with results from the reduced-order model.
+	unsigned int			m_enrichments;			///< Number of basis updates after failed verifications.
+	double					m_errorEstimate;		///< Estimated relative outlet deviation of the last reduced-order run.
+	double					m_verificationError;	///< Relative outlet deviation found in the last verification.
+
+	std::vector<double>		m_outletT;	///< Vector with time points of outlet data in [h]
+	std::vector<double>		m_outletC;	///< Vector with concentrations at outlet in [kg/m3]
+
+	std::shared_ptr<const ProfileStore>	m_profiles;	///< Concentration profiles of the last run.
+
+private:
+	/// Runs the full-order model and stores its results. The profiles at all output time points and
+	/// in between (see m_snapshotRefinement) are returned as snapshots.
+	void runFull(const SolverInput & input, std::vector<std::vector<double> > & ccSnapshots,
+				 std::vector<std::vector<double> > & scSnapshots);
+
+	/// Runs the reduced-order model, stores its results and computes the error estimate.
+	/// Returns false if the integration of the reduced system failed.
+	bool runReduced(const SolverInput & input);
+
+	/// Adds the snapshots to the basis of one phase and recomputes the POD.
+	/// The previous basis enters the new decomposition as modes weighted with their singular values,
+	/// so that no snapshots need to be stored.
+	void updateBasis(std::vector<std::vector<double> > & modes, std::vector<double> & sigma,
+					 const std::vector<std::vector<double> > & snapshots);
+
+	/// Returns true if the basis was computed for a compatible input.
+	bool compatible(const SolverInput & input) const;
+
+	SolverInput							m_input;		///< Input the basis was computed for.
+	unsigned int						m_runs;			///< Number of runs since the basis was discarded.
+	unsigned int						m_failedVerifications;	///< Number of failed verifications in a row.
+	double								m_effectivity;	///< Ratio of actual to estimated deviation found in the last verification.
+
+	std::vector<std::vector<double> >	m_modesC;		///< Basis vectors of the mobile phase (n values each).
+	std::vector<double>					m_sigmaC;		///< Singular values of the mobile phase modes.
+	std::vector<std::vector<double> >	m_modesS;		///< Basis vectors of the immobile phase (n values each).
+	std::vector<double>					m_sigmaS;		///< Singular values of the immobile phase modes.
+};
+
+#endif // podmodel_h
@@ -0,0 +1,150 @@
+#include "profilerecorder.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "solverstatistics.h"
+
+ProfileRecorder::ProfileRecorder() :
+	m_change(0),
+	m_norm(SolverInput::PCN_MAX),
+	m_maxProfiles(0),
+	m_stride(1),
+	m_scheduledCount(0)
+{
+}
+
+
+void ProfileRecorder::init(const std::shared_ptr<ProfileStore> & store, const SolverInput & input) {
+	m_store = store;
+	m_change = input.profileChange;
+	m_norm = input.profileChangeNorm;
+	m_maxProfiles = input.maxProfiles;
+	m_last.clear();
+	m_stride = 1;
+	m_scheduledCount = 0;
+}
+
+
+bool ProfileRecorder::record(double t, const double * cc, const double * sc, bool scheduled, bool last) {
+	unsigned int index = 0;
+	if (m_change == 0 && scheduled)
+		index = m_scheduledCount++;
+	if (!last && !accepted(cc, sc, scheduled, index))
+		return false;
+	if (m_maxProfiles > 0 && m_store->size() >= m_maxProfiles) {
+		thin();
+		// the thinned snapshots use a larger change limit or stride
+		if (!last && !accepted(cc, sc, scheduled, index))
+			return false;
+		if (m_store->size() >= m_maxProfiles) {
+			// only possible with a single snapshot, which is replaced by the last output
+			if (!last)
+				return false;
+			rebuild(std::vector<bool>(m_store->size(), false));
+		}
+	}
+	if (m_change > 0) {
+		// keep the uncompressed profiles as reference
+		unsigned int n = m_store->n();
+		m_last.assign(cc, cc + n);
+		if (m_store->hasSc())
+			m_last.insert(m_last.end(), sc, sc + n);
+	}
+	m_store->append(t, cc, sc);
+	return true;
+}
+
+
+void ProfileRecorder::observe(const SolverOutput & out) {
+	record(out.t, out.cc, out.sc, out.scheduled, out.last);
+}
+
+
+void ProfileRecorder::statistics(SolverStatistics & stats) const {
+	stats.profileSnapshots = m_store->size();
+	stats.profileBytes = m_store->bytes();
+	stats.profileRawBytes = m_store->size()*m_store->rawSnapshotBytes();
+}
+
+
+double ProfileRecorder::change(const std::vector<double> & ref, const double * cc, const double * sc) const {
+	unsigned int n = m_store->n();
+	double maxDiff = 0;
+	double sumSquares = 0;
+	for (unsigned int i=0; i<ref.size(); ++i) {
+		double diff = (i < n) ? cc[i] - ref[i] : sc[i - n] - ref[i];
+		maxDiff = std::max(maxDiff, std::fabs(diff));
+		sumSquares += diff*diff;
+	}
+	if (m_norm == SolverInput::PCN_RMS)
+		return std::sqrt(sumSquares/ref.size());
+	return maxDiff;
+}
+
+
+bool ProfileRecorder::accepted(const double * cc, const double * sc, bool scheduled, unsigned int index) const {
+	if (m_change > 0)
+		return m_last.empty() || change(m_last, cc, sc) > m_change;
+	return scheduled && index % m_stride == 0;
+}
+
+
+void ProfileRecorder::thin() {
+	unsigned int n = m_store->n();
+	std::vector<double> cc(n), sc(m_store->hasSc() ? n : 0);
+	double * scPtr = sc.empty() ? nullptr : &sc[0];
+	while (m_store->size() >= m_maxProfiles && m_store->size() > 1) {
+		std::vector<bool> keep(m_store->size(), false);
+		keep[0] = true;
+		if (m_change > 0) {
+			// filter the stored snapshots again with twice the change limit
+			m_change *= 2;
+			std::vector<double> ref;
+			unsigned int kept = 0;
+			for (unsigned int k=0; k<m_store->size(); ++k) {
+				m_store->profile(k, &cc[0], scPtr);
+				if (k > 0 && change(ref, &cc[0], scPtr) <= m_change)
+					continue;
+				keep[k] = true;
+				++kept;
+				ref.assign(cc.begin(), cc.end());
+				ref.insert(ref.end(), sc.begin(), sc.end());
+			}
+			// a steep front may exceed the new limit between nearly all snapshots, then every second
+			// snapshot is dropped instead, so that no more than half of them are lost
+			if (kept < m_store->size()/2) {
+				for (unsigned int k=0; k<m_store->size(); ++k)
+					keep[k] = (k % 2 == 0);
+			}
+		}
+		else {
+			// stored snapshots are the multiples of m_stride among the scheduled outputs
+			m_stride *= 2;
+			for (unsigned int k=0; k<m_store->size(); k += 2)
+				keep[k] = true;
+		}
+		rebuild(keep);
+	}
+}
+
+
+void ProfileRecorder::rebuild(const std::vector<bool> & keep) {
+	unsigned int n = m_store->n();
+	ProfileStore thinned(n, m_store->hasSc() ? 2 : 1, m_store->storage(), m_store->compression(), m_store->tolerance());
+	std::vector<double> cc(n), sc(m_store->hasSc() ? n : 0);
+	double * scPtr = sc.empty() ? nullptr : &sc[0];
+	m_last.clear();
+	for (unsigned int k=0; k<m_store->size(); ++k) {
+		if (!keep[k])
+			continue;
+		// decoded values are encoded again without further loss (quantized values stay on the grid)
+		m_store->profile(k, &cc[0], scPtr);
+		thinned.append(m_store->t(k), &cc[0], scPtr);
+		if (m_change > 0) {
+			m_last.assign(cc.begin(), cc.end());
+			m_last.insert(m_last.end(), sc.begin(), sc.end());
+		}
+	}
+	m_store->swap(thinned);
+}
@@ -0,0 +1,77 @@
+#ifndef profilerecorder_h
+#define profilerecorder_h
+
+#include <vector>
+#include <memory>
+
+#include "solverinput.h"
+#include "profilestore.h"
+#include "solverobserver.h"
+
+/// Decides which output profiles are stored as snapshots.
+///
+/// Without a change limit (SolverInput::profileChange = 0), the profiles of every outputN-th output
+/// are stored. With a change limit, every output is a candidate and its profile is stored if it differs
+/// from the last stored profile by more than the limit (maximum or RMS norm of the differences of
+/// mobile and immobile phase concentrations), so that snapshots follow the front and none are stored
+/// while the profiles do not change. The last output of a run is always stored.
+///
+/// At most SolverInput::maxProfiles snapshots are stored. Once the limit is reached, the stored snapshots
+/// are thinned, so that they still cover the whole run: with a change limit the limit is doubled and the
+/// stored snapshots are filtered again (every second snapshot is dropped if the filter would remove more
+/// than half of them), on the fixed schedule every second snapshot is dropped and only every second
+/// scheduled output is stored from then on.
+///
+/// Attached to a solver (see Solver::addObserver()) the recorder stores the profiles of the run, drivers
+/// that assemble profiles from several runs call record() directly.
+class ProfileRecorder : public SolverObserver {
+public:
+	/// Constructor.
+	ProfileRecorder();
+
+	/// Starts recording into store with the settings of input.
+	void init(const std::shared_ptr<ProfileStore> & store, const SolverInput & input);
+
+	/// Offers the profiles at time point t in h (sc is ignored for a single component).
+	/// @param scheduled True if the output is one of the every outputN-th outputs.
+	/// @param last True for the last output of the run, which is always stored.
+	/// @return Returns true if the profiles were stored.
+	bool record(double t, const double * cc, const double * sc, bool scheduled, bool last = false);
+
+	/// Returns the store the profiles are recorded into.
+	const std::shared_ptr<ProfileStore> & store() const { return m_store; }
+
+	virtual unsigned int quantities() const { return Q_PROFILES; }
+	virtual void observe(const SolverOutput & out);
+	/// Adds number and size of the stored snapshots.
+	virtual void statistics(SolverStatistics & stats) const;
+
+private:
+	/// Returns the norm of the difference of the profiles to the reference profiles ref (n values mobile,
+	/// n values immobile phase).
+	double change(const std::vector<double> & ref, const double * cc, const double * sc) const;
+
+	/// Returns true if the profiles pass the change limit or, on the fixed schedule, if the output is
+	/// scheduled and index (its number among the scheduled outputs) is a multiple of m_stride.
+	bool accepted(const double * cc, const double * sc, bool scheduled, unsigned int index) const;
+
+	/// Thins the stored snapshots until fewer than m_maxProfiles are left (or a single one).
+	void thin();
+
+	/// Replaces the stored snapshots by those with keep[k] set and updates m_last.
+	void rebuild(const std::vector<bool> & keep);
+
+	std::shared_ptr<ProfileStore>		m_store;		///< Store for the snapshots.
+	/// Change limit in kg/m3, 0 for the fixed schedule (doubled by thinning).
+	double								m_change;
+	SolverInput::profileChangeNorm_t	m_norm;			///< Norm of the change.
+	unsigned int						m_maxProfiles;	///< Maximum number of snapshots, 0 means unlimited.
+	/// Last stored profiles (n values mobile, n values immobile phase), only with a change limit.
+	std::vector<double>					m_last;
+	/// Fixed schedule: only every m_stride-th scheduled output is stored (doubled by thinning).
+	unsigned int						m_stride;
+	/// Fixed schedule: number of scheduled outputs offered so far.
+	unsigned int						m_scheduledCount;
+};
+
+#endif // profilerecorder_h
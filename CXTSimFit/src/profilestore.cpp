@@ -0,0 +1,369 @@
+#include "profilestore.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <unistd.h>
+	#include <sys/mman.h>
+#endif
+
+#include <IBK_Exception.h>
+#include <IBK_FormatString.h>
+
+/// Appends v as variable-length integer (7 bits per byte, least significant first).
+static void putVarint(std::vector<unsigned char> & buf, uint64_t v) {
+	while (v >= 0x80) {
+		buf.push_back(static_cast<unsigned char>(v | 0x80));
+		v >>= 7;
+	}
+	buf.push_back(static_cast<unsigned char>(v));
+}
+
+
+/// Reads a variable-length integer written by putVarint() and advances p.
+static uint64_t getVarint(const unsigned char *& p) {
+	uint64_t v = 0;
+	for (unsigned int shift=0; ; shift += 7) {
+		unsigned char b = *p++;
+		v |= static_cast<uint64_t>(b & 0x7f) << shift;
+		if (b < 0x80)
+			return v;
+	}
+}
+
+
+ProfileStore::ProfileStore(unsigned int n, unsigned int components, storage_t storage,
+						   compression_t compression, double tolerance) :
+	m_n(n),
+	m_components(components),
+	m_storage(storage),
+	m_compression(compression),
+	m_tolerance(tolerance),
+	m_offsets(1, 0),
+	m_data(nullptr),
+	m_capacity(0),
+	m_decodedIndex(-1),
+	m_maxCc(0),
+	m_maxSc(0)
+{
+	FUNCID(ProfileStore::ProfileStore);
+	if (components != 1 && components != 2)
+		throw IBK::Exception("Invalid number of profile components.", FUNC_ID);
+	if (compression == COMPRESSION_QUANTIZED && !(tolerance > 0))
+		throw IBK::Exception("The quantized profile compression requires a positive tolerance.", FUNC_ID);
+	if (compression != COMPRESSION_NONE) {
+		m_previous.resize(components*n);
+		m_residuals.resize(n);
+		m_decoded.resize(components*n);
+	}
+#if defined(_WIN32)
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = nullptr;
+#else
+	m_file = -1;
+#endif
+	if (storage == STORAGE_MAPPED_FILE) {
+#if defined(_WIN32)
+		char path[MAX_PATH], fname[MAX_PATH];
+		if (GetTempPathA(MAX_PATH, path) == 0 || GetTempFileNameA(path, "cxt", 0, fname) == 0)
+			throw IBK::Exception("Cannot create temporary file for profiles.", FUNC_ID);
+		// the file is removed once the handle is closed
+		m_file = CreateFileA(fname, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+							 FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			throw IBK::Exception(IBK::FormatString("Cannot create temporary file '%1' for profiles.").arg(fname), FUNC_ID);
+#else
+		const char * tmpdir = std::getenv("TMPDIR");
+		std::string fname = std::string((tmpdir != nullptr && *tmpdir != 0) ? tmpdir : "/tmp") + "/cxtsimfit_profiles_XXXXXX";
+		std::vector<char> buf(fname.begin(), fname.end());
+		buf.push_back(0);
+		m_file = mkstemp(&buf[0]);
+		if (m_file == -1)
+			throw IBK::Exception(IBK::FormatString("Cannot create temporary file '%1' for profiles.").arg(fname), FUNC_ID);
+		// the file is removed once the descriptor is closed
+		unlink(&buf[0]);
+#endif
+	}
+}
+
+
+ProfileStore::~ProfileStore() {
+	release();
+#if defined(_WIN32)
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+#else
+	if (m_file != -1)
+		close(m_file);
+#endif
+}
+
+
+void ProfileStore::append(double t, const double * cc, const double * sc) {
+	if (m_n > 0) {
+		m_maxCc = std::max(m_maxCc, *std::max_element(cc, cc + m_n));
+		if (m_components == 2)
+			m_maxSc = std::max(m_maxSc, *std::max_element(sc, sc + m_n));
+	}
+
+	if (m_compression == COMPRESSION_NONE) {
+		m_encoded.resize(rawSnapshotBytes());
+		if (m_n > 0) {
+			std::memcpy(&m_encoded[0], cc, m_n*sizeof(double));
+			if (m_components == 2)
+				std::memcpy(&m_encoded[0] + m_n*sizeof(double), sc, m_n*sizeof(double));
+		}
+	}
+	else {
+		m_encoded.clear();
+		bool keyframe = (m_t.size() % KEYFRAME_INTERVAL == 0);
+		unsigned int width = (m_compression == COMPRESSION_FLOAT32) ? 4 : 8;
+		for (unsigned int c=0; c<m_components; ++c) {
+			const double * v = (c == 0) ? cc : sc;
+			uint64_t * prev = &m_previous[0] + c*m_n;
+			// residuals of the prediction, the references are replaced by the new values
+			std::vector<uint64_t> & res = m_residuals;
+			for (unsigned int i=0; i<m_n; ++i) {
+				uint64_t u = encodeValue(v[i]);
+				uint64_t ref = keyframe ? (i == 0 ? 0 : prev[i-1]) : prev[i];
+				if (m_compression == COMPRESSION_QUANTIZED) {
+					int64_t d = static_cast<int64_t>(u - ref);
+					res[i] = (static_cast<uint64_t>(d) << 1) ^ static_cast<uint64_t>(d >> 63); // zig-zag
+				}
+				else
+					res[i] = u ^ ref;
+				prev[i] = u;
+			}
+			// runs of zero residuals (even header) and of non-zero residuals (odd header)
+			for (unsigned int i=0; i<m_n; ) {
+				unsigned int j = i;
+				while (j < m_n && res[j] == 0)
+					++j;
+				if (j > i) {
+					putVarint(m_encoded, 2*static_cast<uint64_t>(j - i));
+					i = j;
+					continue;
+				}
+				while (j < m_n && res[j] != 0)
+					++j;
+				putVarint(m_encoded, 2*static_cast<uint64_t>(j - i) + 1);
+				for (; i<j; ++i) {
+					uint64_t r = res[i];
+					if (m_compression == COMPRESSION_QUANTIZED) {
+						putVarint(m_encoded, r);
+						continue;
+					}
+					// XOR residual: leading and trailing zero bytes are dropped
+					unsigned int lz = 0, tz = 0;
+					while (((r >> 8*(width - 1 - lz)) & 0xff) == 0)
+						++lz;
+					while (((r >> 8*tz) & 0xff) == 0)
+						++tz;
+					m_encoded.push_back(static_cast<unsigned char>(lz << 4 | tz));
+					for (int b=width - 1 - lz; b >= static_cast<int>(tz); --b)
+						m_encoded.push_back(static_cast<unsigned char>(r >> 8*b));
+				}
+			}
+		}
+	}
+
+	size_t bytes = m_encoded.size();
+	size_t offset = m_offsets.back();
+	if (offset + bytes > m_capacity)
+		reserve(std::max(offset + bytes, std::max<size_t>(4096, 2*m_capacity)));
+	if (bytes > 0)
+		std::memcpy(m_data + offset, &m_encoded[0], bytes);
+	m_offsets.push_back(offset + bytes);
+	m_t.push_back(t);
+}
+
+
+void ProfileStore::clear() {
+	m_t.clear();
+	m_offsets.assign(1, 0);
+	m_decodedIndex = -1;
+	m_maxCc = 0;
+	m_maxSc = 0;
+}
+
+
+void ProfileStore::swap(ProfileStore & other) {
+	std::swap(m_n, other.m_n);
+	std::swap(m_components, other.m_components);
+	std::swap(m_storage, other.m_storage);
+	std::swap(m_compression, other.m_compression);
+	std::swap(m_tolerance, other.m_tolerance);
+	m_t.swap(other.m_t);
+	m_offsets.swap(other.m_offsets);
+	std::swap(m_data, other.m_data);
+	std::swap(m_capacity, other.m_capacity);
+	m_previous.swap(other.m_previous);
+	m_residuals.swap(other.m_residuals);
+	m_encoded.swap(other.m_encoded);
+	m_decoded.swap(other.m_decoded);
+	std::swap(m_decodedIndex, other.m_decodedIndex);
+	std::swap(m_maxCc, other.m_maxCc);
+	std::swap(m_maxSc, other.m_maxSc);
+	std::swap(m_file, other.m_file);
+#if defined(_WIN32)
+	std::swap(m_mapping, other.m_mapping);
+#endif
+}
+
+
+void ProfileStore::profile(unsigned int k, double * cc, double * sc) const {
+	if (m_compression == COMPRESSION_NONE) {
+		const unsigned char * src = m_data + m_offsets[k];
+		std::memcpy(cc, src, m_n*sizeof(double));
+		if (sc != nullptr && m_components == 2)
+			std::memcpy(sc, src + m_n*sizeof(double), m_n*sizeof(double));
+		return;
+	}
+	// continue from the last decoded snapshot if possible, otherwise start at the keyframe
+	unsigned int first = k - k % KEYFRAME_INTERVAL;
+	if (m_decodedIndex >= static_cast<int>(first) && m_decodedIndex <= static_cast<int>(k))
+		first = m_decodedIndex + 1;
+	for (unsigned int j=first; j<=k; ++j)
+		decode(j);
+	m_decodedIndex = k;
+	for (unsigned int i=0; i<m_n; ++i)
+		cc[i] = decodeValue(m_decoded[i]);
+	if (sc != nullptr && m_components == 2) {
+		for (unsigned int i=0; i<m_n; ++i)
+			sc[i] = decodeValue(m_decoded[m_n + i]);
+	}
+}
+
+
+void ProfileStore::decode(unsigned int k) const {
+	const unsigned char * p = m_data + m_offsets[k];
+	bool keyframe = (k % KEYFRAME_INTERVAL == 0);
+	unsigned int width = (m_compression == COMPRESSION_FLOAT32) ? 4 : 8;
+	for (unsigned int c=0; c<m_components; ++c) {
+		uint64_t * u = &m_decoded[0] + c*m_n;
+		for (unsigned int i=0; i<m_n; ) {
+			uint64_t header = getVarint(p);
+			unsigned int end = i + static_cast<unsigned int>(header >> 1);
+			for (; i<end; ++i) {
+				uint64_t r = 0;
+				if (header & 1) {
+					if (m_compression == COMPRESSION_QUANTIZED) {
+						r = getVarint(p);
+					}
+					else {
+						unsigned int lz = *p >> 4;
+						unsigned int tz = *p++ & 0x0f;
+						for (int b=width - 1 - lz; b >= static_cast<int>(tz); --b)
+							r |= static_cast<uint64_t>(*p++) << 8*b;
+					}
+				}
+				uint64_t ref = keyframe ? (i == 0 ? 0 : u[i-1]) : u[i];
+				if (m_compression == COMPRESSION_QUANTIZED)
+					u[i] = ref + ((r >> 1) ^ (0 - (r & 1)));
+				else
+					u[i] = ref ^ r;
+			}
+		}
+	}
+}
+
+
+uint64_t ProfileStore::encodeValue(double v) const {
+	FUNCID(ProfileStore::encodeValue);
+	switch (m_compression) {
+		case COMPRESSION_FLOAT32 : {
+			float f = static_cast<float>(v);
+			uint32_t bits;
+			std::memcpy(&bits, &f, sizeof(bits));
+			return bits;
+		}
+		case COMPRESSION_QUANTIZED : {
+			double q = std::floor(v/(2*m_tolerance) + 0.5);
+			if (!(std::fabs(q) < 4.6e18))
+				throw IBK::Exception(IBK::FormatString("Profile value %1 cannot be quantized with tolerance %2.")
+									 .arg(v).arg(m_tolerance), FUNC_ID);
+			return static_cast<uint64_t>(static_cast<int64_t>(q));
+		}
+		default : {
+			uint64_t bits;
+			std::memcpy(&bits, &v, sizeof(bits));
+			return bits;
+		}
+	}
+}
+
+
+double ProfileStore::decodeValue(uint64_t u) const {
+	switch (m_compression) {
+		case COMPRESSION_FLOAT32 : {
+			uint32_t bits = static_cast<uint32_t>(u);
+			float f;
+			std::memcpy(&f, &bits, sizeof(f));
+			return f;
+		}
+		case COMPRESSION_QUANTIZED :
+			return static_cast<int64_t>(u)*2*m_tolerance;
+		default : {
+			double v;
+			std::memcpy(&v, &u, sizeof(v));
+			return v;
+		}
+	}
+}
+
+
+void ProfileStore::reserve(size_t capacity) {
+	FUNCID(ProfileStore::reserve);
+	if (m_storage == STORAGE_MEMORY) {
+		unsigned char * data = static_cast<unsigned char*>(std::realloc(m_data, capacity));
+		if (data == nullptr)
+			throw IBK::Exception(IBK::FormatString("Cannot allocate %1 MB for profiles.").arg(capacity >> 20), FUNC_ID);
+		m_data = data;
+	}
+	else {
+		// the stored snapshots are kept in the file, only the view is re-created
+		release();
+#if defined(_WIN32)
+		unsigned long long size = capacity;
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+									   static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+		if (m_mapping != nullptr)
+			m_data = static_cast<unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, capacity));
+#else
+		if (ftruncate(m_file, static_cast<off_t>(capacity)) == 0) {
+			void * data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+			if (data != MAP_FAILED)
+				m_data = static_cast<unsigned char*>(data);
+		}
+#endif
+		if (m_data == nullptr)
+			throw IBK::Exception(IBK::FormatString("Cannot map %1 MB of profiles into memory.").arg(capacity >> 20), FUNC_ID);
+	}
+	m_capacity = capacity;
+}
+
+
+void ProfileStore::release() {
+	if (m_storage == STORAGE_MEMORY) {
+		std::free(m_data);
+	}
+	else {
+#if defined(_WIN32)
+		if (m_data != nullptr)
+			UnmapViewOfFile(m_data);
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		m_mapping = nullptr;
+#else
+		if (m_data != nullptr)
+			munmap(m_data, m_capacity);
+#endif
+	}
+	m_data = nullptr;
+}
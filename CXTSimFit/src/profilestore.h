@@ -0,0 +1,152 @@
+#ifndef profilestore_h
+#define profilestore_h
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+/// Concentration profiles of a solver run in a single contiguous buffer.
+///
+/// Each snapshot holds n values of the mobile phase concentration followed by n values of the
+/// immobile phase concentration (only with two components), snapshots are stored one after another.
+/// The buffer grows by doubling its capacity. With STORAGE_MAPPED_FILE the buffer is a memory-mapped
+/// temporary file (deleted when the store is destroyed), so that long runs on fine grids are paged out
+/// by the operating system instead of occupying main memory.
+///
+/// Snapshots can be compressed (see compression_t). Each value is predicted by the same element of the
+/// previous snapshot, every KEYFRAME_INTERVAL-th snapshot (keyframe) by the upstream element of the same
+/// snapshot, so that a snapshot can be decoded from the preceding keyframe. The residuals are stored as
+/// runs of zeros (element unchanged, e.g. ahead of the front or on the plateau) and runs of literals.
+///
+/// The store is not copyable, solver, results and dialogs share it via std::shared_ptr.
+/// Reading compressed snapshots uses an internal decoder state, hence a store must not be read by
+/// several threads concurrently.
+class ProfileStore {
+public:
+	/// Storage of the snapshot buffer.
+	enum storage_t {
+		STORAGE_MEMORY,			///< Heap memory.
+		STORAGE_MAPPED_FILE		///< Memory-mapped temporary file.
+	};
+
+	/// Encoding of the snapshots, same order as SolverInput::profileCompression_t.
+	enum compression_t {
+		/// Raw doubles.
+		COMPRESSION_NONE,
+		/// Lossless, residuals are the XOR of the bit patterns (leading and trailing zero bytes are dropped).
+		COMPRESSION_LOSSLESS,
+		/// Values rounded to float, XOR residuals of the float bit patterns (relative error below 6e-8).
+		COMPRESSION_FLOAT32,
+		/// Values quantized to multiples of twice the tolerance (absolute error at most the tolerance, apart
+		/// from round-off), residuals are the differences of the integers (variable-length encoding).
+		COMPRESSION_QUANTIZED
+	};
+
+	/// Every KEYFRAME_INTERVAL-th snapshot is encoded without reference to the previous snapshot.
+	static const unsigned int KEYFRAME_INTERVAL = 32;
+
+	/// Constructor.
+	/// @param n Number of elements per profile.
+	/// @param components 1 for the mobile phase only, 2 for mobile and immobile phase.
+	/// @param storage Storage of the snapshot buffer.
+	/// @param compression Encoding of the snapshots.
+	/// @param tolerance Maximum absolute error in kg/m3 for COMPRESSION_QUANTIZED.
+	ProfileStore(unsigned int n, unsigned int components, storage_t storage = STORAGE_MEMORY,
+				 compression_t compression = COMPRESSION_NONE, double tolerance = 0);
+	/// Destructor, releases buffer and temporary file.
+	~ProfileStore();
+
+	/// Appends a snapshot at time point t in h. sc is ignored for a single component.
+	/// Throws an IBK::Exception if the buffer cannot be enlarged.
+	void append(double t, const double * cc, const double * sc);
+
+	/// Removes all snapshots (the buffer is kept).
+	void clear();
+
+	/// Exchanges snapshots, buffer and settings with other, so that the contents of a shared store can be
+	/// replaced (e.g. by a thinned copy, see ProfileRecorder).
+	void swap(ProfileStore & other);
+
+	/// Number of snapshots.
+	unsigned int size() const { return static_cast<unsigned int>(m_t.size()); }
+	/// Returns true if no snapshot is stored.
+	bool empty() const { return m_t.empty(); }
+	/// Number of elements per profile.
+	unsigned int n() const { return m_n; }
+	/// Returns true if the immobile phase concentrations are stored.
+	bool hasSc() const { return m_components == 2; }
+	/// Storage of the snapshot buffer.
+	storage_t storage() const { return m_storage; }
+	/// Encoding of the snapshots.
+	compression_t compression() const { return m_compression; }
+	/// Maximum absolute error for COMPRESSION_QUANTIZED in kg/m3.
+	double tolerance() const { return m_tolerance; }
+
+	/// Time point of snapshot k in h.
+	double t(unsigned int k) const { return m_t[k]; }
+	/// Time points of all snapshots in h.
+	const std::vector<double> & t() const { return m_t; }
+
+	/// Copies (decodes) snapshot k into cc and sc (n values each, sc may be nullptr).
+	/// Decoding is fastest for increasing k, otherwise it starts at the preceding keyframe.
+	void profile(unsigned int k, double * cc, double * sc) const;
+
+	/// Maximum mobile phase concentration of all snapshots in kg/m3.
+	double maxCc() const { return m_maxCc; }
+	/// Maximum immobile phase concentration of all snapshots in kg/m3.
+	double maxSc() const { return m_maxSc; }
+
+	/// Size of the encoded snapshots in bytes.
+	size_t bytes() const { return m_offsets.back(); }
+	/// Size of a snapshot as raw doubles in bytes.
+	size_t rawSnapshotBytes() const { return static_cast<size_t>(m_components)*m_n*sizeof(double); }
+
+private:
+	/// Not copyable.
+	ProfileStore(const ProfileStore &);
+	/// Not copyable.
+	ProfileStore & operator=(const ProfileStore &);
+
+	/// Enlarges the buffer to capacity bytes, keeping the stored snapshots.
+	void reserve(size_t capacity);
+	/// Releases buffer and mapping.
+	void release();
+
+	/// Converts a value into the integer that is predicted and encoded (bit pattern or quantized value).
+	uint64_t encodeValue(double v) const;
+	/// Converts an integer of encodeValue() back into a value.
+	double decodeValue(uint64_t u) const;
+
+	/// Decodes snapshot k into m_decoded, m_decoded must hold snapshot k-1 unless k is a keyframe.
+	void decode(unsigned int k) const;
+
+	unsigned int		m_n;			///< Number of elements per profile.
+	unsigned int		m_components;	///< Number of profiles per snapshot (1 or 2).
+	storage_t			m_storage;		///< Storage of the snapshot buffer.
+	compression_t		m_compression;	///< Encoding of the snapshots.
+	double				m_tolerance;	///< Maximum absolute error for COMPRESSION_QUANTIZED in kg/m3.
+
+	std::vector<double>	m_t;			///< Time points of the snapshots in h.
+	std::vector<size_t>	m_offsets;		///< Start of each snapshot in the buffer, last entry is the used size.
+	unsigned char		*m_data;		///< Snapshot buffer.
+	size_t				m_capacity;		///< Size of the buffer in bytes.
+
+	std::vector<uint64_t>	m_previous;	///< Encoded values of the last appended snapshot (reference for the next one).
+	std::vector<uint64_t>	m_residuals;	///< Prediction residuals of one profile while encoding.
+	std::vector<unsigned char>	m_encoded;	///< Encoded snapshot before it is copied into the buffer.
+
+	mutable std::vector<uint64_t>	m_decoded;		///< Encoded values of the last decoded snapshot.
+	mutable int						m_decodedIndex;	///< Index of the snapshot in m_decoded, -1 if none.
+
+	double				m_maxCc;		///< Maximum mobile phase concentration in kg/m3.
+	double				m_maxSc;		///< Maximum immobile phase concentration in kg/m3.
+
+#if defined(_WIN32)
+	void				*m_file;		///< Handle of the temporary file (STORAGE_MAPPED_FILE).
+	void				*m_mapping;		///< Handle of the file mapping (STORAGE_MAPPED_FILE).
+#else
+	int					m_file;			///< Descriptor of the temporary file (STORAGE_MAPPED_FILE), -1 if not open.
+#endif
+};
+
+#endif // profilestore_h
@@ -0,0 +1,231 @@
+#include "resultcache.h"
+
+#include <cstdio>
+#include <ctime>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+
+#if defined(_WIN32)
+	#include <windows.h>
+	#include <sys/utime.h>
+#else
+	#include <dirent.h>
+	#include <unistd.h>
+	#include <utime.h>
+	#include <sys/stat.h>
+#endif
+
+#include <IBK_Exception.h>
+#include <IBK_FormatString.h>
+#include <IBK_Path.h>
+#include <IBK_crypt.h>
+
+#include "solver.h"
+#include "solverinput.h"
+#include "profilestore.h"
+#include "resultfile.h"
+
+const char * const ResultCache::ENGINE_VERSION = "CXTSimFit engines 1";
+
+/// Temporary files older than this (in s) are left by aborted processes and removed by evict().
+static const std::time_t TEMPORARY_FILE_AGE = 24*3600;
+
+/// Input in the format of SolverInput::write(), without the parameters that do not affect the results.
+static std::string canonicalInput(const SolverInput & input) {
+	SolverInput in = input;
+	SolverInput defaults;
+	in.digits = defaults.digits;
+	in.probeWeights.clear();
+	in.reducedOrderFit = false;
+	in.mappedProfiles = false;
+	std::ostringstream strm;
+	in.write(strm);
+	return strm.str();
+}
+
+
+/// A file in the cache directory.
+struct CacheFile {
+	std::string		name;		///< File name without path.
+	uint64_t		size;		///< Size in bytes.
+	std::time_t		used;		///< Last modification (entries: last use).
+
+	bool operator<(const CacheFile & other) const { return used < other.used; }
+};
+
+
+/// Lists the entries and temporary files of a cache directory.
+static std::vector<CacheFile> listCacheFiles(const std::string & directory) {
+	std::vector<CacheFile> files;
+#if defined(_WIN32)
+	WIN32_FIND_DATAA data;
+	HANDLE h = FindFirstFileA((directory + "\\*").c_str(), &data);
+	if (h == INVALID_HANDLE_VALUE)
+		return files;
+	do {
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+		CacheFile f;
+		f.name = data.cFileName;
+		f.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+		// FILETIME counts 100 ns intervals since 1601
+		uint64_t ft = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+		f.used = static_cast<std::time_t>(ft/10000000 - 11644473600ull);
+		files.push_back(f);
+	} while (FindNextFileA(h, &data));
+	FindClose(h);
+#else
+	DIR * dir = opendir(directory.c_str());
+	if (dir == nullptr)
+		return files;
+	struct dirent * e;
+	while ((e = readdir(dir)) != nullptr) {
+		CacheFile f;
+		f.name = e->d_name;
+		struct stat st;
+		// files removed by other processes in the meantime are skipped
+		if (stat((directory + "/" + f.name).c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+			continue;
+		f.size = static_cast<uint64_t>(st.st_size);
+		f.used = st.st_mtime;
+		files.push_back(f);
+	}
+	closedir(dir);
+#endif
+	return files;
+}
+
+
+/// Returns true if name ends with suffix.
+static bool endsWith(const std::string & name, const std::string & suffix) {
+	return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+
+ResultCache::ResultCache() :
+	m_maxBytes(0)
+{
+}
+
+
+void ResultCache::open(const std::string & directory, uint64_t maxBytes) {
+	FUNCID(ResultCache::open);
+	m_directory.clear();
+	if (!IBK::Path::makePath(IBK::Path(directory)))
+		throw IBK::Exception(IBK::FormatString("Cannot create cache directory '%1'.").arg(directory), FUNC_ID);
+	m_directory = directory;
+	m_maxBytes = maxBytes;
+}
+
+
+std::string ResultCache::key(const SolverInput & input) {
+	return IBK::md5_str(std::string(ENGINE_VERSION) + "\n" + canonicalInput(input));
+}
+
+
+std::string ResultCache::entryPath(const std::string & key) const {
+	return m_directory + "/" + key + ".res";
+}
+
+
+bool ResultCache::find(const SolverInput & input, ResultFile & file) const {
+	if (!isOpen())
+		return false;
+	std::string path = entryPath(key(input));
+	try {
+		file.open(path);
+	}
+	catch (IBK::Exception &) {
+		// no entry, or removed by another process in the meantime
+		return false;
+	}
+	// the stored input guards against hash collisions, entries without the probe series are incomplete
+	if (canonicalInput(file.input()) != canonicalInput(input) || file.probeCount() != input.probePositions.size()) {
+		file.close();
+		return false;
+	}
+	// the file time marks the last use for the eviction
+#if defined(_WIN32)
+	_utime(path.c_str(), nullptr);
+#else
+	utime(path.c_str(), nullptr);
+#endif
+	return true;
+}
+
+
+void ResultCache::store(const SolverInput & input, const Solver & solver, const ProfileStore * profiles,
+						const ProbeSampler * probes) const
+{
+	FUNCID(ResultCache::store);
+	if (!isOpen())
+		return;
+
+	// a temporary file name unique among all processes and threads
+	static std::atomic<unsigned int> counter(0);
+#if defined(_WIN32)
+	unsigned long pid = GetCurrentProcessId();
+#else
+	unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+	std::string k = key(input);
+	std::string path = entryPath(k);
+	std::stringstream tmp;
+	tmp << m_directory << "/" << k << "." << pid << "." << counter++ << ".tmp";
+
+	try {
+		ResultFileWriter writer;
+		writer.open(tmp.str(), input);
+		if (profiles != nullptr)
+			writer.appendProfiles(*profiles);
+		if (probes != nullptr)
+			writer.writeProbes(*probes);
+		writer.close(solver.m_outletT, solver.m_outletC, solver.m_breakthroughT, solver.statistics());
+	}
+	catch (IBK::Exception & ex) {
+		std::remove(tmp.str().c_str());
+		throw IBK::Exception(ex, IBK::FormatString("Cannot store results in cache directory '%1'.").arg(m_directory), FUNC_ID);
+	}
+
+	// publish the complete entry, an entry of another process with the same input is replaced (or kept
+	// on Windows, if it is mapped)
+#if defined(_WIN32)
+	if (!MoveFileExA(tmp.str().c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+		std::remove(tmp.str().c_str());
+#else
+	if (std::rename(tmp.str().c_str(), path.c_str()) != 0) {
+		std::remove(tmp.str().c_str());
+		throw IBK::Exception(IBK::FormatString("Cannot store results in cache directory '%1'.").arg(m_directory), FUNC_ID);
+	}
+#endif
+	evict();
+}
+
+
+void ResultCache::evict() const {
+	if (!isOpen())
+		return;
+	std::vector<CacheFile> files = listCacheFiles(m_directory);
+	std::vector<CacheFile> entries;
+	uint64_t total = 0;
+	std::time_t now = std::time(nullptr);
+	for (unsigned int i=0; i<files.size(); ++i) {
+		if (endsWith(files[i].name, ".res")) {
+			entries.push_back(files[i]);
+			total += files[i].size;
+		}
+		else if (endsWith(files[i].name, ".tmp") && now - files[i].used > TEMPORARY_FILE_AGE)
+			std::remove((m_directory + "/" + files[i].name).c_str());
+	}
+	if (m_maxBytes == 0 || total <= m_maxBytes)
+		return;
+
+	// oldest entries first, other processes may have removed some of them already
+	std::sort(entries.begin(), entries.end());
+	for (unsigned int i=0; i<entries.size() && total > m_maxBytes; ++i) {
+		if (std::remove((m_directory + "/" + entries[i].name).c_str()) == 0)
+			total -= entries[i].size;
+	}
+}
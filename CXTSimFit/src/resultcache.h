@@ -0,0 +1,69 @@
+#ifndef resultcache_h
+#define resultcache_h
+
+#include <string>
+#include <stdint.h>
+
+class SolverInput;
+class Solver;
+class ProfileStore;
+class ProbeSampler;
+class ResultFile;
+
+/// Persistent cache of solver results on disk, shared by all processes using the same directory.
+///
+/// Each entry is a result file (see ResultFile) named after the key of its input (see key()). Entries
+/// are never modified: store() writes a new entry to a temporary file and renames it, so that other
+/// processes see either no entry or the complete one. A lookup marks the entry as used (file time),
+/// store() removes the least recently used entries once the size of all entries exceeds the limit.
+/// Removing an entry that another process has mapped only unlinks it on POSIX systems (the mapping
+/// stays valid), on Windows such entries are kept until the next eviction.
+///
+/// The cache holds the results of Solver runs only (no Parareal, CyclicSteadyState or PODModel results).
+class ResultCache {
+public:
+	/// Version of the solver engines, part of the key. Must be changed with any modification of the
+	/// solvers that alters results, so that entries of previous versions are no longer found.
+	static const char * const ENGINE_VERSION;
+
+	/// Constructor, the cache is closed (find() and store() do nothing).
+	ResultCache();
+
+	/// Uses the given directory (created if missing) with entries of at most maxBytes in total
+	/// (0 for no limit). Throws an IBK::Exception if the directory cannot be created.
+	void open(const std::string & directory, uint64_t maxBytes);
+	/// Returns true if the cache is open.
+	bool isOpen() const { return !m_directory.empty(); }
+
+	/// Key of the results of an input: MD5 hash of ENGINE_VERSION and the input in the format of
+	/// SolverInput::write() (full precision, including the inlet data series). Parameters without
+	/// influence on the results of a run (digits, probeWeights, reducedOrderFit, mappedProfiles) are
+	/// excluded.
+	static std::string key(const SolverInput & input);
+
+	/// Looks up the results of input and opens the entry in file. Returns false if the cache is closed
+	/// or has no (readable) entry with exactly this input and the series of all probe positions.
+	/// Entries may lack the profile snapshots (stored by fits), see ResultFile::size().
+	bool find(const SolverInput & input, ResultFile & file) const;
+
+	/// Stores the results of a finished run of input (outlet series, breakthrough times and statistics
+	/// of solver, the snapshots of profiles if given and the series of probes, which is required if
+	/// the input has probe positions) and evicts the least recently used entries. Does nothing if the
+	/// cache is closed.
+	/// Throws an IBK::Exception if the entry cannot be written.
+	void store(const SolverInput & input, const Solver & solver, const ProfileStore * profiles,
+			   const ProbeSampler * probes) const;
+
+	/// Removes the least recently used entries until the entries fit into the size limit, and temporary
+	/// files left by aborted processes. Entries that cannot be removed are skipped.
+	void evict() const;
+
+private:
+	/// Path of the entry with the given key.
+	std::string entryPath(const std::string & key) const;
+
+	std::string		m_directory;	///< Cache directory, empty if the cache is closed.
+	uint64_t		m_maxBytes;		///< Maximum size of all entries in bytes, 0 for no limit.
+};
+
+#endif // resultcache_h
@@ -0,0 +1,317 @@
+#include "resultfile.h"
+
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#include <IBK_Exception.h>
+#include <IBK_FormatString.h>
+
+#include "profilestore.h"
+
+const char ResultFile::MAGIC[8] = { 'C', 'X', 'T', 'R', 'E', 'S', 0, 0 };
+
+/// Number of values of the integrator configuration in SEC_STATISTICS_REAL.
+static const unsigned int STATISTICS_REAL_COUNT = 9;
+/// Number of counters in SEC_STATISTICS_INT.
+static const unsigned int STATISTICS_INT_COUNT = 7;
+
+
+ResultFile::ResultFile() :
+	m_data(nullptr),
+	m_size(0),
+	m_header(nullptr)
+{
+#if defined(_WIN32)
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = nullptr;
+#else
+	m_file = -1;
+#endif
+	std::memset(m_sections, 0, sizeof(m_sections));
+}
+
+
+ResultFile::~ResultFile() {
+	close();
+}
+
+
+void ResultFile::open(const std::string & filename) {
+	FUNCID(ResultFile::open);
+	close();
+
+#if defined(_WIN32)
+	m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+						 FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		throw IBK::Exception(IBK::FormatString("Cannot open result file '%1'.").arg(filename), FUNC_ID);
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+		close();
+		throw IBK::Exception(IBK::FormatString("'%1' is not a result file.").arg(filename), FUNC_ID);
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping != nullptr)
+		m_data = static_cast<const unsigned char *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	m_file = ::open(filename.c_str(), O_RDONLY);
+	if (m_file == -1)
+		throw IBK::Exception(IBK::FormatString("Cannot open result file '%1'.").arg(filename), FUNC_ID);
+	struct stat st;
+	if (fstat(m_file, &st) != 0 || st.st_size == 0) {
+		close();
+		throw IBK::Exception(IBK::FormatString("'%1' is not a result file.").arg(filename), FUNC_ID);
+	}
+	m_size = static_cast<size_t>(st.st_size);
+	void * p = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_file, 0);
+	if (p != MAP_FAILED)
+		m_data = static_cast<const unsigned char *>(p);
+#endif
+	if (m_data == nullptr) {
+		close();
+		throw IBK::Exception(IBK::FormatString("Cannot map result file '%1'.").arg(filename), FUNC_ID);
+	}
+
+	// check header and index, so that the accessors need no checks
+	try {
+		m_header = reinterpret_cast<const Header *>(m_data);
+		if (m_size < sizeof(Header) || std::memcmp(m_header->magic, MAGIC, sizeof(MAGIC)) != 0 || m_header->version != VERSION)
+			throw IBK::Exception(IBK::FormatString("'%1' is not a result file of this version.").arg(filename), FUNC_ID);
+		if (m_header->indexOffset == 0)
+			throw IBK::Exception(IBK::FormatString("Result file '%1' is incomplete (run not finished).").arg(filename), FUNC_ID);
+		IBK::FormatString corrupt = IBK::FormatString("Result file '%1' is corrupt.").arg(filename);
+		if ((m_header->components != 1 && m_header->components != 2) || m_header->indexOffset > m_size ||
+			(m_size - m_header->indexOffset)/sizeof(Section) < m_header->sectionCount)
+		{
+			throw IBK::Exception(corrupt, FUNC_ID);
+		}
+		const Section * index = reinterpret_cast<const Section *>(m_data + m_header->indexOffset);
+		for (unsigned int i=0; i<m_header->sectionCount; ++i) {
+			// unknown sections of later versions are skipped
+			if (index[i].id >= NUM_SEC)
+				continue;
+			uint64_t valueSize = sizeof(double);
+			if (index[i].id == SEC_INPUT)
+				valueSize = 1;
+			else if (index[i].id == SEC_SNAPSHOTS)
+				valueSize = static_cast<uint64_t>(m_header->components)*m_header->n*sizeof(double);
+			if (index[i].offset % sizeof(double) != 0 || index[i].offset > m_size ||
+				(valueSize > 0 && (m_size - index[i].offset)/valueSize < index[i].count))
+			{
+				throw IBK::Exception(corrupt, FUNC_ID);
+			}
+			m_sections[index[i].id] = index[i];
+		}
+		if (m_sections[SEC_SNAPSHOT_T].count != m_sections[SEC_SNAPSHOTS].count ||
+			m_sections[SEC_OUTLET_C].count != m_sections[SEC_OUTLET_T].count ||
+			(m_sections[SEC_PROBE_T].count == 0 ? m_sections[SEC_PROBE_C].count != 0
+												: m_sections[SEC_PROBE_C].count % m_sections[SEC_PROBE_T].count != 0))
+		{
+			throw IBK::Exception(corrupt, FUNC_ID);
+		}
+
+		std::istringstream strm(std::string(column<char>(SEC_INPUT), m_sections[SEC_INPUT].count));
+		m_input = SolverInput();
+		m_input.read(strm, filename);
+	}
+	catch (IBK::Exception &) {
+		close();
+		throw;
+	}
+}
+
+
+void ResultFile::close() {
+#if defined(_WIN32)
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	m_mapping = nullptr;
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data != nullptr)
+		munmap(const_cast<unsigned char *>(m_data), m_size);
+	if (m_file != -1)
+		::close(m_file);
+	m_file = -1;
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_header = nullptr;
+	std::memset(m_sections, 0, sizeof(m_sections));
+}
+
+
+SolverStatistics ResultFile::statistics() const {
+	SolverStatistics stats;
+	if (m_sections[SEC_STATISTICS_REAL].count >= STATISTICS_REAL_COUNT) {
+		const double * r = column<double>(SEC_STATISTICS_REAL);
+		stats.adams = (r[0] != 0);
+		stats.newton = (r[1] != 0);
+		stats.stabLimDet = (r[2] != 0);
+		stats.probed = (r[3] != 0);
+		stats.maxOrder = static_cast<int>(r[4]);
+		stats.initialStep = r[5];
+		stats.spectralRadius = r[6];
+		stats.probeCostAdams = r[7];
+		stats.probeCostBDF = r[8];
+	}
+	if (m_sections[SEC_STATISTICS_INT].count >= STATISTICS_INT_COUNT) {
+		const int64_t * c = column<int64_t>(SEC_STATISTICS_INT);
+		stats.steps = static_cast<long int>(c[0]);
+		stats.rhsEvals = static_cast<long int>(c[1]);
+		stats.linSetups = static_cast<long int>(c[2]);
+		stats.errTestFails = static_cast<long int>(c[3]);
+		stats.nonlinIters = static_cast<long int>(c[4]);
+		stats.nonlinConvFails = static_cast<long int>(c[5]);
+		stats.stabLimOrderReds = static_cast<long int>(c[6]);
+	}
+	// the snapshots of the file replace those of a profile store
+	stats.profileSnapshots = size();
+	stats.profileRawBytes = static_cast<size_t>(size())*m_header->components*m_header->n*sizeof(double);
+	stats.profileBytes = stats.profileRawBytes;
+	return stats;
+}
+
+
+std::vector<double> ResultFile::breakthroughT() const {
+	const double * t = column<double>(SEC_BREAKTHROUGH_T);
+	return std::vector<double>(t, t + sectionSize(SEC_BREAKTHROUGH_T));
+}
+
+
+ResultFileWriter::ResultFileWriter() {
+	std::memset(&m_header, 0, sizeof(m_header));
+}
+
+
+ResultFileWriter::~ResultFileWriter() {
+}
+
+
+void ResultFileWriter::align() {
+	static const char zeros[ResultFile::ALIGNMENT] = { 0 };
+	size_t pos = static_cast<size_t>(m_out.tellp());
+	m_out.write(zeros, (ResultFile::ALIGNMENT - pos % ResultFile::ALIGNMENT) % ResultFile::ALIGNMENT);
+}
+
+
+template <typename T>
+void ResultFileWriter::writeColumn(ResultFile::section_t id, const std::vector<T> & values) {
+	align();
+	ResultFile::Section section = { static_cast<uint32_t>(id), 0, static_cast<uint64_t>(m_out.tellp()), values.size() };
+	if (!values.empty())
+		m_out.write(reinterpret_cast<const char *>(&values[0]), values.size()*sizeof(T));
+	m_index.push_back(section);
+}
+
+
+void ResultFileWriter::open(const std::string & filename, const SolverInput & input) {
+	FUNCID(ResultFileWriter::open);
+	if (m_out.is_open())
+		m_out.close();
+	m_out.clear();
+	m_out.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+	if (!m_out)
+		throw IBK::Exception(IBK::FormatString("Cannot create result file '%1'.").arg(filename), FUNC_ID);
+	m_filename = filename;
+	m_index.clear();
+	m_snapshotT.clear();
+
+	std::memset(&m_header, 0, sizeof(m_header));
+	std::memcpy(m_header.magic, ResultFile::MAGIC, sizeof(ResultFile::MAGIC));
+	m_header.version = ResultFile::VERSION;
+	m_header.n = input.n;
+	m_header.components = (input.model == SolverInput::PLUS_EXCHANGE) ? 2 : 1;
+	m_out.write(reinterpret_cast<const char *>(&m_header), sizeof(m_header));
+
+	std::ostringstream strm;
+	input.write(strm);
+	std::string text = strm.str();
+	writeColumn(ResultFile::SEC_INPUT, std::vector<char>(text.begin(), text.end()));
+
+	// snapshots follow, their number is counted by append()
+	align();
+	ResultFile::Section snapshots = { ResultFile::SEC_SNAPSHOTS, 0, static_cast<uint64_t>(m_out.tellp()), 0 };
+	m_index.push_back(snapshots);
+	if (!m_out)
+		throw IBK::Exception(IBK::FormatString("Cannot write result file '%1'.").arg(filename), FUNC_ID);
+}
+
+
+void ResultFileWriter::append(double t, const double * cc, const double * sc) {
+	m_out.write(reinterpret_cast<const char *>(cc), m_header.n*sizeof(double));
+	if (m_header.components == 2)
+		m_out.write(reinterpret_cast<const char *>(sc), m_header.n*sizeof(double));
+	m_snapshotT.push_back(t);
+	++m_index[1].count; // snapshot section, see open()
+}
+
+
+void ResultFileWriter::writeProbes(const ProbeSampler & probes) {
+	if (probes.size() == 0)
+		return;
+	writeColumn(ResultFile::SEC_PROBE_T, probes.t());
+	// the series are written one after another into a single section
+	align();
+	ResultFile::Section section = { ResultFile::SEC_PROBE_C, 0, static_cast<uint64_t>(m_out.tellp()),
+		static_cast<uint64_t>(probes.size())*probes.t().size() };
+	for (unsigned int j=0; j<probes.size(); ++j) {
+		if (!probes.c(j).empty())
+			m_out.write(reinterpret_cast<const char *>(&probes.c(j)[0]), probes.c(j).size()*sizeof(double));
+	}
+	m_index.push_back(section);
+}
+
+
+void ResultFileWriter::appendProfiles(const ProfileStore & profiles) {
+	std::vector<double> cc(profiles.n()), sc(profiles.n());
+	for (unsigned int i=0; i<profiles.size(); ++i) {
+		profiles.profile(i, &cc[0], profiles.hasSc() ? &sc[0] : nullptr);
+		append(profiles.t(i), &cc[0], &sc[0]);
+	}
+}
+
+
+void ResultFileWriter::close(const std::vector<double> & outletT, const std::vector<double> & outletC,
+							 const std::vector<double> & breakthroughT, const SolverStatistics & stats)
+{
+	FUNCID(ResultFileWriter::close);
+	writeColumn(ResultFile::SEC_SNAPSHOT_T, m_snapshotT);
+	writeColumn(ResultFile::SEC_OUTLET_T, outletT);
+	writeColumn(ResultFile::SEC_OUTLET_C, outletC);
+	writeColumn(ResultFile::SEC_BREAKTHROUGH_T, breakthroughT);
+
+	double configuration[STATISTICS_REAL_COUNT] = { double(stats.adams), double(stats.newton), double(stats.stabLimDet),
+		double(stats.probed), double(stats.maxOrder), stats.initialStep, stats.spectralRadius, stats.probeCostAdams,
+		stats.probeCostBDF };
+	writeColumn(ResultFile::SEC_STATISTICS_REAL, std::vector<double>(configuration, configuration + STATISTICS_REAL_COUNT));
+	int64_t counters[STATISTICS_INT_COUNT] = { stats.steps, stats.rhsEvals, stats.linSetups, stats.errTestFails,
+		stats.nonlinIters, stats.nonlinConvFails, stats.stabLimOrderReds };
+	writeColumn(ResultFile::SEC_STATISTICS_INT, std::vector<int64_t>(counters, counters + STATISTICS_INT_COUNT));
+
+	// the index completes the file
+	align();
+	m_header.indexOffset = static_cast<uint64_t>(m_out.tellp());
+	m_header.sectionCount = static_cast<uint32_t>(m_index.size());
+	m_out.write(reinterpret_cast<const char *>(&m_index[0]), m_index.size()*sizeof(ResultFile::Section));
+	m_out.seekp(0);
+	m_out.write(reinterpret_cast<const char *>(&m_header), sizeof(m_header));
+	m_out.close();
+	if (!m_out)
+		throw IBK::Exception(IBK::FormatString("Cannot write result file '%1'.").arg(m_filename), FUNC_ID);
+}
@@ -0,0 +1,195 @@
+#ifndef resultfile_h
+#define resultfile_h
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstddef>
+#include <stdint.h>
+
+#include "solverinput.h"
+#include "solverstatistics.h"
+#include "solverobserver.h"
+
+class ProfileStore;
+
+/// Binary result file of a solver run, written with ResultFileWriter.
+///
+/// The file starts with a header of 64 bytes, followed by the input (text in the format of
+/// SolverInput::write()), the profile snapshots and columns with the snapshot times, the outlet series,
+/// the breakthrough times, the statistics and optionally the probe series. An index at the end of the file gives offset and number
+/// of values of each section, its offset is stored in the header once the file is complete.
+/// Sections start at multiples of ALIGNMENT bytes. Each snapshot holds n mobile phase concentrations
+/// followed by n immobile phase concentrations (only with two components) as raw doubles, snapshots are
+/// stored one after another. Values are stored in the byte order of the writing machine.
+///
+/// The file is mapped into memory, snapshots and columns are returned as pointers into the mapping
+/// without copying. The pointers are valid until the file is closed.
+class ResultFile {
+public:
+	/// Identifies a result file.
+	static const char MAGIC[8];
+	/// Version of the file format.
+	static const uint32_t VERSION = 1;
+	/// Alignment of the sections in bytes.
+	static const unsigned int ALIGNMENT = 64;
+
+	/// Sections of a result file.
+	enum section_t {
+		SEC_INPUT,				///< Input as text (number of bytes).
+		SEC_SNAPSHOTS,			///< Profile snapshots (number of snapshots).
+		SEC_SNAPSHOT_T,			///< Time points of the snapshots in h.
+		SEC_OUTLET_T,			///< Time points of the outlet series in h.
+		SEC_OUTLET_C,			///< Outlet concentrations in kg/m3.
+		SEC_BREAKTHROUGH_T,		///< Breakthrough times in h (-1 if not reached).
+		SEC_STATISTICS_REAL,	///< Integrator configuration (doubles, see SolverStatistics).
+		SEC_STATISTICS_INT,		///< Counters (64 bit integers, see SolverStatistics).
+		SEC_PROBE_T,			///< Time points of the probe series in h.
+		SEC_PROBE_C,			///< Probe concentrations in kg/m3, the series of all probes one after another.
+		NUM_SEC
+	};
+
+	/// File header.
+	struct Header {
+		char		magic[8];		///< MAGIC.
+		uint32_t	version;		///< VERSION.
+		uint32_t	n;				///< Number of elements per profile.
+		uint32_t	components;		///< Number of profiles per snapshot (1 or 2).
+		uint32_t	sectionCount;	///< Number of index entries.
+		uint64_t	indexOffset;	///< Offset of the index, 0 while the file is written.
+		uint64_t	reserved[4];	///< Reserved, 0.
+	};
+
+	/// Index entry of a section.
+	struct Section {
+		uint32_t	id;				///< Section (section_t).
+		uint32_t	reserved;		///< Reserved, 0.
+		uint64_t	offset;			///< Offset of the section in bytes.
+		uint64_t	count;			///< Number of values (bytes for SEC_INPUT, snapshots for SEC_SNAPSHOTS).
+	};
+
+	/// Constructor.
+	ResultFile();
+	/// Destructor, releases the mapping.
+	~ResultFile();
+
+	/// Maps the file and reads the input. Throws an IBK::Exception if the file cannot be mapped,
+	/// is not a complete result file or is corrupt.
+	void open(const std::string & filename);
+	/// Releases the mapping.
+	void close();
+
+	/// Input of the run.
+	const SolverInput & input() const { return m_input; }
+	/// Integrator configuration and counters of the run.
+	SolverStatistics statistics() const;
+
+	/// Number of elements per profile (the accessors below require an open file).
+	unsigned int n() const { return m_header->n; }
+	/// Returns true if the immobile phase concentrations are stored.
+	bool hasSc() const { return m_header->components == 2; }
+
+
+	/// Number of snapshots.
+	unsigned int size() const { return sectionSize(SEC_SNAPSHOTS); }
+	/// Time points of the snapshots in h (size() values).
+	const double * t() const { return column<double>(SEC_SNAPSHOT_T); }
+	/// Mobile phase concentrations of snapshot k in kg/m3 (n() values).
+	const double * cc(unsigned int k) const { return column<double>(SEC_SNAPSHOTS) + static_cast<size_t>(k)*m_header->components*m_header->n; }
+	/// Immobile phase concentrations of snapshot k in kg/m3 (n() values), nullptr for a single component.
+	const double * sc(unsigned int k) const { return hasSc() ? cc(k) + m_header->n : nullptr; }
+
+
+	/// Number of outlet values.
+	unsigned int outletSize() const { return sectionSize(SEC_OUTLET_T); }
+	/// Time points of the outlet series in h.
+	const double * outletT() const { return column<double>(SEC_OUTLET_T); }
+	/// Outlet concentrations in kg/m3.
+	const double * outletC() const { return column<double>(SEC_OUTLET_C); }
+	/// First crossing times of SolverInput::breakthroughFractions in h, -1 if not reached.
+	std::vector<double> breakthroughT() const;
+
+
+	/// Number of probe series (see ProbeSampler).
+	unsigned int probeCount() const { return sectionSize(SEC_PROBE_T) == 0 ? 0 : sectionSize(SEC_PROBE_C)/sectionSize(SEC_PROBE_T); }
+	/// Number of values per probe series.
+	unsigned int probeSize() const { return sectionSize(SEC_PROBE_T); }
+	/// Time points of the probe series in h.
+	const double * probeT() const { return column<double>(SEC_PROBE_T); }
+	/// Concentrations of probe j in kg/m3 (probeSize() values).
+	const double * probeC(unsigned int j) const { return column<double>(SEC_PROBE_C) + static_cast<size_t>(j)*probeSize(); }
+
+private:
+	/// Not copyable.
+	ResultFile(const ResultFile &);
+	/// Not copyable.
+	ResultFile & operator=(const ResultFile &);
+
+	/// Number of values of a section.
+	unsigned int sectionSize(section_t id) const { return static_cast<unsigned int>(m_sections[id].count); }
+	/// Start of a section.
+	template <typename T>
+	const T * column(section_t id) const { return reinterpret_cast<const T *>(m_data + m_sections[id].offset); }
+
+	const unsigned char	*m_data;		///< Start of the mapping, nullptr if no file is open.
+	size_t				m_size;			///< Size of the file in bytes.
+	const Header		*m_header;		///< Header in the mapping.
+	/// Sections by id (offset and count 0 for sections not in the file).
+	Section				m_sections[NUM_SEC];
+	SolverInput			m_input;		///< Input of the run.
+
+#if defined(_WIN32)
+	void				*m_file;		///< Handle of the file.
+	void				*m_mapping;		///< Handle of the file mapping.
+#else
+	int					m_file;			///< Descriptor of the file, -1 if not open.
+#endif
+};
+
+
+/// Writes a result file (see ResultFile).
+///
+/// The snapshots are selected by a ProfileRecorder attached to the solver, so that the file holds the
+/// same profiles as the GUI (output schedule or profileChange, maxProfiles with thinning, last output),
+/// and are written with appendProfiles() after the run (with SolverInput::mappedProfiles the recorder
+/// keeps them in a temporary file instead of main memory). Outlet series, breakthrough times and
+/// statistics are written with close(), probe series with writeProbes().
+class ResultFileWriter {
+public:
+	/// Constructor.
+	ResultFileWriter();
+	/// Destructor, an open file is left incomplete (it is not readable).
+	~ResultFileWriter();
+
+	/// Creates the file and writes header and input.
+	/// Throws an IBK::Exception if the file cannot be created.
+	void open(const std::string & filename, const SolverInput & input);
+
+	/// Appends a snapshot at time point t in h (sc is ignored for a single component).
+	void append(double t, const double * cc, const double * sc);
+	/// Appends all snapshots of profiles (decoded).
+	void appendProfiles(const ProfileStore & profiles);
+
+	/// Writes the series of a probe sampler, must be called before close().
+	void writeProbes(const ProbeSampler & probes);
+
+	/// Writes the remaining columns and the index and closes the file.
+	/// Throws an IBK::Exception if the file cannot be written.
+	void close(const std::vector<double> & outletT, const std::vector<double> & outletC,
+			   const std::vector<double> & breakthroughT, const SolverStatistics & stats);
+
+private:
+	/// Pads the file with zeros up to the next multiple of ResultFile::ALIGNMENT.
+	void align();
+	/// Writes a column of values and adds it to the index.
+	template <typename T>
+	void writeColumn(ResultFile::section_t id, const std::vector<T> & values);
+
+	std::string							m_filename;		///< Name of the file.
+	std::ofstream						m_out;			///< File stream.
+	ResultFile::Header					m_header;		///< Header (written again by close()).
+	std::vector<ResultFile::Section>	m_index;		///< Index entries.
+	std::vector<double>					m_snapshotT;	///< Time points of the snapshots in h.
+};
+
+#endif // resultfile_h
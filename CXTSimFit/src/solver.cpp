@@ -7,8 +7,12 @@
 #include <fstream>
 #include <stdexcept>
 #include <cmath>
+#include <algorithm>
 
 #include <cvode/cvode_band.h>
+#include <cvode/cvode_spgmr.h>
+#include <nvector/nvector_openmp.h>
+#include <nvector/nvector_simd.h>
 
 #include <IBK_Exception.h>
 
@@ -21,14 +25,32 @@ inline int f_solver(realtype t, N_Vector y, N_Vector ydot, void *f_data) {
 	return static_cast<Solver*>(f_data)->calculateDivergences(t, y, ydot);
 }
 
+// Wrapper function called from CVode root finding for the breakthrough times.
+inline int g_solver(realtype /*t*/, N_Vector y, realtype *gout, void *user_data) {
+	static_cast<Solver*>(user_data)->breakthroughFunctions(y, gout);
+	return 0;
+}
+
+// Wrapper functions for the Krylov solver, defined in solverkrylov.cpp
+int jtimes_solver(N_Vector v, N_Vector Jv, realtype t, N_Vector y, N_Vector fy,
+				  void *user_data, N_Vector tmp);
+int psetup_solver(realtype t, N_Vector y, N_Vector fy, booleantype jok, booleantype *jcurPtr,
+				  realtype gamma, void *user_data, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
+int psolve_solver(realtype t, N_Vector y, N_Vector fy, N_Vector r, N_Vector z,
+				  realtype gamma, realtype delta, int lr, void *user_data, N_Vector tmp);
+
 
 Solver::Solver() {
 	// initialize pointers to zero
 //	m_outputFile = nullptr;
 	m_yStorage = nullptr;
 	m_absTolVec = nullptr;
+	m_ySteady = nullptr;
 	m_cvodeMem = nullptr;
 	m_cvodeMonitors = nullptr;
+	m_precGamma = 0;
+	m_threads = 1;
+	m_checkpointDt = 0;
 }
 
 
@@ -44,13 +66,17 @@ void Solver::clear() {
 		m_cvodeMem = nullptr;
 	}
 	if (m_yStorage!=nullptr) {
-		N_VDestroy_Serial(m_yStorage);
+		N_VDestroy(m_yStorage);
 		m_yStorage = nullptr;
 	}
 	if (m_absTolVec!=nullptr) {
-		N_VDestroy_Serial(m_absTolVec);
+		N_VDestroy(m_absTolVec);
 		m_absTolVec = nullptr;
 	}
+	if (m_ySteady!=nullptr) {
+		N_VDestroy(m_ySteady);
+		m_ySteady = nullptr;
+	}
 	delete m_cvodeMonitors;
 	m_cvodeMonitors = nullptr;
 }
@@ -69,9 +95,7 @@ void Solver::init(const SolverInput & input) {
 	// set number of elements and variables per element
 	m_n = m_input.n;
 
-	// depending on problem to solve, set number of variables and determine the bandwidth
-	unsigned int bandwidth;
-	// bandwidth is the maximum difference of neighboring element numbers * 2 + 1
+	// depending on problem to solve, set number of variables
 	switch (m_input.model) {
 		case SolverInput::DIFF_CONV_PARTITION :
 			m_nVars = 1; // total VOC mass density per bed node
@@ -82,121 +106,467 @@ void Solver::init(const SolverInput & input) {
 			break;
 	}
 
-	bandwidth = (m_nVars+1)*2 - 1;
-
-	// set relative and absolute tolerances
+	// set relative tolerance, absolute tolerances are set in initCVODE()
 	m_relTol = input.relTol;
-	m_absTolVec = N_VNew_Serial(m_nVars*m_n);
-	if (!m_absTolVec)
-		throw IBK::Exception("Absolute tolerances vector allocation error!", FUNC_ID);
 
-	// now loop over all elements and set absolute tolerances
-	for (unsigned int i=0; i<m_n*m_nVars; ++i) {
-		NV_DATA_S(m_absTolVec)[i] = input.absTol;
+	// the active window requires the domain ahead of the front to remain empty,
+	// hence we can only use it when no sources/sinks are present and we start with an empty domain
+	m_nActive = m_n;
+	if (input.engine == SolverInput::ENGINE_CVODE && input.activeWindow && input.gammac == 0 &&
+		(input.steadyState == SolverInput::SS_NONE || input.steadyState == SolverInput::SS_TERMINATION) &&
+		(input.model == SolverInput::DIFF_CONV_PARTITION || input.gammas == 0))
+	{
+		m_nActive = std::min(m_n, 2*std::max(1u, input.activeWindowMargin));
 	}
 
+	// threaded vectors are only used by CVODE, the other engines and KINSOL work with serial vectors,
+	// without OpenMP (the OpenMP vector is not part of the sundials library) all runs are serial
+	m_threads = 1;
+#if defined(_OPENMP)
+	if (input.engine == SolverInput::ENGINE_CVODE && input.steadyState == SolverInput::SS_NONE)
+		m_threads = std::max(1u, input.threads);
+#endif
+
 	// create solution vector and set initial conditions
-	m_yStorage = N_VNew_Serial(m_n*m_nVars);
+	m_yStorage = newVector(m_nActive*m_nVars);
 	if (!m_yStorage)
 		throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
 
 	// for now, the initial condition is completely empty
-	for (unsigned int i=0; i<m_n*m_nVars; ++i) {
-		NV_DATA_S(m_yStorage)[i] = 0;
+	N_VConst(0, m_yStorage);
+
+	switch (input.engine) {
+		case SolverInput::ENGINE_CVODE :
+			// CVODE is initialized below, the integrator configuration may need the working variables
+			break;
+
+		case SolverInput::ENGINE_CHARACTERISTIC :
+			if (input.D != 0)
+				throw IBK::Exception("The characteristics engine requires a zero diffusion coefficient.", FUNC_ID);
+			if (input.v <= 0)
+				throw IBK::Exception("The characteristics engine requires a positive convection velocity.", FUNC_ID);
+			break;
+
+		case SolverInput::ENGINE_IMEX :
+			break;
+
+		case SolverInput::ENGINE_MULTIRATE :
+			if (input.model != SolverInput::PLUS_EXCHANGE)
+				throw IBK::Exception("The multirate engine requires the mass transfer model.", FUNC_ID);
+			if (input.macroDt <= 0)
+				throw IBK::Exception("Invalid macro time step.", FUNC_ID);
+			break;
+	}
+
+	m_cInletData = input.cInletData; // Note: makespline() was already done!
+	m_cFeed = m_input.cInlet;
+	if (!m_cInletData.empty())
+		m_cFeed = *std::max_element(m_cInletData.y().begin(), m_cInletData.y().end());
+	for (unsigned int i=0; i<input.breakthroughFractions.size(); ++i) {
+		if (input.breakthroughFractions[i] <= 0 || input.breakthroughFractions[i] > 1)
+			throw IBK::Exception("Breakthrough fractions must be in the range (0,1].", FUNC_ID);
 	}
+	m_breakthroughT.assign(input.breakthroughFractions.size(), -1);
+
+	// initialization of working variables
+	m_cREV.resize(m_n);
+	m_cc.resize(m_n);
+	m_smu_c.resize(m_n);
+	m_sgamma_c.resize(m_n);
+	m_jdiff.resize(m_n+1);
+	m_jconv.resize(m_n+1);
+
+	if (input.model == SolverInput::PLUS_EXCHANGE) {
+		m_sREV.resize(m_n);
+		m_sc.resize(m_n);
+		m_smu_s.resize(m_n);
+		m_sgamma_s.resize(m_n);
+		m_sbeta.resize(m_n);
+	}
+
+	m_outputCounter = 0;
+	m_observers.clear();
+	m_checkpointFile.clear();
+	m_checkpointDt = 0;
 
 	// init CVODE solver
-	m_cvodeMem = CVodeCreate(CV_BDF, CV_NEWTON);
+	m_statistics = SolverStatistics();
+	if (input.engine == SolverInput::ENGINE_CVODE) {
+		configureIntegrator();
+		initCVODE(m_t, m_statistics.initialStep);
+	}
+
+	// steady-state solution, used as initial state, as termination criterion or as the only result
+	switch (input.steadyState) {
+		case SolverInput::SS_NONE :
+			break;
+
+		case SolverInput::SS_DIRECT :
+			solveSteadyState(m_tEnd, m_yStorage);
+			break;
+
+		case SolverInput::SS_TERMINATION :
+			if (input.engine != SolverInput::ENGINE_CVODE)
+				throw IBK::Exception("The steady-state termination check requires the CVODE engine.", FUNC_ID);
+			m_ySteady = newVector(m_n*m_nVars);
+			if (!m_ySteady)
+				throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+			N_VConst(0, m_ySteady);
+			solveSteadyState(m_tEnd, m_ySteady);
+			break;
+
+		case SolverInput::SS_INITIAL :
+			solveSteadyState(0, m_yStorage);
+			// restart integrator with the new initial state
+			if (input.engine == SolverInput::ENGINE_CVODE)
+				initCVODE(m_t, m_statistics.initialStep);
+			break;
+
+		case SolverInput::SS_CYCLIC :
+		case SolverInput::SS_CYCLIC_DIRECT :
+			throw IBK::Exception("The cyclic steady state is computed with the CyclicSteadyState driver.", FUNC_ID);
+	}
+
+	// initialization complete
+	m_initialized = true;
+}
+
+
+void Solver::initCVODE(double t0, double h0) {
+	FUNCID(Solver::initCVODE);
+
+	// release memory of a previously integrated (smaller) system, keeping its counters
+	if (m_cvodeMem != nullptr) {
+		SolverStatistics stats;
+		cvodeCounters(stats);
+		m_statistics.addCounters(stats);
+		CVodeFree(&m_cvodeMem);
+		m_cvodeMem = nullptr;
+	}
+	if (m_absTolVec != nullptr) {
+		N_VDestroy(m_absTolVec);
+		m_absTolVec = nullptr;
+	}
+
+	unsigned int nEquations = m_nActive*m_nVars;
+	// bandwidth is the maximum difference of neighboring element numbers * 2 + 1
+	unsigned int bandwidth = (m_nVars+1)*2 - 1;
+
+	// set absolute tolerances
+	m_absTolVec = newVector(nEquations);
+	if (!m_absTolVec)
+		throw IBK::Exception("Absolute tolerances vector allocation error!", FUNC_ID);
+
+	// all elements use the same absolute tolerance
+	N_VConst(m_input.absTol, m_absTolVec);
+
+	m_cvodeMem = CVodeCreate(m_statistics.adams ? CV_ADAMS : CV_BDF, m_statistics.newton ? CV_NEWTON : CV_FUNCTIONAL);
 	// Initialize cvode memory with equation specific absolute tolerances
 	int result = CVodeInit(m_cvodeMem,
 						   f_solver,
-						   m_t,
+						   t0,
 						   m_yStorage);
 	if (result != CV_SUCCESS)
 		throw IBK::Exception("CVodeInit init error.", FUNC_ID);
 
-	// setup matrix, tridiagonal for diffusion/convection model, larger bandwidth for model with dual porosity
-	result = CVBand(m_cvodeMem, m_n*m_nVars, bandwidth, bandwidth);
-	switch (result) {
-		case CVDLS_SUCCESS		: break;
-		case CVDLS_MEM_FAIL		: throw IBK::Exception("CVBand memory initialization error (problem too large?)", FUNC_ID);
-		case CVDLS_ILL_INPUT	: throw IBK::Exception("CVBand init error (wrong input?)", FUNC_ID);
-		default					: throw IBK::Exception("CVBand init error", FUNC_ID);
+	// user data must be set before the linear solver is attached, since CVSpgmr stores the pointer
+	// for the preconditioner functions
+	CVodeSetUserData(m_cvodeMem, (void*)this);
+
+	// functional iteration needs no linear solver
+	if (m_statistics.newton) {
+		switch (m_input.linearSolver) {
+			case SolverInput::LES_BAND :
+				// setup matrix, tridiagonal for diffusion/convection model, larger bandwidth for model with dual porosity
+				result = CVBand(m_cvodeMem, nEquations, bandwidth, bandwidth);
+				switch (result) {
+					case CVDLS_SUCCESS		: break;
+					case CVDLS_MEM_FAIL		: throw IBK::Exception("CVBand memory initialization error (problem too large?)", FUNC_ID);
+					case CVDLS_ILL_INPUT	: throw IBK::Exception("CVBand init error (wrong input?)", FUNC_ID);
+					default					: throw IBK::Exception("CVBand init error", FUNC_ID);
+				}
+				break;
+
+			case SolverInput::LES_GMRES :
+				// matrix-free GMRES, with exact preconditioner only few Krylov vectors are needed
+				result = CVSpgmr(m_cvodeMem, PREC_LEFT, 5);
+				if (result != CVSPILS_SUCCESS)
+					throw IBK::Exception("CVSpgmr init error", FUNC_ID);
+				CVSpilsSetJacTimesVecFn(m_cvodeMem, jtimes_solver);
+				CVSpilsSetPreconditioner(m_cvodeMem, psetup_solver, psolve_solver);
+				m_precGamma = 0;
+				m_precFactors.clear();
+				break;
+		}
+	}
+
+	// locate breakthrough times (rising outlet concentration only)
+	if (!m_input.breakthroughFractions.empty()) {
+		result = CVodeRootInit(m_cvodeMem, m_input.breakthroughFractions.size(), g_solver);
+		if (result != CV_SUCCESS)
+			throw IBK::Exception("CVodeRootInit init error.", FUNC_ID);
+		std::vector<int> rootDirection(m_input.breakthroughFractions.size(), 1);
+		CVodeSetRootDirection(m_cvodeMem, &rootDirection[0]);
 	}
 
 	// set CVODE parameters
-	CVodeSetUserData(m_cvodeMem, (void*)this);
 	// set CVODE Max-order
-	CVodeSetMaxOrd(m_cvodeMem, 5);
+	CVodeSetMaxOrd(m_cvodeMem, m_statistics.maxOrder);
+	// stability limit detection (BDF only) reduces the order if the step size is limited by stability
+	CVodeSetStabLimDet(m_cvodeMem, m_statistics.stabLimDet ? TRUE : FALSE);
 	// set CVODE maximum steps before reaching tout
 	CVodeSetMaxNumSteps(m_cvodeMem, 100000);
 	// set CVODE initial step size
-	CVodeSetInitStep(m_cvodeMem, 1e-3/m_n);
+	CVodeSetInitStep(m_cvodeMem, h0);
 	// set CVODE maximum step size
-	CVodeSetMaxStep(m_cvodeMem, input.maxDt);
+	CVodeSetMaxStep(m_cvodeMem, m_input.maxDt);
 	// set CVODE minimum step size
-	CVodeSetMinStep(m_cvodeMem, input.minDt);
+	CVodeSetMinStep(m_cvodeMem, m_input.minDt);
+	// never step beyond the end time, the inlet concentration may jump there (periodic operation)
+	CVodeSetStopTime(m_cvodeMem, m_tEnd);
 	// set tolerances
 	CVodeSVtolerances(m_cvodeMem, m_relTol, m_absTolVec);
+}
 
 
-	m_cInletData = input.cInletData; // Note: makespline() was already done!
+void Solver::cvodeCounters(SolverStatistics & stats) const {
+	stats.clearCounters();
+	if (m_cvodeMem == nullptr)
+		return;
+	CVodeGetNumSteps(m_cvodeMem, &stats.steps);
+	CVodeGetNumRhsEvals(m_cvodeMem, &stats.rhsEvals);
+	CVodeGetNumLinSolvSetups(m_cvodeMem, &stats.linSetups);
+	CVodeGetNumErrTestFails(m_cvodeMem, &stats.errTestFails);
+	CVodeGetNumNonlinSolvIters(m_cvodeMem, &stats.nonlinIters);
+	CVodeGetNumNonlinSolvConvFails(m_cvodeMem, &stats.nonlinConvFails);
+	if (m_statistics.stabLimDet)
+		CVodeGetNumStabLimOrderReds(m_cvodeMem, &stats.stabLimOrderReds);
+	// right-hand side evaluations of the difference-quotient band Jacobian
+	if (m_statistics.newton && m_input.linearSolver == SolverInput::LES_BAND) {
+		long int nfevalsLS = 0;
+		CVDlsGetNumRhsEvals(m_cvodeMem, &nfevalsLS);
+		stats.rhsEvals += nfevalsLS;
+	}
+}
 
-	// initialization of working variables
-	m_cREV.resize(m_n);
-	m_cc.resize(m_n);
-	m_smu_c.resize(m_n);
-	m_sgamma_c.resize(m_n);
-	m_jdiff.resize(m_n+1);
-	m_jconv.resize(m_n+1);
 
-	if (input.model == SolverInput::PLUS_EXCHANGE) {
-		m_sREV.resize(m_n);
-		m_sc.resize(m_n);
-		m_smu_s.resize(m_n);
-		m_sgamma_s.resize(m_n);
-		m_sbeta.resize(m_n);
+SolverStatistics Solver::statistics() const {
+	// configuration and counters of released CVODE instances
+	SolverStatistics stats = m_statistics;
+	SolverStatistics current;
+	cvodeCounters(current);
+	stats.addCounters(current);
+	for (unsigned int i=0; i<m_observers.size(); ++i)
+		m_observers[i]->statistics(stats);
+	return stats;
+}
+
+
+std::shared_ptr<ProfileStore> Solver::newProfileStore(const SolverInput & input) {
+	unsigned int components = (input.model == SolverInput::PLUS_EXCHANGE) ? 2 : 1;
+	double tolerance = (input.profileTolerance > 0) ? input.profileTolerance : input.absTol;
+	return std::shared_ptr<ProfileStore>(new ProfileStore(input.n, components,
+		input.mappedProfiles ? ProfileStore::STORAGE_MAPPED_FILE : ProfileStore::STORAGE_MEMORY,
+		static_cast<ProfileStore::compression_t>(input.profileCompression), tolerance));
+}
+
+
+int Solver::integrateActiveWindow(double tOut) {
+	double t = m_t;
+	while (t < tOut) {
+		int result = CVode(m_cvodeMem, tOut, m_yStorage, &t, CV_ONE_STEP);
+		if (result < 0)
+			return result;
+
+		// enlarge active window once the front has reached the safety margin
+		unsigned int margin = std::min(m_nActive, std::max(1u, m_input.activeWindowMargin));
+		const double * y = N_VGetArrayPointer(m_yStorage);
+		for (unsigned int i=(m_nActive - margin)*m_nVars; i<m_nActive*m_nVars; ++i) {
+			if (y[i] > m_input.absTol) {
+				// CVODE cannot interpolate after re-initialization, hence a step beyond
+				// the output time point is cut back to the output time point
+				bool atOutput = (t >= tOut);
+				if (atOutput) {
+					result = CVodeGetDky(m_cvodeMem, tOut, 0, m_yStorage);
+					if (result < 0)
+						return result;
+					t = tOut;
+				}
+				growActiveWindow(t);
+				if (atOutput) {
+					m_t = tOut;
+					return CV_SUCCESS;
+				}
+				break;
+			}
+		}
+
+		// once the whole domain is active, continue with normal integration
+		if (m_nActive == m_n)
+			return CVode(m_cvodeMem, tOut, m_yStorage, &m_t, CV_NORMAL);
 	}
+	// interpolate solution at output time point
+	int result = CVodeGetDky(m_cvodeMem, tOut, 0, m_yStorage);
+	m_t = tOut;
+	return result;
+}
 
-	m_outputCounter = 0;
 
-	// initialization complete
-	m_initialized = true;
+void Solver::growActiveWindow(double t) {
+	FUNCID(Solver::growActiveWindow);
+
+	// restart with the last step size to avoid many tiny steps after re-initialization
+	double h0 = 0;
+	CVodeGetLastStep(m_cvodeMem, &h0);
+
+	unsigned int margin = std::max(1u, m_input.activeWindowMargin);
+	unsigned int nActive = std::min(m_n, m_nActive + std::max(2*margin, m_nActive/4));
+
+	N_Vector y = newVector(nActive*m_nVars);
+	if (!y)
+		throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+
+	// copy solution of the active window, elements ahead of the front are empty
+	double * yOld = N_VGetArrayPointer(m_yStorage);
+	double * yNew = N_VGetArrayPointer(y);
+	std::copy(yOld, yOld + m_nActive*m_nVars, yNew);
+	std::fill(yNew + m_nActive*m_nVars, yNew + nActive*m_nVars, 0.0);
+	N_VDestroy(m_yStorage);
+	m_yStorage = y;
+	m_nActive = nActive;
+
+	initCVODE(t, h0);
+}
+
+
+void Solver::setState(double t, N_Vector y) {
+	FUNCID(Solver::setState);
+	if (m_input.engine != SolverInput::ENGINE_CVODE || m_nActive != m_n)
+		throw IBK::Exception("Setting the state is only supported by the CVODE engine without active window.", FUNC_ID);
+	// y may be of another vector type (see newVector()), hence the lengths are obtained from the
+	// workspace sizes and the data is copied directly
+	long int length, lengthStorage, liw;
+	N_VSpace(y, &length, &liw);
+	N_VSpace(m_yStorage, &lengthStorage, &liw);
+	if (length != lengthStorage)
+		throw IBK::Exception("Mismatching size of solution vector.", FUNC_ID);
+	std::copy(N_VGetArrayPointer(y), N_VGetArrayPointer(y) + length, N_VGetArrayPointer(m_yStorage));
+	m_t = t;
+	// continue counting outputs as if the run had been started at t = 0
+	m_outputCounter = static_cast<unsigned int>(std::floor(t/m_input.outputDt + 0.5));
+	initCVODE(m_t, m_statistics.initialStep);
 }
 
 
 void Solver::run() {
 	FUNCID(Solver::run);
 	if (!m_initialized) return;
+	if (m_input.steadyState == SolverInput::SS_DIRECT) {
+		// steady state was computed in init(), it is stored as only output at the end time
+		m_t = m_tEnd;
+		m_outputCounter = 0;
+		storeOutput(true);
+		return;
+	}
+	switch (m_input.engine) {
+		case SolverInput::ENGINE_CVODE :
+			break;
+
+		case SolverInput::ENGINE_CHARACTERISTIC :
+			runCharacteristic();
+			interpolateBreakthrough();
+			return;
+
+		case SolverInput::ENGINE_IMEX :
+			runIMEX();
+			interpolateBreakthrough();
+			return;
+
+		case SolverInput::ENGINE_MULTIRATE :
+			runMultirate();
+			interpolateBreakthrough();
+			return;
+	}
 	// calculate everything for first step so that we can write the inital output
 	storeOutput();
-	// call CVODE in steps
+	// call CVODE in steps, first output follows the start time point (see setState())
 	double dt_out = m_input.outputDt;
-	double t_out = dt_out;
+	double t_out = (std::floor(m_t/dt_out + 0.5) + 1)*dt_out;
+	// next checkpoint time point, output time points may deviate by round-off from multiples of m_checkpointDt
+	double t_checkpoint = m_tEnd;
+	if (m_checkpointDt > 0)
+		t_checkpoint = (std::floor(m_t/m_checkpointDt + 1e-6) + 1)*m_checkpointDt;
 	int progress = 0; // for the progress indicator
 	while (m_t < m_tEnd) {
 		// run CVODE
-		int result = CVode(m_cvodeMem, t_out, m_yStorage, &m_t, CV_NORMAL);
+		int result;
+		if (m_nActive < m_n)
+			result = integrateActiveWindow(t_out);
+		else
+			result = CVode(m_cvodeMem, t_out, m_yStorage, &m_t, CV_NORMAL);
 		if (result < 0)
 			throw IBK::Exception("Error while integrating solution.", FUNC_ID);
+		// breakthrough found, continue to the output time point unless the run ends here
+		if (result == CV_ROOT_RETURN) {
+			if (recordBreakthrough())
+				break;
+			continue;
+		}
 		int section = static_cast<int>(m_t/m_tEnd*10);
 		if (section > progress) {
 			std::cout << ".";
 			progress = section;
 		}
 		storeOutput();
+		// once the steady state is reached, it also gives the remaining outputs
+		if (m_input.steadyState == SolverInput::SS_TERMINATION && steadyStateReached()) {
+			N_VScale(1, m_ySteady, m_yStorage);
+			for (t_out += dt_out; m_t < m_tEnd; t_out += dt_out) {
+				m_t = t_out;
+				storeOutput();
+			}
+			break;
+		}
+		if (!m_checkpointFile.empty() && m_checkpointDt > 0 && m_t + 1e-6*m_checkpointDt >= t_checkpoint && m_t < m_tEnd) {
+			writeCheckpoint(m_checkpointFile);
+			t_checkpoint = (std::floor(m_t/m_checkpointDt + 1e-6) + 1)*m_checkpointDt;
+		}
 		t_out += dt_out;
 	}
+	// final checkpoint, before the output counter is reset below
+	if (!m_checkpointFile.empty())
+		writeCheckpoint(m_checkpointFile);
 	m_outputCounter = 0; // force storage of profiles
-	storeOutput();
+	storeOutput(true);
 }
 
+
+void Solver::addObserver(SolverObserver * observer) {
+	m_observers.push_back(observer);
+}
+
+
 int Solver::calculateDivergences(double t, N_Vector y_vec, N_Vector ydot_vec) {
 	// readability improvements
-	double * y = NV_DATA_S(y_vec);
+	double * y = N_VGetArrayPointer(y_vec);
 	double * ydot = nullptr;
 	if (ydot_vec != nullptr)
-		ydot = NV_DATA_S(ydot_vec);
+		ydot = N_VGetArrayPointer(ydot_vec);
+
+	// calculate inlet concentration
+	double	cIn = inletConcentration(t);
+
+	if (m_threads > 1)
+		calculateDivergencesThreaded(cIn, y, ydot);
+	else
+		divergenceKernel(0, m_nActive, cIn, 0, y, ydot);
+	return 0;
+}
+
+
+void Solver::divergenceKernel(unsigned int i0, unsigned int i1, double ccUp, double ccDown,
+							  const double * y, double * ydot)
+{
 	double	A		= m_input.A;
 	double	L		= m_input.L;
 //	double	p		= m_input.p;
@@ -209,59 +579,11 @@ int Solver::calculateDivergences(double t, N_Vector y_vec, N_Vector ydot_vec) {
 	double	mus		= m_input.mus;
 	double	gammas	= m_input.gammas;
 	double	beta	= m_input.beta;
-
-	// calculate inlet concentration
-	double	cIn = m_input.cInlet;
-	if (!m_cInletData.empty())
-		cIn = m_cInletData.value(t/3600.0); // don't forget to convert to h
+	bool	exchange = (m_input.model == SolverInput::PLUS_EXCHANGE);
 
 	double V_rev = A * L/m_n;
 	double dx = L/m_n;
 
-	// first extract the primary and secondary state variables from the solution vector
-	switch (m_input.model) {
-		case SolverInput::DIFF_CONV_PARTITION :
-			{
-				// equilibrium sorption, y contains total mass densities in kg/m3,
-				for (unsigned int i=0; i<m_n; ++i) {
-					// store total mass density in kg/m3
-					m_cREV[i] = y[i];
-					// calculate gas/mobile phase mass densities by dividing by the retention coefficient
-					m_cc[i] = m_cREV[i]/Rc;
-				}
-			}
-			break;
-
-		case SolverInput::PLUS_EXCHANGE :
-			{
-				// separate flow domains
-				// y1 contains total gas/mobile mass densities with respect to REV
-				// y2 contains immobile mass densities with respect to REV
-				for (unsigned int i=0; i<m_n; ++i) {
-					// store total mass density in kg/m3
-					m_cREV[i] = y[i*m_nVars];
-					// store gas/mobile phase mass density in kg/m3(gas)
-					m_cc[i] = m_cREV[i]/Rc;
-					// store total sorbed phase VOC mass density in kg/m3
-					m_sREV[i] = y[i*m_nVars + 1];
-					// store sorbed phase VOC mass density in kg/m3
-					m_sc[i] = m_sREV[i]/Rs;
-				}
-			}
-			break;
-	} // switch
-
-	// ensure all mass densities are non-negative (by clipping)
-	for (size_t i=0; i<m_cc.size(); ++i)
-		m_cc[i] = std::max(0.0, m_cc[i]);
-	for (size_t i=0; i<m_cREV.size(); ++i)
-		m_cREV[i] = std::max(0.0, m_cREV[i]);
-
-	for (size_t i=0; i<m_sc.size(); ++i)
-		m_sc[i] = std::max(0.0, m_sc[i]);
-	for (size_t i=0; i<m_sREV.size(); ++i)
-		m_sREV[i] = std::max(0.0, m_sREV[i]);
-
 	// Node numbering
 	//    0                 - first bed node
 	//    m_nVars           - second bed node
@@ -278,92 +600,199 @@ int Solver::calculateDivergences(double t, N_Vector y_vec, N_Vector ydot_vec) {
 	//    1                 - interface between first and second bed node
 	//    m_n               - last interface downstream (outlet)
 
-	// calculate bed fluxes
-	unsigned int i_lastBedNode = m_n-1;
-
-	// ** Boundary conditions **
-
-	// at the inlet we have convection and axial diffusion
-	// only downwind fluxes permitted
-	m_jdiff[0] = D * A * (cIn - m_cc[0])/dx;		// m2/s * m2 * kg/m3 / m = kg/s
-	m_jconv[0] = v * A * cIn;						// m3/m2s * m2 * kg/m3 = kg/s
-
-	// at the filter outlet we only consider convection, no back diffusion
-	m_jdiff[m_n] = 0;
-	m_jconv[m_n] = v * A * m_cc[i_lastBedNode];
+	for (unsigned int i=i0; i<i1; ++i) {
+		// y contains total mass densities in kg/m3, with PLUS_EXCHANGE alternating the total mobile
+		// mass densities and the immobile mass densities with respect to REV;
+		// all mass densities are kept non-negative (by clipping)
+		m_cREV[i] = std::max(0.0, y[i*m_nVars]);
+		// gas/mobile phase mass densities by dividing by the retention coefficient
+		m_cc[i] = std::max(0.0, y[i*m_nVars]/Rc);
+		if (exchange) {
+			m_sREV[i] = std::max(0.0, y[i*m_nVars + 1]);
+			m_sc[i] = std::max(0.0, y[i*m_nVars + 1]/Rs);
+		}
 
-	// now calculate the internal convection and axial diffusion fluxes
-	for (unsigned int i=1; i<m_n; ++i) {
-		m_jdiff[i] = D * A * (m_cc[i-1] - m_cc[i])/dx;
-		m_jconv[i] = v * A * m_cc[i-1]; // first order upwind
-	}
+		// upstream interface: at the inlet (ccUp = cIn) we have convection and axial diffusion,
+		// only downwind fluxes permitted
+		m_jdiff[i] = D * A * (ccUp - m_cc[i])/dx;	// m2/s * m2 * kg/m3 / m = kg/s
+		m_jconv[i] = v * A * ccUp;					// m3/m2s * m2 * kg/m3 = kg/s, first order upwind
+		ccUp = m_cc[i];
 
-	// calculate sources/sinks
-	for (unsigned int i=0; i<m_n; ++i) {
+		// sources/sinks
 		m_smu_c[i] = muc*m_cc[i];		// 1/s * kg/m3 = kg/m3s
 		m_sgamma_c[i] = gammac;			// kg/m3s
-		if (m_input.model == SolverInput::PLUS_EXCHANGE) {
+		if (exchange) {
 			m_smu_s[i] = mus*m_sc[i];		// 1/s * kg/m3 = kg/m3s
 			m_sgamma_s[i] = gammas;			// kg/m3s
 			m_sbeta[i] = beta*(m_cc[i] - m_sc[i]);	// kg/m3s - negative for eq 1, positive for eq 2
 		}
 	}
+	if (i0 == i1)
+		return;
+
+	// downstream interface of the range: at the filter outlet we only consider convection, no back diffusion;
+	// at the end of the active window, mass is transported into the empty region ahead of the front;
+	// within the domain the downstream halo ccDown is used (not stored, it belongs to the next range)
+	double jdiffOut, jconvOut;
+	double ccLast = m_cc[i1-1];
+	if (i1 == m_nActive) {
+		jdiffOut = (m_nActive < m_n) ? D * A * ccLast/dx : 0;
+		jconvOut = v * A * ccLast;
+		m_jdiff[m_nActive] = jdiffOut;
+		m_jconv[m_nActive] = jconvOut;
+	}
+	else {
+		jdiffOut = D * A * (ccLast - ccDown)/dx;
+		jconvOut = v * A * ccLast;
+	}
 
 	// store divergences back in ydot vector, if we have one given
 	if (ydot != nullptr) {
-		switch (m_input.model) {
-			case SolverInput::DIFF_CONV_PARTITION :
-				{
-					for (unsigned int i=0; i<m_n; ++i) {
-						// calculate divergences
-						double div = (m_jdiff[i] + m_jconv[i] - m_jdiff[i+1] - m_jconv[i+1]
-							- m_smu_c[i] + m_sgamma_c[i])/V_rev;
-						ydot[i] = div;
-					}
-				}
-				break;
+		for (unsigned int i=i0; i<i1; ++i) {
+			double jdiffDown = (i+1 < i1) ? m_jdiff[i+1] : jdiffOut;
+			double jconvDown = (i+1 < i1) ? m_jconv[i+1] : jconvOut;
+			if (exchange) {
+				// divergence for mobile phase
+				ydot[i*m_nVars] = (m_jdiff[i] + m_jconv[i] - jdiffDown - jconvDown
+					 - m_sbeta[i] - m_smu_c[i] + m_sgamma_c[i])/V_rev;
+				// divergence for immobile phase
+				ydot[i*m_nVars + 1] = (m_sbeta[i] - m_smu_s[i] + m_sgamma_s[i])/V_rev;
+			}
+			else {
+				ydot[i] = (m_jdiff[i] + m_jconv[i] - jdiffDown - jconvDown
+					- m_smu_c[i] + m_sgamma_c[i])/V_rev;
+			}
+		}
+	}
+}
+
+
+void Solver::localSystem(double M[4], double g[2]) const {
+	double V_rev = m_input.A * m_input.L/m_n;
+	double Rc = m_input.Rc;
+	double Rs = m_input.Rs;
+	double beta = m_input.beta;
+
+	M[0] = M[1] = M[2] = M[3] = 0;
+	g[0] = g[1] = 0;
+	switch (m_input.model) {
+		case SolverInput::DIFF_CONV_PARTITION :
+			M[0] = -m_input.muc/Rc/V_rev;
+			g[0] = m_input.gammac/V_rev;
+			break;
+
+		case SolverInput::PLUS_EXCHANGE :
+			M[0] = -(beta + m_input.muc)/Rc/V_rev;
+			M[1] = beta/Rs/V_rev;
+			M[2] = beta/Rc/V_rev;
+			M[3] = -(beta + m_input.mus)/Rs/V_rev;
+			g[0] = m_input.gammac/V_rev;
+			g[1] = m_input.gammas/V_rev;
+			break;
+	}
+}
+
+
+N_Vector Solver::newVector(unsigned int length) const {
+#if defined(_OPENMP)
+	if (m_threads > 1)
+		return N_VNew_OpenMP(length, m_threads);
+#endif
+	return N_VNew_Simd(length);
+}
 
-			case SolverInput::PLUS_EXCHANGE :
-				{
-					for (unsigned int i=0; i<m_n; ++i) {
-						// calculate divergence for mobile phase
-						double div_c = (m_jdiff[i] + m_jconv[i] - m_jdiff[i+1] - m_jconv[i+1]
-							 - m_sbeta[i] - m_smu_c[i] + m_sgamma_c[i])/V_rev;
-						// calculate divergence for mobile phase
-						double div_s = (m_sbeta[i] - m_smu_s[i] + m_sgamma_s[i])/V_rev;
-						ydot[i*m_nVars] = div_c;
-						ydot[i*m_nVars + 1] = div_s;
-					}
-				}
-				break;
 
-		} // switch
-/*
-#ifdef _DEBUG
-		std::vector<double> y_debug(y, y + m_n*m_nVars);
-		std::vector<double> ydot_debug(ydot, ydot + m_n*m_nVars);
-#endif // _DEBUG
-*/
+double Solver::inletConcentration(double t) const {
+	if (m_cInletData.empty())
+		return m_input.cInlet;
+	// periodic operation repeats the inlet data
+	if (m_input.cyclePeriod > 0)
+		t = std::fmod(t, m_input.cyclePeriod);
+	return m_cInletData.value(t/3600.0); // don't forget to convert to h
+}
+
+
+void Solver::breakthroughFunctions(N_Vector y, double * g) const {
+	// outlet element is empty as long as it is ahead of the active window
+	double cOut = 0;
+	if (m_nActive == m_n)
+		cOut = N_VGetArrayPointer(y)[(m_n-1)*m_nVars]/m_input.Rc;
+	for (unsigned int k=0; k<m_input.breakthroughFractions.size(); ++k)
+		g[k] = cOut - m_input.breakthroughFractions[k]*m_cFeed;
+}
+
+
+bool Solver::recordBreakthrough() {
+	std::vector<int> rootsFound(m_breakthroughT.size(), 0);
+	CVodeGetRootInfo(m_cvodeMem, &rootsFound[0]);
+	bool allReached = true;
+	for (unsigned int k=0; k<m_breakthroughT.size(); ++k) {
+		if (rootsFound[k] != 0 && m_breakthroughT[k] < 0)
+			m_breakthroughT[k] = m_t/3600;
+		allReached = allReached && (m_breakthroughT[k] >= 0);
 	}
-	return 0;
+	return m_input.stopAtBreakthrough && allReached;
 }
 
 
-void Solver::storeOutput() {
+void Solver::interpolateBreakthrough() {
+	for (unsigned int k=0; k<m_breakthroughT.size(); ++k) {
+		double c = m_input.breakthroughFractions[k]*m_cFeed;
+		for (unsigned int i=1; i<m_outletC.size(); ++i) {
+			if (m_outletC[i-1] < c && m_outletC[i] >= c) {
+				double alpha = (c - m_outletC[i-1])/(m_outletC[i] - m_outletC[i-1]);
+				m_breakthroughT[k] = m_outletT[i-1] + alpha*(m_outletT[i] - m_outletT[i-1]);
+				break;
+			}
+		}
+	}
+}
+
+
+void Solver::storeOutput(bool last) {
 	// don't add, if we just added a profile for this point
 	if (!m_outletT.empty() && fabs(m_outletT.back() - m_t/3600) < 1e-10)
 		return;
-	// re-calculate the temporary variables again for the
-	// current output values in m_yStorage
-	calculateDivergences(0, m_yStorage, nullptr);
-	// store the outlet concentration along with the current time point in a vector
-	m_outletT.push_back(m_t/3600.0);
-	m_outletC.push_back(m_cc[m_n-1]);
-	// also store field outputs if counter matches multiplier
-	if (m_outputCounter % m_input.outputN == 0) {
-		m_ccProfile.push_back(m_cc);
-		m_scProfile.push_back(m_sc);
-		m_tProfile.push_back(m_t/3600);
+	// compute only the quantities needed by the observers from the current output values in m_yStorage
+	unsigned int quantities = 0;
+	for (unsigned int i=0; i<m_observers.size(); ++i)
+		quantities |= m_observers[i]->quantities();
+	SolverOutput out;
+	out.t = m_t/3600.0;
+	// the final call at the end time is usually dropped as duplicate, so the last output is detected here
+	out.last = last || out.t > m_tEnd/3600.0 - 1e-10;
+	out.scheduled = out.last || (m_outputCounter % m_input.outputN == 0);
+	out.n = m_n;
+	out.y = N_VGetArrayPointer(m_yStorage);
+	out.nActive = m_nActive;
+	out.nVars = m_nVars;
+	out.cc = nullptr;
+	out.sc = nullptr;
+	if (quantities & SolverObserver::Q_PROFILES) {
+		updateConcentrations();
+		out.cc = &m_cc[0];
+		if (m_input.model == SolverInput::PLUS_EXCHANGE)
+			out.sc = &m_sc[0];
 	}
+	// elements ahead of the active window are empty
+	out.outletC = 0;
+	if (m_nActive == m_n)
+		out.outletC = std::max(0.0, out.y[(m_n-1)*m_nVars]/m_input.Rc);
+	// store the outlet concentration along with the current time point in a vector
+	m_outletT.push_back(out.t);
+	m_outletC.push_back(out.outletC);
+	for (unsigned int i=0; i<m_observers.size(); ++i)
+		m_observers[i]->observe(out);
 	++m_outputCounter;
 }
+
+
+void Solver::updateConcentrations() {
+	const double * y = N_VGetArrayPointer(m_yStorage);
+	for (unsigned int i=0; i<m_nActive; ++i)
+		m_cc[i] = std::max(0.0, y[i*m_nVars]/m_input.Rc);
+	if (m_input.model == SolverInput::PLUS_EXCHANGE) {
+		for (unsigned int i=0; i<m_nActive; ++i)
+			m_sc[i] = std::max(0.0, y[i*m_nVars + 1]/m_input.Rs);
+	}
+}
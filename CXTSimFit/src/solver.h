@@ -9,16 +9,30 @@
 #include <string>
 #include <iosfwd>
 #include <vector>
+#include <memory>
 
 // includes of the sundials library
 #include <sundials/sundials_types.h>
+#include <sundials/sundials_direct.h>
 #include <nvector/nvector_serial.h>
 #include <cvode/cvode.h>
 
 #include "solverinput.h"
+#include "solverstatistics.h"
+#include "profilestore.h"
+#include "solverobserver.h"
 
 /// Example implementation for a CVODE based solver.
 class Solver {
+	// Wrapper functions for the CVSpgmr linear solver module, defined in solverkrylov.cpp
+	friend int jtimes_solver(N_Vector v, N_Vector Jv, realtype t, N_Vector y, N_Vector fy,
+							 void *user_data, N_Vector tmp);
+	friend int psetup_solver(realtype t, N_Vector y, N_Vector fy, booleantype jok, booleantype *jcurPtr,
+							 realtype gamma, void *user_data, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
+	friend int psolve_solver(realtype t, N_Vector y, N_Vector fy, N_Vector r, N_Vector z,
+							 realtype gamma, realtype delta, int lr, void *user_data, N_Vector tmp);
+	// The reduced-order model projects the analytical Jacobian.
+	friend class PODModel;
 public:
 	/// Constructor.
 	Solver();
@@ -31,24 +45,192 @@ public:
 	/// Starts the solver
 	void run();
 
+	/// Attaches an observer that is called at each output time point (after init(), before run()).
+	/// The observer is not owned by the solver and must exist until the run is completed.
+	/// Without observers, only the outlet series is stored.
+	void addObserver(SolverObserver * observer);
+
+	/// Replaces the current solution with y (all m_n*m_nVars values) at time point t in s and restarts
+	/// the integrator, so that a following run() continues from t to the end time.
+	/// Only supported for ENGINE_CVODE without active window.
+	void setState(double t, N_Vector y);
+	/// Returns the current solution vector.
+	N_Vector state() const { return m_yStorage; }
+
+	/// Lets run() write checkpoints (see writeCheckpoint()) to filename, at the first output at or after
+	/// each multiple of dt in s and at the end of the run (only at the end if dt is 0).
+	/// Call after init(), only supported for transient runs of ENGINE_CVODE.
+	/// Implemented in solvercheckpoint.cpp, like the other checkpoint functions.
+	void setCheckpoints(const std::string & filename, double dt);
+
+	/// Writes the complete state of the run at the current time point to a binary file: CVODE memory
+	/// (serialized with the functions of cvode_serialization.h), linear solver data, solution,
+	/// integrator configuration and counters, outlet series and breakthrough times so far.
+	/// The file is written to filename.tmp first and then renamed, so that an interrupted write keeps
+	/// the previous checkpoint. Throws an IBK::Exception if the file cannot be written.
+	void writeCheckpoint(const std::string & filename) const;
+
+	/// Replaces the state set by init() with a checkpoint, so that a following run() continues from the
+	/// checkpoint time to the end time of the current input (e.g. to extend the end time or to resume
+	/// an interrupted run). Grid, model, physical parameters, inlet concentration (also the series),
+	/// tolerances, integrator method, linear solver and breakthrough fractions must equal those of the
+	/// checkpointed run, end time, step limits and output settings may differ.
+	/// Observers only see the outputs after the checkpoint time. Call after init(), throws an
+	/// IBK::Exception if the file cannot be read or does not match the input.
+	/// The CVODE data is restored through N_VectorContent_Serial, which requires the SIMD and OpenMP
+	/// vectors to share the layout of its members (checked at compile time in solvercheckpoint.cpp).
+	void restoreCheckpoint(const std::string & filename);
+
 	/// System function called by the solver.
 	/// This function is used to calculate the divergences (right-hand-sides)
 	/// of the differential equations. Implement all the physics in this equation.
 	int calculateDivergences(double t, N_Vector y, N_Vector ydot);
 
+	/// Returns the state-independent part of the divergences, f(t,0) = cIn(t)*bInlet + bConst
+	/// (vectors with m_nActive*m_nVars values). Together with jacobianTimesVector() this gives the
+	/// linear system without clipping, used by the reduced-order model (see PODModel).
+	void affineTerms(double * bInlet, double * bConst) const;
+
+	/// Returns the inlet concentration in kg/m3 at time point t in s.
+	double inletConcentration(double t) const;
+
+	/// Root functions for the breakthrough times (called from CVODE), one value per breakthrough fraction:
+	/// outlet concentration minus fraction times feed concentration.
+	void breakthroughFunctions(N_Vector y, double * g) const;
+
+	/// Computes the steady state for the inlet concentration at time point t in s with KINSOL.
+	/// y holds the initial guess (all m_n*m_nVars values) and the steady state on return.
+	/// Throws an IBK::Exception if the solver fails. Implemented in solversteadystate.cpp.
+	void solveSteadyState(double t, N_Vector y);
+
+	/// Stores the analytical Jacobian of the divergences (without clipping) in the band matrix J.
+	void steadyStateJacobian(DlsMat J) const;
+
 	std::vector<double>		m_outletT;	///< Vector with time points of outlet data in [s]
 	std::vector<double>		m_outletC;	///< Vector with concentrations at outlet in [kg/m3s]
+	/// First crossing times of SolverInput::breakthroughFractions in [h], -1 if not reached.
+	std::vector<double>		m_breakthroughT;
 
 	/// Returns the input data object, that containts all input data for the solver.
 	const SolverInput &		input() const { return m_input; }
 
-	const std::vector<std::vector<double> > & ccProfile() const { return m_ccProfile; }
-	const std::vector<std::vector<double> > & scProfile() const { return m_scProfile; }
-	const std::vector<double> &				  tProfile() const { return m_tProfile; }
+	/// Creates an empty profile store for the grid of input, with the storage and compression
+	/// settings of input (used with a ProfileRecorder attached to the solver and by the drivers that
+	/// assemble profiles).
+	static std::shared_ptr<ProfileStore> newProfileStore(const SolverInput & input);
+
+	/// Returns integrator configuration and counters of the run so far (ENGINE_CVODE only).
+	SolverStatistics statistics() const;
 
 private:
-	/// Stores output data.
-	void storeOutput();
+	/// Updates the state-dependent part of the analytical Jacobian for state y, with divergences fy
+	/// and the factor gamma of the Newton matrix I - gamma*J passed to the preconditioner setup
+	/// (proportional to the step size). Implemented in solverkrylov.cpp.
+	void updateJacobian(const double * y, const double * fy, double gamma);
+
+	/// Computes the product of the Jacobian with vector v (only active window), using the analytical
+	/// flux derivatives.
+	void jacobianTimesVector(const double * v, double * Jv) const;
+
+	/// Computes the factorization of the block-tridiagonal preconditioner P = I - gamma*J.
+	/// Since J is the exact (analytical) Jacobian, the preconditioner is exact as well.
+	void setupPreconditioner(double gamma);
+
+	/// Solves P z = r with the factorization computed in setupPreconditioner().
+	void solvePreconditioner(const double * r, double * z) const;
+
+	/// Creates the CVODE memory for the currently active part of the domain.
+	/// Expects m_yStorage to hold the initial values at time point t0.
+	/// @param t0 Start time point in s.
+	/// @param h0 Initial step size in s.
+	void initCVODE(double t0, double h0);
+
+	/// Sets the integrator configuration in m_statistics according to SolverInput::integrator.
+	/// For INTEGRATOR_AUTO the Jacobian and the initial solution are probed.
+	/// Implemented in solverprobe.cpp.
+	void configureIntegrator();
+
+	/// Integrates the initial state up to tProbe with the Adams method (functional iteration) or BDF
+	/// (Newton iteration) and returns the cost in right-hand side evaluation equivalents. Returns
+	/// the largest double if the integration fails or its cost exceeds maxCost before tProbe.
+	/// State, time point and counters are restored afterwards, also if the integration throws.
+	/// Implemented in solverprobe.cpp.
+	double probeCost(bool adams, double tProbe, double maxCost);
+
+	/// Stores the counters of the current CVODE instance in stats.
+	void cvodeCounters(SolverStatistics & stats) const;
+
+	/// Integrates in single steps up to tOut while the active window is smaller than the domain.
+	/// After each step the front position is checked and the active window is enlarged if needed.
+	/// Once the function returns, m_yStorage contains the solution at tOut.
+	/// @return Returns the CVODE return code.
+	int integrateActiveWindow(double tOut);
+
+	/// Enlarges the active window and re-initializes CVODE at time point t.
+	/// Expects m_yStorage to hold the solution at time point t.
+	void growActiveWindow(double t);
+
+	/// Integrates the solution with the characteristics engine (see SolverInput::ENGINE_CHARACTERISTIC).
+	/// Implemented in solvercharacteristic.cpp.
+	void runCharacteristic();
+
+	/// Integrates the solution with the IMEX engine (see SolverInput::ENGINE_IMEX).
+	/// Implemented in solverimex.cpp.
+	void runIMEX();
+
+	/// Integrates the solution with the multirate engine (see SolverInput::ENGINE_MULTIRATE).
+	/// Implemented in solvermultirate.cpp.
+	void runMultirate();
+
+	/// Creates a state vector with the given length, an OpenMP vector if m_threads > 1, otherwise a
+	/// SIMD vector (aligned storage, vectorized and fused operations, see nvector_simd.h).
+	N_Vector newVector(unsigned int length) const;
+
+	/// Computes the divergences of the elements [i0, i1) of the active window and the fluxes at their
+	/// interfaces, with all physics of calculateDivergences() (the only implementation of the equations).
+	/// ccUp is the mobile phase concentration upstream of element i0 (the inlet concentration for i0 = 0),
+	/// ccDown the clipped mobile phase concentration of element i1 (unused for i1 = m_nActive).
+	/// Ranges only write their own elements and their upstream interfaces, so that disjoint ranges can be
+	/// computed concurrently. ydot may be nullptr, then only the fluxes are computed.
+	void divergenceKernel(unsigned int i0, unsigned int i1, double ccUp, double ccDown,
+						  const double * y, double * ydot);
+
+	/// Computes the divergences like calculateDivergences() with m_threads OpenMP threads, each calling
+	/// divergenceKernel() for a contiguous chunk of elements. cIn is the inlet concentration in kg/m3.
+	/// Implemented in solverthreaded.cpp.
+	void calculateDivergencesThreaded(double cIn, const double * y, double * ydot);
+
+	/// Returns true if the inlet concentration is constant from time point t in s up to the end time.
+	bool constantInlet(double t) const;
+
+	/// Returns true if the current solution equals the steady state (within the integrator tolerances)
+	/// and the inlet concentration remains constant, used with SolverInput::SS_TERMINATION.
+	bool steadyStateReached() const;
+
+	/// Returns the linear system y' = M y + g of the local (per element) terms, i.e.
+	/// sorption, reaction, sources/sinks and exchange, using the same terms as calculateDivergences().
+	/// Matrix M is stored row-wise, only the first m_nVars x m_nVars coefficients are used.
+	void localSystem(double M[4], double g[2]) const;
+
+	/// Returns the Jacobian coefficients of the mobile phase transport terms of element i with respect
+	/// to the total mobile mass densities of the upstream element, the element itself and the downstream element.
+	void jacobianCoefficients(unsigned int i, double & lower, double & diag, double & upper) const;
+
+	/// Stores the outlet concentration and passes the outputs to the observers.
+	/// @param last True for the output at the end of the run (outputs at the end time are detected).
+	void storeOutput(bool last = false);
+
+	/// Computes m_cc and m_sc of all elements from the current solution in m_yStorage, with the same
+	/// conversion and clipping as calculateDivergences() but without the fluxes.
+	void updateConcentrations();
+
+	/// Stores the times of breakthrough fractions found by the CVODE root finding at the current time point.
+	/// Returns true if the run should end (SolverInput::stopAtBreakthrough and all fractions reached).
+	bool recordBreakthrough();
+
+	/// Determines the breakthrough times by linear interpolation of the outlet data
+	/// (engines without root finding).
+	void interpolateBreakthrough();
 
 	bool					m_initialized;	///< This variable is set to true, once the solver is successfully initialized
 
@@ -56,12 +238,14 @@ private:
 
 	double					m_t;			///< Current time point in s.
 	double					m_tEnd;			///< Last time point of simulation in s.
+	double					m_cFeed;		///< Feed concentration in kg/m3 (maximum inlet concentration), reference for breakthrough fractions.
 
 	unsigned int			m_outputCounter;	///< Number of break-through outputs done in s.
 	IBK::LinearSpline		m_cInletData;		///< Inlet concentration in kg/m3
 
 	unsigned int			m_n;			///< Number of elements.
 	unsigned int			m_nVars;		///< Number of variables per element.
+	unsigned int			m_nActive;		///< Number of elements currently integrated (active window, m_nActive <= m_n).
 
 	std::vector<double>		m_cREV;			///< Vector with total mass densities per element in kg/m3
 	std::vector<double>		m_cc;			///< Vector with gas/mobile phase mass densities in kg/m3
@@ -77,9 +261,8 @@ private:
 	std::vector<double>		m_smu_s;		///< Vector with chemical reaction fluxes in kg/s (n)
 	std::vector<double>		m_sgamma_s;		///< Vector with sources/sinks in kg/s (n)
 
-	std::vector<std::vector<double> >	m_ccProfile;	///< Gas/mobile phase concentration kg/m3
-	std::vector<std::vector<double> >	m_scProfile;	///< Gas/mobile phase concentration kg/m3
-	std::vector<double>					m_tProfile;		///< Time point for output.
+	/// Attached observers (not owned).
+	std::vector<SolverObserver*>	m_observers;
 
 	// *** CVODE Variables ***
 
@@ -89,12 +272,29 @@ private:
 	N_Vector		m_yStorage;
 	/// Vector for absolute tolerances, only needed during initialization.
 	N_Vector		m_absTolVec;
+	/// Steady-state solution for the inlet concentration at the end time (only with SolverInput::SS_TERMINATION).
+	N_Vector		m_ySteady;
+	/// Integrator configuration and counters of already released CVODE instances.
+	SolverStatistics	m_statistics;
 	/// Relative tolerance.
 	double			m_relTol;
+	/// Number of threads for the right-hand side and the vector operations (see SolverInput::threads).
+	unsigned int	m_threads;
+	/// Value of gamma that the preconditioner was computed for.
+	double			m_precGamma;
+	/// Factorized preconditioner, per element the inverse of the modified diagonal block (4 values)
+	/// and the coupling coefficients to the upstream and downstream element.
+	std::vector<double>	m_precFactors;
+	/// Derivatives of the clipped mass densities (between 0 and 1) used in the analytical Jacobian.
+	std::vector<double>	m_jacobianMask;
 	/// CVODE memory pointer.
 	void			*m_cvodeMem;
 	/// File handle for CVODE monitor variables.
 	std::ofstream	*m_cvodeMonitors;
+	/// Checkpoint file written by run(), empty if no checkpoints are written (see setCheckpoints()).
+	std::string		m_checkpointFile;
+	/// Checkpoint interval in s, 0 for a checkpoint at the end of the run only.
+	double			m_checkpointDt;
 };
 
 
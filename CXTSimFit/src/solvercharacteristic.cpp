@@ -0,0 +1,154 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "solver.h"
+
+/// Returns phi_1(z) = (exp(z) - 1)/z, evaluated accurately also for small z.
+static double phi1(double z) {
+	if (std::fabs(z) < 1e-8)
+		return 1 + 0.5*z;
+	return std::expm1(z)/z;
+}
+
+/// Returns the derivative of phi_1(z).
+static double phi1Derivative(double z) {
+	if (std::fabs(z) < 1e-4)
+		return 0.5 + z/6;
+	return (std::exp(z)*(z - 1) + 1)/(z*z);
+}
+
+/// Computes the exact propagator of the linear system y' = M y + g over the time step h,
+/// so that y(h) = E y(0) + b.
+/// Matrices are stored row-wise, the system size is either 1 or 2.
+/// The 2x2 matrix functions are evaluated with Sylvester's formula, since M
+/// has real eigenvalues (the off-diagonal exchange terms have the same sign).
+static void localPropagator(unsigned int nVars, const double M[4], const double g[2], double h,
+							double E[4], double b[2])
+{
+	if (nVars == 1) {
+		E[0] = std::exp(M[0]*h);
+		b[0] = h*phi1(M[0]*h)*g[0];
+		return;
+	}
+
+	double tr = M[0] + M[3];
+	double det = M[0]*M[3] - M[1]*M[2];
+	double disc = std::sqrt(std::max(0.0, 0.25*tr*tr - det));
+	double l1 = 0.5*tr + disc;
+	double l2 = 0.5*tr - disc;
+
+	// P = h*phi_1(M h), such that E = I + P M and b = P g
+	double P[4];
+	if ((l1 - l2)*h > 1e-6) {
+		double f1 = h*phi1(l1*h);
+		double f2 = h*phi1(l2*h);
+		for (unsigned int k=0; k<4; ++k) {
+			double I = (k == 0 || k == 3) ? 1 : 0;
+			P[k] = (f1*(M[k] - l2*I) - f2*(M[k] - l1*I))/(l1 - l2);
+		}
+	}
+	else {
+		// (nearly) identical eigenvalues
+		double l = 0.5*tr;
+		double f = h*phi1(l*h);
+		double df = h*h*phi1Derivative(l*h);
+		for (unsigned int k=0; k<4; ++k) {
+			double I = (k == 0 || k == 3) ? 1 : 0;
+			P[k] = f*I + df*(M[k] - l*I);
+		}
+	}
+
+	E[0] = 1 + P[0]*M[0] + P[1]*M[2];
+	E[1] =     P[0]*M[1] + P[1]*M[3];
+	E[2] =     P[2]*M[0] + P[3]*M[2];
+	E[3] = 1 + P[2]*M[1] + P[3]*M[3];
+	b[0] = P[0]*g[0] + P[1]*g[1];
+	b[1] = P[2]*g[0] + P[3]*g[1];
+}
+
+
+/// Applies the local propagator y = E y + b to all elements.
+static void applyLocalPropagator(unsigned int nVars, const double E[4], const double b[2], std::vector<double> & y) {
+	if (nVars == 1) {
+		for (unsigned int i=0; i<y.size(); ++i)
+			y[i] = E[0]*y[i] + b[0];
+	}
+	else {
+		for (unsigned int i=0; i<y.size(); i+=2) {
+			double c = y[i];
+			double s = y[i+1];
+			y[i]   = E[0]*c + E[1]*s + b[0];
+			y[i+1] = E[2]*c + E[3]*s + b[1];
+		}
+	}
+}
+
+
+void Solver::runCharacteristic() {
+	double dx = m_input.L/m_n;
+	double Rc = m_input.Rc;
+	// mobile phase front moves with v/Rc, so that the front advances exactly one element per step
+	double dt = Rc*dx/m_input.v;
+
+	double M[4], g[2];
+	localSystem(M, g);
+
+	// Strang splitting: half step local update, exact shift, half step local update
+	double E[4], b[2];
+	localPropagator(m_nVars, M, g, 0.5*dt, E, b);
+
+	// calculate everything for first step so that we can write the inital output
+	storeOutput();
+
+	unsigned int nEquations = m_n*m_nVars;
+	double * y = N_VGetArrayPointer(m_yStorage);
+	std::vector<double> yOld(y, y + nEquations);
+	std::vector<double> yNew(yOld);
+
+	double dt_out = m_input.outputDt;
+	double t_out = dt_out;
+	unsigned int steps = 0;
+	double t = 0;
+	double tNew = 0;
+	int progress = 0; // for the progress indicator
+	while (m_t < m_tEnd) {
+		// advance until the step interval encloses the output time point
+		while (tNew < t_out) {
+			yOld.swap(yNew);
+			t = tNew;
+			yNew = yOld;
+
+			// local update, first half step
+			applyLocalPropagator(m_nVars, E, b, yNew);
+
+			// shift mobile phase by one element, inflow enters during the step
+			for (unsigned int i=m_n-1; i>0; --i)
+				yNew[i*m_nVars] = yNew[(i-1)*m_nVars];
+			yNew[0] = Rc*inletConcentration(t + 0.5*dt);
+
+			// local update, second half step
+			applyLocalPropagator(m_nVars, E, b, yNew);
+
+			++steps;
+			tNew = steps*dt;
+		}
+
+		// linear interpolation of the solution at the output time point
+		double alpha = (t_out - t)/dt;
+		for (unsigned int i=0; i<nEquations; ++i)
+			y[i] = yOld[i] + alpha*(yNew[i] - yOld[i]);
+		m_t = t_out;
+
+		int section = static_cast<int>(m_t/m_tEnd*10);
+		if (section > progress) {
+			std::cout << ".";
+			progress = section;
+		}
+		storeOutput();
+		t_out += dt_out;
+	}
+	m_outputCounter = 0; // force storage of profiles
+	storeOutput(true);
+}
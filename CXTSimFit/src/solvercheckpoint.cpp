@@ -0,0 +1,325 @@
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <cvode/cvode_serialization.h>
+#include <nvector/nvector_serial.h>
+#include <nvector/nvector_simd.h>
+#include <nvector/nvector_openmp.h>
+
+#include <IBK_Exception.h>
+#include <IBK_FormatString.h>
+
+#include "solver.h"
+
+/// Identifies a checkpoint file ("CXTC").
+static const uint32_t CHECKPOINT_MAGIC = 0x43585443;
+/// Version of the checkpoint file format.
+static const uint32_t CHECKPOINT_VERSION = 2;
+
+// The CVODE serialization (SerializeNVector() in sundials_serialization.c) accesses all vectors through
+// N_VectorContent_Serial, hence the SIMD and OpenMP vectors of Solver::newVector() must begin with the
+// same members.
+static_assert(offsetof(_N_VectorContent_Simd, length) == offsetof(_N_VectorContent_Serial, length) &&
+			  offsetof(_N_VectorContent_Simd, data) == offsetof(_N_VectorContent_Serial, data),
+			  "SIMD vector content differs from the serial vector content.");
+static_assert(offsetof(_N_VectorContent_OpenMP, length) == offsetof(_N_VectorContent_Serial, length) &&
+			  offsetof(_N_VectorContent_OpenMP, data) == offsetof(_N_VectorContent_Serial, data),
+			  "OpenMP vector content differs from the serial vector content.");
+
+/// Appends the bytes of val to buf.
+template <typename T>
+static void putValue(std::vector<char> & buf, const T & val) {
+	const char * p = reinterpret_cast<const char *>(&val);
+	buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+/// Appends the size and the values of vec to buf.
+static void putVector(std::vector<char> & buf, const std::vector<double> & vec) {
+	putValue(buf, static_cast<uint64_t>(vec.size()));
+	if (!vec.empty()) {
+		const char * p = reinterpret_cast<const char *>(&vec[0]);
+		buf.insert(buf.end(), p, p + vec.size()*sizeof(double));
+	}
+}
+
+/// Reads a value from the checkpoint data at pos and advances pos. Returns false if the data ends before.
+template <typename T>
+static bool getValue(const std::vector<char> & buf, size_t & pos, T & val) {
+	if (buf.size() - pos < sizeof(T))
+		return false;
+	std::memcpy(&val, &buf[pos], sizeof(T));
+	pos += sizeof(T);
+	return true;
+}
+
+/// Reads a vector written with putVector() from the checkpoint data at pos and advances pos.
+static bool getVector(const std::vector<char> & buf, size_t & pos, std::vector<double> & vec) {
+	uint64_t size;
+	if (!getValue(buf, pos, size) || (buf.size() - pos)/sizeof(double) < size)
+		return false;
+	vec.resize(static_cast<size_t>(size));
+	if (size > 0)
+		std::memcpy(&vec[0], &buf[pos], vec.size()*sizeof(double));
+	pos += vec.size()*sizeof(double);
+	return true;
+}
+
+/// Parameters that determine the solution up to the checkpoint (beside the grid and the model),
+/// a checkpoint can only be restored if they are unchanged. The tolerances are part of the CVODE data.
+/// The inlet schedule is appended with its time points and concentrations.
+static std::vector<double> stateParameters(const SolverInput & input) {
+	double params[] = { input.A, input.L, input.v, input.D, input.Rc, input.muc, input.gammac,
+						input.Rs, input.mus, input.gammas, input.beta, input.cInlet, input.cyclePeriod,
+						input.relTol, input.absTol };
+	std::vector<double> stateParams(params, params + sizeof(params)/sizeof(double));
+	if (!input.cInletData.empty()) {
+		stateParams.insert(stateParams.end(), input.cInletData.x().begin(), input.cInletData.x().end());
+		stateParams.insert(stateParams.end(), input.cInletData.y().begin(), input.cInletData.y().end());
+	}
+	return stateParams;
+}
+
+
+void Solver::setCheckpoints(const std::string & filename, double dt) {
+	FUNCID(Solver::setCheckpoints);
+	if (m_input.engine != SolverInput::ENGINE_CVODE || m_input.steadyState == SolverInput::SS_DIRECT)
+		throw IBK::Exception("Checkpoints are only supported by transient runs of the CVODE engine.", FUNC_ID);
+	if (dt < 0)
+		throw IBK::Exception("Invalid checkpoint interval.", FUNC_ID);
+	m_checkpointFile = filename;
+	m_checkpointDt = dt;
+}
+
+
+void Solver::writeCheckpoint(const std::string & filename) const {
+	FUNCID(Solver::writeCheckpoint);
+	if (m_input.engine != SolverInput::ENGINE_CVODE || m_cvodeMem == nullptr)
+		throw IBK::Exception("Checkpoints are only supported by the CVODE engine.", FUNC_ID);
+
+	std::vector<char> buf;
+	putValue(buf, CHECKPOINT_MAGIC);
+	putValue(buf, CHECKPOINT_VERSION);
+	putValue(buf, static_cast<uint32_t>(m_n));
+	putValue(buf, static_cast<uint32_t>(m_nVars));
+	putValue(buf, static_cast<uint32_t>(m_nActive));
+	putValue(buf, static_cast<uint32_t>(m_outputCounter));
+	putValue(buf, m_t);
+	putVector(buf, stateParameters(m_input));
+
+	// integrator configuration and counters of released CVODE instances (the counters of the current
+	// instance are part of the CVODE data)
+	putValue(buf, static_cast<uint8_t>(m_statistics.adams));
+	putValue(buf, static_cast<uint8_t>(m_statistics.newton));
+	putValue(buf, static_cast<uint8_t>(m_statistics.stabLimDet));
+	putValue(buf, static_cast<uint8_t>(m_statistics.probed));
+	putValue(buf, static_cast<int32_t>(m_statistics.maxOrder));
+	putValue(buf, m_statistics.initialStep);
+	putValue(buf, m_statistics.spectralRadius);
+	putValue(buf, m_statistics.probeCostAdams);
+	putValue(buf, m_statistics.probeCostBDF);
+	putValue(buf, static_cast<int64_t>(m_statistics.steps));
+	putValue(buf, static_cast<int64_t>(m_statistics.rhsEvals));
+	putValue(buf, static_cast<int64_t>(m_statistics.linSetups));
+	putValue(buf, static_cast<int64_t>(m_statistics.errTestFails));
+	putValue(buf, static_cast<int64_t>(m_statistics.nonlinIters));
+	putValue(buf, static_cast<int64_t>(m_statistics.nonlinConvFails));
+	putValue(buf, static_cast<int64_t>(m_statistics.stabLimOrderReds));
+
+	// outputs so far, so that the continued run yields the complete outlet series
+	putVector(buf, m_outletT);
+	putVector(buf, m_outletC);
+	putVector(buf, m_breakthroughT);
+
+	// solution at m_t (CVODE may have integrated beyond m_t already)
+	const double * y = N_VGetArrayPointer(m_yStorage);
+	putVector(buf, std::vector<double>(y, y + m_nActive*m_nVars));
+
+	// Jacobian and preconditioner of the Krylov solver, CVODE only decides when they are updated
+	putValue(buf, m_precGamma);
+	putVector(buf, m_precFactors);
+	putVector(buf, m_jacobianMask);
+
+	// CVODE memory (Nordsieck history, step size and order control, root finding, counters)
+	size_t cvodeSize = CVodeSerializationSize(m_cvodeMem);
+	putValue(buf, static_cast<uint64_t>(cvodeSize));
+	size_t pos = buf.size();
+	buf.resize(pos + cvodeSize);
+	void * data = &buf[pos];
+	CVodeSerialize(m_cvodeMem, &data);
+
+	// linear solver memory (band matrix and its factorization, Krylov solver counters)
+	size_t lsSize = 0;
+	if (m_statistics.newton)
+		lsSize = (m_input.linearSolver == SolverInput::LES_BAND) ? CVDlsSerializationSize(m_cvodeMem) : CVSpilsSerializationSize(m_cvodeMem);
+	putValue(buf, static_cast<uint64_t>(lsSize));
+	if (lsSize > 0) {
+		pos = buf.size();
+		buf.resize(pos + lsSize);
+		data = &buf[pos];
+		if (m_input.linearSolver == SolverInput::LES_BAND)
+			CVDlsSerialize(m_cvodeMem, &data);
+		else
+			CVSpilsSerialize(m_cvodeMem, &data);
+	}
+
+	// write to a temporary file first, so that a crash while writing keeps the previous checkpoint
+	std::string tmpName = filename + ".tmp";
+	std::ofstream out(tmpName.c_str(), std::ios::binary);
+	out.write(&buf[0], buf.size());
+	out.close();
+	if (!out)
+		throw IBK::Exception(IBK::FormatString("Cannot write checkpoint file '%1'.").arg(tmpName), FUNC_ID);
+	std::remove(filename.c_str());
+	if (std::rename(tmpName.c_str(), filename.c_str()) != 0)
+		throw IBK::Exception(IBK::FormatString("Cannot rename checkpoint file '%1' to '%2'.").arg(tmpName).arg(filename), FUNC_ID);
+}
+
+
+void Solver::restoreCheckpoint(const std::string & filename) {
+	FUNCID(Solver::restoreCheckpoint);
+	if (m_input.engine != SolverInput::ENGINE_CVODE || m_input.steadyState == SolverInput::SS_DIRECT)
+		throw IBK::Exception("Checkpoints are only supported by transient runs of the CVODE engine.", FUNC_ID);
+
+	std::ifstream in(filename.c_str(), std::ios::binary);
+	if (!in)
+		throw IBK::Exception(IBK::FormatString("Cannot open checkpoint file '%1'.").arg(filename), FUNC_ID);
+	std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	size_t pos = 0;
+	uint32_t magic = 0, version = 0, n, nVars, nActive, outputCounter;
+	double t;
+	std::vector<double> params;
+	if (!getValue(buf, pos, magic) || magic != CHECKPOINT_MAGIC ||
+		!getValue(buf, pos, version) || version != CHECKPOINT_VERSION)
+	{
+		throw IBK::Exception(IBK::FormatString("'%1' is not a checkpoint file of this version.").arg(filename), FUNC_ID);
+	}
+	IBK::FormatString truncated = IBK::FormatString("Checkpoint file '%1' is truncated.").arg(filename);
+	if (!getValue(buf, pos, n) || !getValue(buf, pos, nVars) || !getValue(buf, pos, nActive) ||
+		!getValue(buf, pos, outputCounter) || !getValue(buf, pos, t) || !getVector(buf, pos, params))
+	{
+		throw IBK::Exception(truncated, FUNC_ID);
+	}
+	if (n != m_n || nVars != m_nVars || nActive > m_n)
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' was written for another grid or model.").arg(filename), FUNC_ID);
+	if (params != stateParameters(m_input))
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' was written with other physical parameters, inlet concentrations or tolerances.").arg(filename), FUNC_ID);
+	if (t >= m_tEnd)
+		throw IBK::Exception(IBK::FormatString("Checkpoint time %1 h is not before the end time.").arg(t/3600), FUNC_ID);
+
+	SolverStatistics stats;
+	uint8_t flags[4];
+	int32_t maxOrder;
+	int64_t counters[7];
+	for (unsigned int i=0; i<4; ++i) {
+		if (!getValue(buf, pos, flags[i]))
+			throw IBK::Exception(truncated, FUNC_ID);
+	}
+	if (!getValue(buf, pos, maxOrder) || !getValue(buf, pos, stats.initialStep) ||
+		!getValue(buf, pos, stats.spectralRadius) || !getValue(buf, pos, stats.probeCostAdams) ||
+		!getValue(buf, pos, stats.probeCostBDF))
+	{
+		throw IBK::Exception(truncated, FUNC_ID);
+	}
+	for (unsigned int i=0; i<7; ++i) {
+		if (!getValue(buf, pos, counters[i]))
+			throw IBK::Exception(truncated, FUNC_ID);
+	}
+	stats.adams = (flags[0] != 0);
+	stats.newton = (flags[1] != 0);
+	stats.stabLimDet = (flags[2] != 0);
+	stats.probed = (flags[3] != 0);
+	stats.maxOrder = maxOrder;
+	stats.steps = static_cast<long int>(counters[0]);
+	stats.rhsEvals = static_cast<long int>(counters[1]);
+	stats.linSetups = static_cast<long int>(counters[2]);
+	stats.errTestFails = static_cast<long int>(counters[3]);
+	stats.nonlinIters = static_cast<long int>(counters[4]);
+	stats.nonlinConvFails = static_cast<long int>(counters[5]);
+	stats.stabLimOrderReds = static_cast<long int>(counters[6]);
+
+	std::vector<double> outletT, outletC, breakthroughT, y, precFactors, jacobianMask;
+	double precGamma;
+	if (!getVector(buf, pos, outletT) || !getVector(buf, pos, outletC) || !getVector(buf, pos, breakthroughT) ||
+		!getVector(buf, pos, y) || !getValue(buf, pos, precGamma) || !getVector(buf, pos, precFactors) ||
+		!getVector(buf, pos, jacobianMask))
+	{
+		throw IBK::Exception(truncated, FUNC_ID);
+	}
+	if (outletT.size() != outletC.size() || y.size() != nActive*m_nVars)
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' is corrupt.").arg(filename), FUNC_ID);
+	if (breakthroughT.size() != m_breakthroughT.size())
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' was written for other breakthrough fractions.").arg(filename), FUNC_ID);
+
+	// solution vector for the active window of the checkpoint
+	if (nActive != m_nActive) {
+		N_Vector yNew = newVector(nActive*m_nVars);
+		if (!yNew)
+			throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+		N_VDestroy(m_yStorage);
+		m_yStorage = yNew;
+		m_nActive = nActive;
+	}
+	std::copy(y.begin(), y.end(), N_VGetArrayPointer(m_yStorage));
+	m_t = t;
+	m_outputCounter = outputCounter;
+	m_outletT.swap(outletT);
+	m_outletC.swap(outletC);
+	m_breakthroughT.swap(breakthroughT);
+
+	// new CVODE instance with the configuration of the checkpoint, the counters of the instance
+	// created in init() are discarded
+	if (m_cvodeMem != nullptr) {
+		CVodeFree(&m_cvodeMem);
+		m_cvodeMem = nullptr;
+	}
+	m_statistics = stats;
+	initCVODE(m_t, m_statistics.initialStep);
+	// CVODE completes its setup (e.g. the data of the error weight function) only in the first step,
+	// which the deserialized data marks as done. Hence one step is taken and then overwritten.
+	double tStep;
+	if (CVode(m_cvodeMem, m_tEnd, m_yStorage, &tStep, CV_ONE_STEP) < 0)
+		throw IBK::Exception("Error while initializing the integrator from the checkpoint.", FUNC_ID);
+	std::copy(y.begin(), y.end(), N_VGetArrayPointer(m_yStorage));
+
+	// the sizes of the CVODE data depend on method, linear solver and number of root functions
+	uint64_t cvodeSize, lsSize = 0;
+	if (!getValue(buf, pos, cvodeSize) || buf.size() - pos < cvodeSize)
+		throw IBK::Exception(truncated, FUNC_ID);
+	if (cvodeSize != CVodeSerializationSize(m_cvodeMem))
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' does not match the integrator configuration.").arg(filename), FUNC_ID);
+	void * data = &buf[pos];
+	if (CVodeDeserialize(m_cvodeMem, &data) != cvodeSize)
+		throw IBK::Exception(IBK::FormatString("Invalid CVODE data in checkpoint file '%1'.").arg(filename), FUNC_ID);
+	pos += static_cast<size_t>(cvodeSize);
+
+	if (!getValue(buf, pos, lsSize) || buf.size() - pos < lsSize)
+		throw IBK::Exception(truncated, FUNC_ID);
+	size_t lsSizeExpected = 0;
+	if (m_statistics.newton)
+		lsSizeExpected = (m_input.linearSolver == SolverInput::LES_BAND) ? CVDlsSerializationSize(m_cvodeMem) : CVSpilsSerializationSize(m_cvodeMem);
+	if (lsSize != lsSizeExpected)
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' does not match the linear solver.").arg(filename), FUNC_ID);
+	if (lsSize > 0) {
+		data = &buf[pos];
+		if (m_input.linearSolver == SolverInput::LES_BAND)
+			CVDlsDeserialize(m_cvodeMem, &data);
+		else
+			CVSpilsDeserialize(m_cvodeMem, &data);
+	}
+	m_precGamma = precGamma;
+	m_precFactors.swap(precFactors);
+	m_jacobianMask.swap(jacobianMask);
+
+	// settings that may differ from the checkpointed run (end time, step limits)
+	if (CVodeSetStopTime(m_cvodeMem, m_tEnd) != CV_SUCCESS)
+		throw IBK::Exception("The checkpointed integrator state lies beyond the end time.", FUNC_ID);
+	CVodeSetMaxStep(m_cvodeMem, m_input.maxDt);
+	CVodeSetMinStep(m_cvodeMem, m_input.minDt);
+}
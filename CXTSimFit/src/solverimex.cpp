@@ -0,0 +1,157 @@
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include <IBK_Exception.h>
+
+#include "solver.h"
+
+/// Solves (I - h*M) y = k for all elements in-place (block-diagonal system with
+/// 1x1 or 2x2 blocks), where k already contains the contribution of the constant
+/// source vector g.
+static void solveLocalBlocks(unsigned int nVars, const double M[4], double h, unsigned int n, double * y) {
+	if (nVars == 1) {
+		double inv = 1/(1 - h*M[0]);
+		for (unsigned int i=0; i<n; ++i)
+			y[i] *= inv;
+		return;
+	}
+	// inverse of the 2x2 block
+	double a = 1 - h*M[0];
+	double b = -h*M[1];
+	double c = -h*M[2];
+	double d = 1 - h*M[3];
+	double det = a*d - b*c;
+	double ia =  d/det;
+	double ib = -b/det;
+	double ic = -c/det;
+	double id =  a/det;
+	for (unsigned int i=0; i<n; ++i) {
+		double k1 = y[2*i];
+		double k2 = y[2*i+1];
+		y[2*i]   = ia*k1 + ib*k2;
+		y[2*i+1] = ic*k1 + id*k2;
+	}
+}
+
+
+/// Evaluates the local terms I(y) = M y + g for all elements.
+static void localTerms(unsigned int nVars, const double M[4], const double g[2], unsigned int n,
+					   const double * y, double * res)
+{
+	if (nVars == 1) {
+		for (unsigned int i=0; i<n; ++i)
+			res[i] = M[0]*y[i] + g[0];
+		return;
+	}
+	for (unsigned int i=0; i<n; ++i) {
+		res[2*i]   = M[0]*y[2*i] + M[1]*y[2*i+1] + g[0];
+		res[2*i+1] = M[2]*y[2*i] + M[3]*y[2*i+1] + g[1];
+	}
+}
+
+
+void Solver::runIMEX() {
+	FUNCID(Solver::runIMEX);
+
+	double dx = m_input.L/m_n;
+	double Rc = m_input.Rc;
+	// stability limit of the explicit transport part (upwind convection and central diffusion),
+	// the explicit part of the scheme has the stability polynomial of Heun's method
+	double rate = m_input.v/(Rc*dx) + 2*m_input.D/(Rc*dx*dx);
+	double dtMax = m_input.maxDt;
+	if (rate > 0)
+		dtMax = std::min(dtMax, 0.9/rate);
+	if (dtMax < m_input.minDt)
+		throw IBK::Exception("Stable time step of the explicit transport part is below the minimum time step.", FUNC_ID);
+
+	double M[4], g[2];
+	localSystem(M, g);
+
+	// ARS(2,2,2) IMEX Runge-Kutta scheme (Ascher, Ruuth, Spiteri, 1997), stiffly accurate
+	// and L-stable in the implicit part
+	const double gamma = 1 - 1/std::sqrt(2.0);
+	const double delta = 1 - 1/(2*gamma);
+
+	unsigned int nEquations = m_n*m_nVars;
+	N_Vector Y2 = N_VNew_Serial(nEquations);
+	N_Vector E1 = N_VNew_Serial(nEquations);
+	N_Vector E2 = N_VNew_Serial(nEquations);
+	N_Vector I2 = N_VNew_Serial(nEquations);
+	// releases the stage vectors, also when an exception leaves the integration
+	auto destroyStageVectors = [&]() {
+		N_Vector * vecs[] = { &Y2, &E1, &E2, &I2 };
+		for (unsigned int i=0; i<4; ++i) {
+			if (*vecs[i] != nullptr)
+				N_VDestroy_Serial(*vecs[i]);
+		}
+	};
+	if (!Y2 || !E1 || !E2 || !I2) {
+		destroyStageVectors();
+		throw IBK::Exception("Stage vector allocation error!", FUNC_ID);
+	}
+	double * y = N_VGetArrayPointer(m_yStorage);
+	double * y2 = NV_DATA_S(Y2);
+	double * e1 = NV_DATA_S(E1);
+	double * e2 = NV_DATA_S(E2);
+	double * i2 = NV_DATA_S(I2);
+
+	try {
+		// calculate everything for first step so that we can write the inital output
+		storeOutput();
+
+		double dt_out = m_input.outputDt;
+		double t_out = dt_out;
+		int progress = 0; // for the progress indicator
+		while (m_t < m_tEnd) {
+			while (m_t < t_out) {
+				// last step lands exactly on the output time point
+				double h = std::min(dtMax, t_out - m_t);
+				if (t_out - m_t - h < 1e-10*dt_out)
+					h = t_out - m_t;
+
+				// explicit part E(y) = f(y) - I(y), all physics is evaluated in calculateDivergences()
+				calculateDivergences(m_t, m_yStorage, E1);
+				localTerms(m_nVars, M, g, m_n, y, i2);
+				for (unsigned int i=0; i<nEquations; ++i)
+					e1[i] -= i2[i];
+
+				// stage 2
+				for (unsigned int i=0; i<nEquations; ++i)
+					y2[i] = y[i] + h*gamma*e1[i];
+				for (unsigned int i=0; i<nEquations; ++i)
+					y2[i] += h*gamma*g[i % m_nVars];
+				solveLocalBlocks(m_nVars, M, h*gamma, m_n, y2);
+
+				// stage 3
+				calculateDivergences(m_t + gamma*h, Y2, E2);
+				localTerms(m_nVars, M, g, m_n, y2, i2);
+				for (unsigned int i=0; i<nEquations; ++i)
+					e2[i] -= i2[i];
+				for (unsigned int i=0; i<nEquations; ++i) {
+					y[i] += h*(delta*e1[i] + (1 - delta)*e2[i] + (1 - gamma)*i2[i] + gamma*g[i % m_nVars]);
+				}
+				solveLocalBlocks(m_nVars, M, h*gamma, m_n, y);
+
+				m_t += h;
+			}
+			m_t = t_out;
+
+			int section = static_cast<int>(m_t/m_tEnd*10);
+			if (section > progress) {
+				std::cout << ".";
+				progress = section;
+			}
+			storeOutput();
+			t_out += dt_out;
+		}
+		m_outputCounter = 0; // force storage of profiles
+		storeOutput(true);
+	}
+	catch (...) {
+		destroyStageVectors();
+		throw;
+	}
+
+	destroyStageVectors();
+}
@@ -1,5 +1,13 @@
 #include "solverinput.h"
 
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <IBK_Exception.h>
+#include <IBK_FormatString.h>
+#include <IBK_StringUtils.h>
+
 SolverInput::SolverInput() :
 	n(3)
 {
@@ -10,4 +18,216 @@ SolverInput::SolverInput() :
 	outputDt = 600;
 	outputN = 6;
 	digits = 1e-15;
+	engine = ENGINE_CVODE;
+	linearSolver = LES_BAND;
+	integrator = INTEGRATOR_BDF;
+	macroDt = 600;
+	pararealSlices = 1;
+	steadyState = SS_NONE;
+	cyclePeriod = 0;
+	stopAtBreakthrough = false;
+	reducedOrderFit = false;
+	activeWindow = false;
+	activeWindowMargin = 20;
+	threads = 1;
+	mappedProfiles = false;
+	profileCompression = PC_NONE;
+	profileTolerance = 0;
+	profileChange = 0;
+	profileChangeNorm = PCN_MAX;
+	maxProfiles = 0;
+}
+
+
+/// Converts value into string, full precision for floating point values.
+template <typename T>
+static std::string inputValue(const T & val) {
+	std::stringstream strm;
+	strm << std::setprecision(17) << val;
+	return strm.str();
+}
+
+
+/// Converts a vector into a space-separated list.
+static std::string inputValue(const std::vector<double> & vals) {
+	std::stringstream strm;
+	strm << std::setprecision(17);
+	for (unsigned int i=0; i<vals.size(); ++i)
+		strm << (i > 0 ? " " : "") << vals[i];
+	return strm.str();
+}
+
+
+void SolverInput::read(const std::string & filename) {
+	FUNCID(SolverInput::read);
+	std::ifstream in(filename.c_str());
+	if (!in)
+		throw IBK::Exception(IBK::FormatString("Cannot open input file '%1'.").arg(filename), FUNC_ID);
+	read(in, filename);
+}
+
+
+/// Converts an enumeration index into the enumeration value, throws an IBK::Exception if the index
+/// exceeds last (the last enumeration value).
+template <typename T>
+static T enumValue(const std::string & value, T last) {
+	FUNCID(enumValue);
+	unsigned int index = IBK::string2val<unsigned int>(value);
+	if (index > static_cast<unsigned int>(last))
+		throw IBK::Exception(IBK::FormatString("Enumeration index %1 out of range (0..%2).")
+							 .arg(index).arg(static_cast<unsigned int>(last)), FUNC_ID);
+	return static_cast<T>(index);
+}
+
+
+void SolverInput::read(std::istream & in, const std::string & filename) {
+	FUNCID(SolverInput::read);
+	std::vector<double> inletT, inletC;
+	std::string line;
+	unsigned int lineNr = 0;
+	while (std::getline(in, line)) {
+		++lineNr;
+		std::string::size_type pos = line.find('#');
+		if (pos != std::string::npos)
+			line.erase(pos);
+		IBK::trim(line);
+		if (line.empty())
+			continue;
+		pos = line.find('=');
+		if (pos == std::string::npos)
+			throw IBK::Exception(IBK::FormatString("Missing '=' in line %1 of input file '%2'.").arg(lineNr).arg(filename), FUNC_ID);
+		std::string keyword = IBK::trim_copy(line.substr(0, pos));
+		std::string value = IBK::trim_copy(line.substr(pos + 1));
+		try {
+			if (keyword == "n")							n = IBK::string2val<unsigned int>(value);
+			else if (keyword == "tEnd")					tEnd = IBK::string2val<double>(value);
+			else if (keyword == "relTol")				relTol = IBK::string2val<double>(value);
+			else if (keyword == "absTol")				absTol = IBK::string2val<double>(value);
+			else if (keyword == "minDt")				minDt = IBK::string2val<double>(value);
+			else if (keyword == "maxDt")				maxDt = IBK::string2val<double>(value);
+			else if (keyword == "outputDt")				outputDt = IBK::string2val<double>(value);
+			else if (keyword == "outputN")				outputN = IBK::string2val<unsigned int>(value);
+			else if (keyword == "digits")				digits = IBK::string2val<double>(value);
+			else if (keyword == "engine")				engine = enumValue(value, ENGINE_MULTIRATE);
+			else if (keyword == "linearSolver")			linearSolver = enumValue(value, LES_GMRES);
+			else if (keyword == "integrator")			integrator = enumValue(value, INTEGRATOR_AUTO);
+			else if (keyword == "macroDt")				macroDt = IBK::string2val<double>(value);
+			else if (keyword == "pararealSlices")		pararealSlices = IBK::string2val<unsigned int>(value);
+			else if (keyword == "steadyState")			steadyState = enumValue(value, SS_CYCLIC_DIRECT);
+			else if (keyword == "cyclePeriod")			cyclePeriod = IBK::string2val<double>(value);
+			else if (keyword == "breakthroughFractions")	IBK::string2valueVector(value, breakthroughFractions);
+			else if (keyword == "stopAtBreakthrough")	stopAtBreakthrough = IBK::string2val<bool>(value);
+			else if (keyword == "probePositions")		IBK::string2valueVector(value, probePositions);
+			else if (keyword == "probeWeights")			IBK::string2valueVector(value, probeWeights);
+			else if (keyword == "reducedOrderFit")		reducedOrderFit = IBK::string2val<bool>(value);
+			else if (keyword == "activeWindow")			activeWindow = IBK::string2val<bool>(value);
+			else if (keyword == "activeWindowMargin")	activeWindowMargin = IBK::string2val<unsigned int>(value);
+			else if (keyword == "threads")				threads = IBK::string2val<unsigned int>(value);
+			else if (keyword == "mappedProfiles")		mappedProfiles = IBK::string2val<bool>(value);
+			else if (keyword == "profileCompression")	profileCompression = enumValue(value, PC_QUANTIZED);
+			else if (keyword == "profileTolerance")		profileTolerance = IBK::string2val<double>(value);
+			else if (keyword == "profileChange")		profileChange = IBK::string2val<double>(value);
+			else if (keyword == "profileChangeNorm")	profileChangeNorm = enumValue(value, PCN_RMS);
+			else if (keyword == "maxProfiles")			maxProfiles = IBK::string2val<unsigned int>(value);
+			else if (keyword == "A")					A = IBK::string2val<double>(value);
+			else if (keyword == "L")					L = IBK::string2val<double>(value);
+			else if (keyword == "q")					q = IBK::string2val<double>(value);
+			else if (keyword == "p")					p = IBK::string2val<double>(value);
+			else if (keyword == "v")					v = IBK::string2val<double>(value);
+			else if (keyword == "model")				model = enumValue(value, PLUS_EXCHANGE);
+			else if (keyword == "D")					D = IBK::string2val<double>(value);
+			else if (keyword == "Rc")					Rc = IBK::string2val<double>(value);
+			else if (keyword == "muc")					muc = IBK::string2val<double>(value);
+			else if (keyword == "gammac")				gammac = IBK::string2val<double>(value);
+			else if (keyword == "Rs")					Rs = IBK::string2val<double>(value);
+			else if (keyword == "mus")					mus = IBK::string2val<double>(value);
+			else if (keyword == "gammas")				gammas = IBK::string2val<double>(value);
+			else if (keyword == "beta")					beta = IBK::string2val<double>(value);
+			else if (keyword == "cInlet")				cInlet = IBK::string2val<double>(value);
+			else if (keyword == "cInletData.t")			IBK::string2valueVector(value, inletT);
+			else if (keyword == "cInletData.c")			IBK::string2valueVector(value, inletC);
+			else
+				throw IBK::Exception(IBK::FormatString("Unknown keyword '%1'.").arg(keyword), FUNC_ID);
+		}
+		catch (IBK::Exception & ex) {
+			throw IBK::Exception(ex, IBK::FormatString("Error in line %1 of input file '%2'.").arg(lineNr).arg(filename), FUNC_ID);
+		}
+	}
+
+	if (inletT.size() != inletC.size())
+		throw IBK::Exception(IBK::FormatString("Inlet data in input file '%1' has different numbers of time points and concentrations.").arg(filename), FUNC_ID);
+	if (!inletT.empty()) {
+		try {
+			cInletData.setValues(inletT, inletC);
+		}
+		catch (IBK::Exception & ex) {
+			throw IBK::Exception(ex, IBK::FormatString("Invalid inlet data in input file '%1'.").arg(filename), FUNC_ID);
+		}
+	}
+}
+
+
+void SolverInput::write(const std::string & filename) const {
+	FUNCID(SolverInput::write);
+	std::ofstream out(filename.c_str());
+	if (!out)
+		throw IBK::Exception(IBK::FormatString("Cannot write input file '%1'.").arg(filename), FUNC_ID);
+	write(out);
+	if (!out)
+		throw IBK::Exception(IBK::FormatString("Error writing input file '%1'.").arg(filename), FUNC_ID);
+}
+
+
+void SolverInput::write(std::ostream & out) const {
+	out << "# CXTSimFit solver input (SI units, enumerations as index)\n";
+	out << "n = " << n << "\n";
+	out << "tEnd = " << inputValue(tEnd) << "\n";
+	out << "relTol = " << inputValue(relTol) << "\n";
+	out << "absTol = " << inputValue(absTol) << "\n";
+	out << "minDt = " << inputValue(minDt) << "\n";
+	out << "maxDt = " << inputValue(maxDt) << "\n";
+	out << "outputDt = " << inputValue(outputDt) << "\n";
+	out << "outputN = " << outputN << "\n";
+	out << "digits = " << inputValue(digits) << "\n";
+	out << "engine = " << engine << "\n";
+	out << "linearSolver = " << linearSolver << "\n";
+	out << "integrator = " << integrator << "\n";
+	out << "macroDt = " << inputValue(macroDt) << "\n";
+	out << "pararealSlices = " << pararealSlices << "\n";
+	out << "steadyState = " << steadyState << "\n";
+	out << "cyclePeriod = " << inputValue(cyclePeriod) << "\n";
+	out << "breakthroughFractions = " << inputValue(breakthroughFractions) << "\n";
+	out << "stopAtBreakthrough = " << (stopAtBreakthrough ? "true" : "false") << "\n";
+	out << "probePositions = " << inputValue(probePositions) << "\n";
+	out << "probeWeights = " << inputValue(probeWeights) << "\n";
+	out << "reducedOrderFit = " << (reducedOrderFit ? "true" : "false") << "\n";
+	out << "activeWindow = " << (activeWindow ? "true" : "false") << "\n";
+	out << "activeWindowMargin = " << activeWindowMargin << "\n";
+	out << "threads = " << threads << "\n";
+	out << "mappedProfiles = " << (mappedProfiles ? "true" : "false") << "\n";
+	out << "profileCompression = " << profileCompression << "\n";
+	out << "profileTolerance = " << inputValue(profileTolerance) << "\n";
+	out << "profileChange = " << inputValue(profileChange) << "\n";
+	out << "profileChangeNorm = " << profileChangeNorm << "\n";
+	out << "maxProfiles = " << maxProfiles << "\n";
+	out << "A = " << inputValue(A) << "\n";
+	out << "L = " << inputValue(L) << "\n";
+	out << "q = " << inputValue(q) << "\n";
+	out << "p = " << inputValue(p) << "\n";
+	out << "v = " << inputValue(v) << "\n";
+	out << "model = " << model << "\n";
+	out << "D = " << inputValue(D) << "\n";
+	out << "Rc = " << inputValue(Rc) << "\n";
+	out << "muc = " << inputValue(muc) << "\n";
+	out << "gammac = " << inputValue(gammac) << "\n";
+	out << "Rs = " << inputValue(Rs) << "\n";
+	out << "mus = " << inputValue(mus) << "\n";
+	out << "gammas = " << inputValue(gammas) << "\n";
+	out << "beta = " << inputValue(beta) << "\n";
+	out << "cInlet = " << inputValue(cInlet) << "\n";
+	if (!cInletData.empty()) {
+		out << "# inlet concentration time points in h and values in kg/m3\n";
+		out << "cInletData.t = " << inputValue(cInletData.x()) << "\n";
+		out << "cInletData.c = " << inputValue(cInletData.y()) << "\n";
+	}
 }
@@ -1,6 +1,10 @@
 #ifndef solverinput_h
 #define solverinput_h
 
+#include <string>
+#include <vector>
+#include <iosfwd>
+
 #include <IBK_LinearSpline.h>
 
 /// This class encapsulates all data needed by the solver.
@@ -31,9 +35,124 @@ public:
 		PLUS_EXCHANGE
 	};
 
+	/// The different time integration engines.
+	///
+	/// ENGINE_CVODE integrates the method-of-lines system with the CVODE BDF integrator
+	/// (error-controlled, works for all parameter combinations).
+	///
+	/// ENGINE_CHARACTERISTIC requires a zero diffusion coefficient. The mobile phase is shifted
+	/// exactly along the characteristics (one element per time step, Courant number 1). Sorption,
+	/// reaction and exchange are integrated with exact exponential updates per element.
+	///
+	/// ENGINE_IMEX uses an implicit-explicit Runge-Kutta method of second order. Convection and
+	/// diffusion are integrated explicitly (time step limited by stability), the local terms
+	/// (sorption, reaction and exchange) are integrated implicitly with per-element block solves.
+	/// Suitable for PLUS_EXCHANGE runs where stiffness stems from a large exchange coefficient.
+	///
+	/// ENGINE_MULTIRATE is only available for PLUS_EXCHANGE. The mobile phase is integrated with
+	/// CVODE (micro steps), the slow immobile phase is updated once per macro step (macroDt)
+	/// using the time integral of the mobile phase mass densities.
+	enum engine_t {
+		ENGINE_CVODE,
+		ENGINE_CHARACTERISTIC,
+		ENGINE_IMEX,
+		ENGINE_MULTIRATE
+	};
+
+	/// The linear equation system solvers used within the CVODE Newton iteration.
+	///
+	/// LES_BAND uses a direct band LU factorization (memory grows with n times bandwidth).
+	///
+	/// LES_GMRES uses the matrix-free Krylov solver GMRES with analytical Jacobian-vector products and
+	/// a block-tridiagonal preconditioner that is solved in O(n). Intended for very large grids.
+	enum linearSolver_t {
+		LES_BAND,
+		LES_GMRES
+	};
+
+	/// Use of the steady-state solver (KINSOL, Newton method with analytical band Jacobian).
+	///
+	/// SS_NONE only runs the transient simulation.
+	///
+	/// SS_DIRECT skips the transient simulation. The steady state for the inlet concentration at the
+	/// end time is computed directly and stored as the only output (at the end time).
+	///
+	/// SS_TERMINATION computes the steady state for the inlet concentration at the end time first.
+	/// The transient simulation (CVODE engine only) stops once the solution has reached the steady state
+	/// within the integrator tolerances, provided that the inlet concentration remains constant.
+	/// The remaining outputs are filled with the steady state.
+	///
+	/// SS_INITIAL uses the steady state for the inlet concentration at t = 0 as initial state of the
+	/// transient simulation (e.g. for a desorption phase following a constant feed).
+	///
+	/// SS_CYCLIC and SS_CYCLIC_DIRECT compute the cyclic steady state of periodic operation (see cyclePeriod)
+	/// with the CyclicSteadyState driver, using the shooting method or direct cycling, respectively.
+	/// The results cover one period, starting with the cyclic steady state.
+	enum steadyState_t {
+		SS_NONE,
+		SS_DIRECT,
+		SS_TERMINATION,
+		SS_INITIAL,
+		SS_CYCLIC,
+		SS_CYCLIC_DIRECT
+	};
+
+	/// Configuration of the CVODE integrator (ENGINE_CVODE).
+	enum integrator_t {
+		/// BDF method with Newton iteration (stiff problems).
+		INTEGRATOR_BDF,
+		/// Adams-Moulton method with functional iteration (non-stiff problems).
+		INTEGRATOR_ADAMS,
+		/// Initial step and stability limit detection are derived from the Jacobian and the initial state;
+		/// if the maximum step is within the stability limit of the Adams method, short trial
+		/// integrations with both methods decide which one is used.
+		INTEGRATOR_AUTO
+	};
+
+	/// Encoding of the stored profiles (see ProfileStore).
+	///
+	/// PC_NONE stores raw doubles.
+	///
+	/// PC_LOSSLESS predicts each value from the previous snapshot and stores the XOR of the bit patterns
+	/// with zero-run encoding, the profiles are restored exactly.
+	///
+	/// PC_FLOAT32 works like PC_LOSSLESS with values rounded to float (relative error below 6e-8).
+	///
+	/// PC_QUANTIZED rounds values to multiples of twice profileTolerance (absolute error at most
+	/// profileTolerance) and stores the differences to the previous snapshot.
+	enum profileCompression_t {
+		PC_NONE,
+		PC_LOSSLESS,
+		PC_FLOAT32,
+		PC_QUANTIZED
+	};
+
+	/// Norm of the profile change used for adaptive profile recording (see profileChange).
+	enum profileChangeNorm_t {
+		/// Maximum absolute difference of all element concentrations.
+		PCN_MAX,
+		/// Root mean square of the differences of all element concentrations.
+		PCN_RMS
+	};
+
 	/// Constructor, initializes all variables with some meaningful defaults.
 	SolverInput();
 
+	/// Reads input data from a text file with lines 'keyword = value' (keywords are the member names,
+	/// enumeration values are given as index, lists are separated by spaces, '#' starts a comment).
+	/// Missing keywords keep their current values. Throws an IBK::Exception if the file cannot be read,
+	/// contains unknown keywords or invalid values.
+	void read(const std::string & filename);
+	/// Reads input data in the format of read(const std::string &) from a stream, filename is only
+	/// used in error messages.
+	void read(std::istream & in, const std::string & filename);
+
+	/// Writes all input data to a text file in the format expected by read().
+	/// Throws an IBK::Exception if the file cannot be written.
+	void write(const std::string & filename) const;
+	/// Writes all input data to a stream in the format expected by read().
+	void write(std::ostream & out) const;
+
 	// Numerical input parameters
 	unsigned int		n;			///< Number of elements for spatial discretization
 	double				tEnd;		///< Simulation end time point in s
@@ -44,6 +163,43 @@ public:
 	double				outputDt;	///< Output time steps for break-through in s
 	unsigned int		outputN;	///< Every nth break-through output a field output is written.
 	double				digits;		///< Accuracy required for the LevMar algorithm.
+	engine_t			engine;		///< Time integration engine.
+	linearSolver_t		linearSolver;	///< Linear equation system solver used with ENGINE_CVODE.
+	integrator_t		integrator;		///< Integration method used with ENGINE_CVODE.
+	/// Macro time step for the immobile phase in [s], used with ENGINE_MULTIRATE. The error of the
+	/// macro steps is not controlled, with the default of 600 s the outlet error is about 0.1 % of the plateau.
+	double				macroDt;
+	unsigned int		pararealSlices;	///< Number of time slices for the parallel-in-time driver (see Parareal), 1 disables it.
+	steadyState_t		steadyState;	///< Use of the steady-state solver.
+	double				cyclePeriod;	///< Period of the inlet schedule in s (cInletData is repeated), 0 for non-periodic operation.
+	/// Ratios of outlet to feed concentration (e.g. 0.05, 0.5, 0.95) whose first crossing times are located
+	/// during integration (root finding of CVODE, other engines interpolate the outlet data).
+	std::vector<double>	breakthroughFractions;
+	bool				stopAtBreakthrough;	///< If true, the run ends once all breakthrough fractions have been reached.
+	/// Positions of virtual concentration sensors along the bed in m (0 = inlet, L = outlet), whose
+	/// mobile phase concentrations are recorded at each output time point (see ProbeSampler).
+	std::vector<double>	probePositions;
+	/// Weights of the residuals of measured probe series in fits relative to the outlet series (one per probe
+	/// position, missing weights are 1).
+	std::vector<double>	probeWeights;
+	bool				reducedOrderFit;	///< If true, fits use the POD reduced-order model (see PODModel) for most evaluations.
+	bool				activeWindow;		///< If true, only the region behind the concentration front is integrated.
+	unsigned int		activeWindowMargin;	///< Number of elements kept active ahead of the concentration front.
+	/// Number of OpenMP threads for the right-hand side and the vector operations of ENGINE_CVODE without
+	/// steady-state solver (1 = serial). Only effective when compiled with OpenMP support (OPTIONS += openmp).
+	unsigned int		threads;
+	/// If true, the profiles of a run are stored in a memory-mapped temporary file instead of main memory
+	/// (see ProfileStore), for long runs on fine grids.
+	bool				mappedProfiles;
+	profileCompression_t	profileCompression;	///< Encoding of the stored profiles.
+	double				profileTolerance;	///< Maximum absolute error in kg/m3 with PC_QUANTIZED, 0 means absTol.
+	/// If positive, profiles are stored at any output where they differ from the last stored profiles by
+	/// more than this value in kg/m3 (see profileChangeNorm and ProfileRecorder), outputN is not used then.
+	double				profileChange;
+	profileChangeNorm_t	profileChangeNorm;	///< Norm of the profile change.
+	/// Maximum number of stored profiles, 0 means unlimited. Once reached, the stored profiles are thinned
+	/// (see ProfileRecorder), the last output is always kept.
+	unsigned int		maxProfiles;
 
 	// Physical parameters
 	double				A;		///< Cross section in m2
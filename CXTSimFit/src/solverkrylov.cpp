@@ -0,0 +1,206 @@
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include <cvode/cvode_spgmr.h>
+
+#include "solver.h"
+
+// Wrapper functions called from the CVSpgmr linear solver module, relaying the calls
+// to the solver member functions.
+
+int jtimes_solver(N_Vector v, N_Vector Jv, realtype /*t*/, N_Vector /*y*/, N_Vector /*fy*/,
+				  void *user_data, N_Vector /*tmp*/)
+{
+	static_cast<Solver*>(user_data)->jacobianTimesVector(N_VGetArrayPointer(v), N_VGetArrayPointer(Jv));
+	return 0;
+}
+
+int psetup_solver(realtype /*t*/, N_Vector y, N_Vector fy, booleantype /*jok*/, booleantype *jcurPtr,
+				  realtype gamma, void *user_data, N_Vector /*tmp1*/, N_Vector /*tmp2*/, N_Vector /*tmp3*/)
+{
+	// the Jacobian is evaluated analytically and cheap, so we always update it
+	Solver * solver = static_cast<Solver*>(user_data);
+	solver->updateJacobian(N_VGetArrayPointer(y), N_VGetArrayPointer(fy), gamma);
+	solver->setupPreconditioner(gamma);
+	*jcurPtr = TRUE;
+	return 0;
+}
+
+int psolve_solver(realtype /*t*/, N_Vector /*y*/, N_Vector /*fy*/, N_Vector r, N_Vector z,
+				  realtype gamma, realtype /*delta*/, int /*lr*/, void *user_data, N_Vector /*tmp*/)
+{
+	Solver * solver = static_cast<Solver*>(user_data);
+	// CVODE may call the solve function with a gamma differing from the one passed to the setup function,
+	// since the factorization is cheap, we update it to get the exact preconditioner
+	solver->setupPreconditioner(gamma);
+	solver->solvePreconditioner(N_VGetArrayPointer(r), N_VGetArrayPointer(z));
+	return 0;
+}
+
+
+void Solver::jacobianCoefficients(unsigned int i, double & lower, double & diag, double & upper) const {
+	double A = m_input.A;
+	double dx = m_input.L/m_n;
+	double V_rev = A*dx;
+	double Rc = m_input.Rc;
+	double diff = m_input.D*A/dx;
+	double conv = m_input.v*A;
+
+	// derivatives of the convection/diffusion fluxes with respect to the mobile phase mass densities,
+	// see calculateDivergences() for the flux definitions
+	lower = (i > 0) ? (diff + conv)/(V_rev*Rc) : 0;
+	upper = (i+1 < m_nActive) ? diff/(V_rev*Rc) : 0;
+	// no diffusion at the filter outlet, but into the empty region ahead of the active window
+	double diffDownstream = (i+1 < m_n) ? diff : 0;
+	diag = -(diff + diffDownstream + conv)/(V_rev*Rc);
+}
+
+
+void Solver::updateJacobian(const double * y, const double * fy, double gamma) {
+	// Like the band Jacobian, the Jacobian is kept fixed during the Newton iterations of a step.
+	// Only the clipping of negative mass densities depends on the state. We store the derivative
+	// of the clipped value max(0,y) as seen by the difference quotient of the band Jacobian
+	// (same increments as in CVODE's cvDlsBandDQJac), so that both linear solvers see the same Jacobian.
+	unsigned int nEquations = m_nActive*m_nVars;
+	double fnorm = 0;
+	for (unsigned int i=0; i<nEquations; ++i) {
+		double w = fy[i]/(m_relTol*std::fabs(y[i]) + m_input.absTol);
+		fnorm += w*w;
+	}
+	fnorm = std::sqrt(fnorm/nEquations);
+	double srur = std::sqrt(DBL_EPSILON);
+	// gamma takes the place of the step size in the minimum increment
+	double minInc = (fnorm != 0) ? 1000*std::fabs(gamma)*DBL_EPSILON*nEquations*fnorm : 1;
+
+	m_jacobianMask.assign(m_n*m_nVars, 1);
+	for (unsigned int i=0; i<nEquations; ++i) {
+		if (y[i] >= 0)
+			continue;
+		double inc = std::max(srur*std::fabs(y[i]), minInc*(m_relTol*std::fabs(y[i]) + m_input.absTol));
+		m_jacobianMask[i] = std::max(0.0, y[i] + inc)/inc;
+	}
+	// force update of the preconditioner
+	m_precGamma = 0;
+}
+
+
+void Solver::jacobianTimesVector(const double * v, double * Jv) const {
+	double M[4], g[2];
+	localSystem(M, g);
+	for (unsigned int i=0; i<m_nActive; ++i) {
+		double lower, diag, upper;
+		jacobianCoefficients(i, lower, diag, upper);
+		unsigned int ic = i*m_nVars;
+		double res = (diag + M[0])*m_jacobianMask[ic]*v[ic];
+		if (i > 0)
+			res += lower*m_jacobianMask[ic - m_nVars]*v[ic - m_nVars];
+		if (i+1 < m_nActive)
+			res += upper*m_jacobianMask[ic + m_nVars]*v[ic + m_nVars];
+		if (m_nVars == 2) {
+			double vc = m_jacobianMask[ic]*v[ic];
+			double vs = m_jacobianMask[ic+1]*v[ic+1];
+			res += M[1]*vs;
+			Jv[ic+1] = M[2]*vc + M[3]*vs;
+		}
+		Jv[ic] = res;
+	}
+}
+
+
+void Solver::setupPreconditioner(double gamma) {
+	if (gamma == m_precGamma && m_precFactors.size() == 6*m_nActive)
+		return;
+	m_precGamma = gamma;
+	m_precFactors.resize(6*m_nActive);
+
+	double M[4], g[2];
+	localSystem(M, g);
+
+	// Block-tridiagonal elimination of P = I - gamma*J. Elements are only coupled through
+	// the mobile phase, so the sub- and super-diagonal blocks have a single non-zero entry
+	// and the elimination only modifies the (0,0) entry of the diagonal blocks.
+	// Per element we store the inverse of the modified diagonal block and the two
+	// coupling coefficients.
+	for (unsigned int i=0; i<m_nActive; ++i) {
+		double lower, diag, upper;
+		jacobianCoefficients(i, lower, diag, upper);
+		unsigned int ic = i*m_nVars;
+		double dc = m_jacobianMask[ic];
+		double * f = &m_precFactors[6*i];
+		f[4] = (i > 0) ? -gamma*lower*m_jacobianMask[ic - m_nVars] : 0;
+		f[5] = (i+1 < m_nActive) ? -gamma*upper*m_jacobianMask[ic + m_nVars] : 0;
+
+		double a = 1 - gamma*(diag + M[0])*dc;
+		if (i > 0) {
+			const double * fPrev = &m_precFactors[6*(i-1)];
+			a -= f[4]*fPrev[0]*fPrev[5];
+		}
+		if (m_nVars == 1) {
+			f[0] = 1/a;
+		}
+		else {
+			double ds = m_jacobianMask[ic+1];
+			double b = -gamma*M[1]*ds;
+			double c = -gamma*M[2]*dc;
+			double d = 1 - gamma*M[3]*ds;
+			double det = a*d - b*c;
+			f[0] =  d/det;
+			f[1] = -b/det;
+			f[2] = -c/det;
+			f[3] =  a/det;
+		}
+	}
+}
+
+
+void Solver::solvePreconditioner(const double * r, double * z) const {
+	// forward elimination, z holds the modified right-hand side
+	for (unsigned int i=0; i<m_nActive; ++i) {
+		unsigned int ic = i*m_nVars;
+		z[ic] = r[ic];
+		if (m_nVars == 2)
+			z[ic+1] = r[ic+1];
+		if (i > 0) {
+			// mobile phase component of the solution of the previous diagonal block
+			const double * fPrev = &m_precFactors[6*(i-1)];
+			unsigned int ip = ic - m_nVars;
+			double xPrev = (m_nVars == 1) ? fPrev[0]*z[ip] : fPrev[0]*z[ip] + fPrev[1]*z[ip+1];
+			z[ic] -= m_precFactors[6*i + 4]*xPrev;
+		}
+	}
+	// backward substitution
+	for (unsigned int i=m_nActive; i-- > 0;) {
+		unsigned int ic = i*m_nVars;
+		const double * f = &m_precFactors[6*i];
+		if (i+1 < m_nActive)
+			z[ic] -= f[5]*z[ic + m_nVars];
+		if (m_nVars == 1) {
+			z[ic] *= f[0];
+		}
+		else {
+			double r1 = z[ic];
+			double r2 = z[ic+1];
+			z[ic]   = f[0]*r1 + f[1]*r2;
+			z[ic+1] = f[2]*r1 + f[3]*r2;
+		}
+	}
+}
+
+
+void Solver::affineTerms(double * bInlet, double * bConst) const {
+	double M[4], g[2];
+	localSystem(M, g);
+	double A = m_input.A;
+	double dx = m_input.L/m_n;
+	double V_rev = A*dx;
+	for (unsigned int i=0; i<m_nActive; ++i) {
+		for (unsigned int k=0; k<m_nVars; ++k) {
+			bInlet[i*m_nVars + k] = 0;
+			bConst[i*m_nVars + k] = g[k];
+		}
+	}
+	// diffusive and convective inlet fluxes per unit inlet concentration
+	bInlet[0] = (m_input.D*A/dx + m_input.v*A)/V_rev;
+}
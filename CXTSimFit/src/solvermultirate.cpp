@@ -0,0 +1,213 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <cvode/cvode.h>
+#include <cvode/cvode_band.h>
+
+#include <IBK_Exception.h>
+
+#include "solver.h"
+
+/// Data of the mobile phase sub-system integrated with micro steps.
+/// The immobile phase is a given linear function of time within a macro step:
+/// sREV(t) = sStart + sRate*(t - tStart).
+struct MultirateMobileSystem {
+	Solver *				solver;
+	unsigned int			n;
+	double					tStart;
+	std::vector<double>		sStart;
+	std::vector<double>		sRate;
+	N_Vector				y;		///< Full solution vector (mobile and immobile phase, interleaved).
+	N_Vector				ydot;	///< Full divergences vector.
+};
+
+
+/// Fills the full solution vector with the mobile phase values and the immobile phase values at time t.
+static void assembleState(MultirateMobileSystem * sys, double t, const double * yc) {
+	double * y = NV_DATA_S(sys->y);
+	double dt = t - sys->tStart;
+	for (unsigned int i=0; i<sys->n; ++i) {
+		y[2*i] = yc[i];
+		y[2*i+1] = sys->sStart[i] + sys->sRate[i]*dt;
+	}
+}
+
+
+// Wrapper function called from CVode solver for the mobile phase sub-system.
+// All physics is evaluated in Solver::calculateDivergences(), we only pick the
+// mobile phase balances.
+static int f_mobile(realtype t, N_Vector y, N_Vector ydot, void *f_data) {
+	MultirateMobileSystem * sys = static_cast<MultirateMobileSystem*>(f_data);
+	assembleState(sys, t, NV_DATA_S(y));
+	int result = sys->solver->calculateDivergences(t, sys->y, sys->ydot);
+	const double * ydotFull = NV_DATA_S(sys->ydot);
+	double * ydotc = NV_DATA_S(ydot);
+	for (unsigned int i=0; i<sys->n; ++i)
+		ydotc[i] = ydotFull[2*i];
+	return result;
+}
+
+
+void Solver::runMultirate() {
+	FUNCID(Solver::runMultirate);
+
+	double V_rev = m_input.A * m_input.L/m_n;
+	double Rc = m_input.Rc;
+	double Rs = m_input.Rs;
+	double beta = m_input.beta;
+
+	// macro steps must end on output time points or divide the output interval
+	double dt_out = m_input.outputDt;
+	double H = m_input.macroDt;
+	if (H < dt_out)
+		H = dt_out/std::ceil(dt_out/H);
+	else
+		H = dt_out*std::floor(H/dt_out);
+
+	MultirateMobileSystem sys;
+	sys.solver = this;
+	sys.n = m_n;
+	sys.tStart = 0;
+	sys.sStart.resize(m_n);
+	sys.sRate.resize(m_n);
+	sys.y = N_VNew_Serial(2*m_n);
+	sys.ydot = N_VNew_Serial(2*m_n);
+	N_Vector yc = N_VNew_Serial(m_n);
+	N_Vector ycOut = N_VNew_Serial(m_n);
+	void * cvodeMem = nullptr;
+	// releases the integrator and the vectors, also when an exception leaves the integration
+	auto release = [&]() {
+		if (cvodeMem != nullptr)
+			CVodeFree(&cvodeMem);
+		N_Vector * vecs[] = { &yc, &ycOut, &sys.y, &sys.ydot };
+		for (unsigned int i=0; i<4; ++i) {
+			if (*vecs[i] != nullptr)
+				N_VDestroy_Serial(*vecs[i]);
+		}
+	};
+	if (!sys.y || !sys.ydot || !yc || !ycOut) {
+		release();
+		throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+	}
+
+	try {
+		double * y = N_VGetArrayPointer(m_yStorage);
+		for (unsigned int i=0; i<m_n; ++i) {
+			NV_DATA_S(yc)[i] = y[2*i];
+			sys.sStart[i] = y[2*i+1];
+		}
+
+		// initial rates of the immobile phase
+		calculateDivergences(0, m_yStorage, sys.ydot);
+		for (unsigned int i=0; i<m_n; ++i)
+			sys.sRate[i] = NV_DATA_S(sys.ydot)[2*i+1];
+
+		// mobile phase integrator, tridiagonal matrix
+		cvodeMem = CVodeCreate(CV_BDF, CV_NEWTON);
+		int result = CVodeInit(cvodeMem, f_mobile, m_t, yc);
+		if (result != CV_SUCCESS)
+			throw IBK::Exception("CVodeInit init error.", FUNC_ID);
+		CVodeSetUserData(cvodeMem, (void*)&sys);
+		result = CVBand(cvodeMem, m_n, 1, 1);
+		if (result != CVDLS_SUCCESS)
+			throw IBK::Exception("CVBand init error", FUNC_ID);
+		CVodeSetMaxOrd(cvodeMem, 5);
+		CVodeSetMaxNumSteps(cvodeMem, 100000);
+		CVodeSetInitStep(cvodeMem, 1e-3/m_n);
+		CVodeSetMaxStep(cvodeMem, m_input.maxDt);
+		CVodeSetMinStep(cvodeMem, m_input.minDt);
+		CVodeSStolerances(cvodeMem, m_relTol, m_input.absTol);
+
+		// calculate everything for first step so that we can write the inital output
+		storeOutput();
+
+		// time integral of the mobile phase mass densities over the current macro step
+		std::vector<double> ccIntegral(m_n, 0);
+		std::vector<double> ccLast(m_n);
+		for (unsigned int i=0; i<m_n; ++i)
+			ccLast[i] = std::max(0.0, NV_DATA_S(yc)[i]/Rc);
+
+		// output and macro step time points are computed from counters to avoid round-off drift
+		unsigned int macroStepsPerOutput = std::max(1u, static_cast<unsigned int>(std::floor(dt_out/H + 0.5)));
+		unsigned int macroSteps = 0;
+		double t = m_t;
+		unsigned int outputs = 1;
+		double t_out = dt_out;
+		int progress = 0; // for the progress indicator
+		while (m_t < m_tEnd) {
+			++macroSteps;
+			double tMacroEnd = macroSteps*H;
+			CVodeSetStopTime(cvodeMem, tMacroEnd);
+
+			// micro steps of the mobile phase
+			while (t < tMacroEnd) {
+				double tLast = t;
+				result = CVode(cvodeMem, tMacroEnd, yc, &t, CV_ONE_STEP);
+				if (result < 0)
+					throw IBK::Exception("Error while integrating solution.", FUNC_ID);
+
+				// trapezoidal rule for the mobile phase mass densities
+				for (unsigned int i=0; i<m_n; ++i) {
+					double cc = std::max(0.0, NV_DATA_S(yc)[i]/Rc);
+					ccIntegral[i] += 0.5*(t - tLast)*(ccLast[i] + cc);
+					ccLast[i] = cc;
+				}
+
+				// outputs within the macro step use the extrapolated immobile phase
+				while (t_out < tMacroEnd && t_out <= t) {
+					CVodeGetDky(cvodeMem, t_out, 0, ycOut);
+					assembleState(&sys, t_out, NV_DATA_S(ycOut));
+					std::copy(NV_DATA_S(sys.y), NV_DATA_S(sys.y) + 2*m_n, y);
+					m_t = t_out;
+					storeOutput();
+					t_out = (++outputs)*dt_out;
+				}
+			}
+
+			// Immobile phase update over the macro step with the trapezoidal rule, using the time integral
+			// of the mobile phase mass densities from the micro steps. The mass exchanged differs from the
+			// mass removed from the mobile phase only by the deviation of the extrapolated immobile phase
+			// from the trapezoidal approximation (second order in H).
+			for (unsigned int i=0; i<m_n; ++i) {
+				double a = H*(beta + m_input.mus)/(Rs*V_rev);
+				double sOld = sys.sStart[i];
+				double sNew = (sOld*(1 - 0.5*a) + (beta*ccIntegral[i] + H*m_input.gammas)/V_rev)/(1 + 0.5*a);
+				sys.sRate[i] = (sNew - sOld)/H;
+				sys.sStart[i] = sNew;
+				ccIntegral[i] = 0;
+				y[2*i] = NV_DATA_S(yc)[i];
+				y[2*i+1] = sNew;
+			}
+			sys.tStart = tMacroEnd;
+			m_t = tMacroEnd;
+
+			// the mobile phase system changes at the macro step boundary, restart integrator
+			// with the last step size
+			double h0 = 0;
+			CVodeGetLastStep(cvodeMem, &h0);
+			CVodeReInit(cvodeMem, m_t, yc);
+			CVodeSetInitStep(cvodeMem, h0);
+
+			int section = static_cast<int>(m_t/m_tEnd*10);
+			if (section > progress) {
+				std::cout << ".";
+				progress = section;
+			}
+			if (macroSteps % macroStepsPerOutput == 0) {
+				// macro step ends on output time point
+				storeOutput();
+				t_out = (++outputs)*dt_out;
+			}
+		}
+		m_outputCounter = 0; // force storage of profiles
+		storeOutput(true);
+	}
+	catch (...) {
+		release();
+		throw;
+	}
+
+	release();
+}
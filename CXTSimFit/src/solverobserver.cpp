@@ -0,0 +1,111 @@
+#include "solverobserver.h"
+
+#include <ostream>
+#include <cmath>
+#include <algorithm>
+
+#include "solverinput.h"
+
+ResidualAccumulator::ResidualAccumulator(const std::vector<double> & t) :
+	m_t(t),
+	m_values(t.size(), 0),
+	m_next(0),
+	m_lastT(-1),
+	m_lastC(0)
+{
+}
+
+
+void ResidualAccumulator::observe(const SolverOutput & out) {
+	// linear interpolation between the last and the current output, like IBK::LinearSpline
+	for (; m_next < m_t.size() && m_t[m_next] <= out.t; ++m_next) {
+		if (m_lastT < 0 || out.t <= m_lastT)
+			m_values[m_next] = out.outletC;
+		else
+			m_values[m_next] = m_lastC + (out.outletC - m_lastC)*(m_t[m_next] - m_lastT)/(out.t - m_lastT);
+	}
+	m_lastT = out.t;
+	m_lastC = out.outletC;
+}
+
+
+MomentAccumulator::MomentAccumulator() :
+	m_m0(0),
+	m_m1(0),
+	m_m2(0),
+	m_lastT(-1),
+	m_lastC(0)
+{
+}
+
+
+void MomentAccumulator::observe(const SolverOutput & out) {
+	if (m_lastT >= 0) {
+		double dt = out.t - m_lastT;
+		m_m0 += 0.5*dt*(m_lastC + out.outletC);
+		m_m1 += 0.5*dt*(m_lastT*m_lastC + out.t*out.outletC);
+		m_m2 += 0.5*dt*(m_lastT*m_lastT*m_lastC + out.t*out.t*out.outletC);
+	}
+	m_lastT = out.t;
+	m_lastC = out.outletC;
+}
+
+
+double MomentAccumulator::mean() const {
+	return (m_m0 > 0) ? m_m1/m_m0 : 0;
+}
+
+
+double MomentAccumulator::variance() const {
+	if (m_m0 <= 0)
+		return 0;
+	double tMean = mean();
+	return std::max(0.0, m_m2/m_m0 - tMean*tMean);
+}
+
+
+void MomentAccumulator::write(std::ostream & out) const {
+	out << "Outlet moments   : area " << m_m0 << " kg/m3 h, mean time " << mean() << " h, "
+		<< "standard deviation " << std::sqrt(variance()) << " h\n";
+}
+
+
+ProbeSampler::ProbeSampler(const SolverInput & input) :
+	m_Rc(input.Rc),
+	m_c(input.probePositions.size())
+{
+	// element centres are at (i + 0.5)*dx, the first and the last element extend to the bed ends
+	unsigned int n = input.n;
+	double dx = input.L/n;
+	for (unsigned int j=0; j<input.probePositions.size(); ++j) {
+		double xi = input.probePositions[j]/dx - 0.5;
+		if (xi <= 0 || n < 2) {
+			m_left.push_back(0);
+			m_weight.push_back(0);
+		}
+		else if (xi >= n - 1) {
+			m_left.push_back(n - 2);
+			m_weight.push_back(1);
+		}
+		else {
+			unsigned int i = static_cast<unsigned int>(xi);
+			m_left.push_back(i);
+			m_weight.push_back(xi - i);
+		}
+	}
+}
+
+
+void ProbeSampler::observe(const SolverOutput & out) {
+	m_t.push_back(out.t);
+	for (unsigned int j=0; j<m_left.size(); ++j) {
+		// mobile phase concentrations of the two elements, like Solver::updateConcentrations()
+		double c[2] = { 0, 0 };
+		for (unsigned int k=0; k<2; ++k) {
+			unsigned int i = std::min(m_left[j] + k, out.n - 1);
+			if (i < out.nActive)
+				c[k] = std::max(0.0, out.y[i*out.nVars]/m_Rc);
+		}
+		m_c[j].push_back(c[0] + m_weight[j]*(c[1] - c[0]));
+	}
+}
@@ -0,0 +1,139 @@
+#ifndef solverobserver_h
+#define solverobserver_h
+
+#include <vector>
+#include <iosfwd>
+
+class SolverStatistics;
+class SolverInput;
+
+/// Outputs of a solver at an output time point, passed to the attached observers.
+struct SolverOutput {
+	double			t;			///< Time point in h.
+	/// True for every SolverInput::outputN-th output and the last output (fixed output schedule).
+	bool			scheduled;
+	bool			last;		///< True for the last output of the run (end time or end of the run).
+	double			outletC;	///< Outlet concentration in kg/m3.
+	unsigned int	n;			///< Number of elements.
+	/// Solution (total mass densities in kg/m3 of the nVars variables per element) of the first nActive
+	/// elements, the elements ahead of the active window are empty.
+	const double	*y;
+	unsigned int	nActive;	///< Number of elements in y.
+	unsigned int	nVars;		///< Number of variables per element.
+	/// Mobile phase concentrations in kg/m3 (n values), nullptr unless an observer needs Q_PROFILES.
+	const double	*cc;
+	/// Immobile phase concentrations in kg/m3 (n values), nullptr for a single component or without Q_PROFILES.
+	const double	*sc;
+};
+
+
+/// Interface for objects that evaluate the outputs of a solver run.
+///
+/// Observers are attached with Solver::addObserver() before Solver::run() and are called at each
+/// output time point. Each observer declares the quantities it needs, the solver computes only
+/// those (with no observer or outlet-only observers the profiles are not computed at all). The outlet
+/// series (Solver::m_outletT, Solver::m_outletC) is always stored.
+class SolverObserver {
+public:
+	/// Quantities computed for the observers (combined bitwise).
+	enum quantity_t {
+		Q_OUTLET	= 0x1,	///< Outlet concentration and solution only (no derived quantities).
+		Q_PROFILES	= 0x2	///< Mobile and immobile phase concentrations of all elements.
+	};
+
+	/// Destructor.
+	virtual ~SolverObserver() {}
+
+	/// Returns the quantities (combination of quantity_t) needed by the observer.
+	virtual unsigned int quantities() const = 0;
+
+	/// Called at each output time point.
+	virtual void observe(const SolverOutput & out) = 0;
+
+	/// Adds the observer's figures to the statistics of a run (nothing by default).
+	virtual void statistics(SolverStatistics & stats) const { (void)stats; }
+};
+
+
+/// Interpolates the outlet concentration at given time points (e.g. those of a measured
+/// curve) while the solver runs, the residuals are formed from value() by the caller.
+class ResidualAccumulator : public SolverObserver {
+public:
+	/// Constructor.
+	/// @param t Time points in h, ascending.
+	ResidualAccumulator(const std::vector<double> & t);
+
+	virtual unsigned int quantities() const { return Q_OUTLET; }
+	virtual void observe(const SolverOutput & out);
+
+	/// Calculated outlet concentration at time point k in kg/m3. Time points beyond the last
+	/// output get the last outlet concentration, those before the first output the first one.
+	double value(unsigned int k) const { return k < m_next ? m_values[k] : m_lastC; }
+
+private:
+	std::vector<double>		m_t;		///< Time points in h.
+	std::vector<double>		m_values;	///< Calculated concentrations at m_t in kg/m3 (first m_next values).
+	unsigned int			m_next;		///< Index of the first time point after the last output.
+	double					m_lastT;	///< Time point of the last output in h, -1 before the first output.
+	double					m_lastC;	///< Outlet concentration of the last output in kg/m3.
+};
+
+
+/// Computes the temporal moments of the outlet concentration (trapezoidal rule over the outputs).
+/// For a tracer pulse, mean() is the mean residence time and variance() the spreading of the pulse.
+class MomentAccumulator : public SolverObserver {
+public:
+	/// Constructor.
+	MomentAccumulator();
+
+	virtual unsigned int quantities() const { return Q_OUTLET; }
+	virtual void observe(const SolverOutput & out);
+
+	/// Zeroth moment (area under the outlet curve) in kg/m3 h.
+	double m0() const { return m_m0; }
+	/// Mean time (first moment divided by zeroth moment) in h, 0 if m0() is 0.
+	double mean() const;
+	/// Variance of the time about the mean time in h2, 0 if m0() is 0.
+	double variance() const;
+
+	/// Writes the moments in human readable form.
+	void write(std::ostream & out) const;
+
+private:
+	double		m_m0;		///< Zeroth moment in kg/m3 h.
+	double		m_m1;		///< First moment in kg/m3 h2.
+	double		m_m2;		///< Second moment in kg/m3 h3.
+	double		m_lastT;	///< Time point of the last output in h, -1 before the first output.
+	double		m_lastC;	///< Outlet concentration of the last output in kg/m3.
+};
+
+
+/// Records the mobile phase concentration at the probe positions of the input (linear interpolation
+/// between the element centres) at each output time point. Only the two elements around each position
+/// are evaluated, the profiles are neither computed nor stored.
+class ProbeSampler : public SolverObserver {
+public:
+	/// Constructor.
+	/// @param input Solver input with the probe positions (SolverInput::probePositions) and the grid.
+	explicit ProbeSampler(const SolverInput & input);
+
+	virtual unsigned int quantities() const { return Q_OUTLET; }
+	virtual void observe(const SolverOutput & out);
+
+	/// Number of probes.
+	unsigned int size() const { return static_cast<unsigned int>(m_left.size()); }
+
+	/// Time points of the samples in h.
+	const std::vector<double> & t() const { return m_t; }
+	/// Concentrations of probe j at all time points in kg/m3.
+	const std::vector<double> & c(unsigned int j) const { return m_c[j]; }
+
+private:
+	std::vector<unsigned int>			m_left;		///< Element left of each probe position.
+	std::vector<double>					m_weight;	///< Weight of the element right of each probe position.
+	double								m_Rc;		///< Retention coefficient (total to mobile phase mass density).
+	std::vector<double>					m_t;		///< Time points in h.
+	std::vector<std::vector<double> >	m_c;		///< Concentrations in kg/m3, per probe.
+};
+
+#endif // solverobserver_h
@@ -0,0 +1,153 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include <IBK_Exception.h>
+
+#include "solver.h"
+
+void Solver::configureIntegrator() {
+	FUNCID(Solver::configureIntegrator);
+	m_statistics.probed = false;
+	m_statistics.stabLimDet = false;
+	switch (m_input.integrator) {
+		case SolverInput::INTEGRATOR_BDF :
+			m_statistics.adams = false;
+			m_statistics.newton = true;
+			m_statistics.maxOrder = 5;
+			m_statistics.initialStep = 1e-3/m_n;
+			return;
+
+		case SolverInput::INTEGRATOR_ADAMS :
+			m_statistics.adams = true;
+			m_statistics.newton = false;
+			m_statistics.maxOrder = 12;
+			m_statistics.initialStep = 1e-3/m_n;
+			return;
+
+		case SolverInput::INTEGRATOR_AUTO :
+			break;
+	}
+
+	// Probe of the linear system y' = J y + b (see steadyStateJacobian()) at the initial state.
+	// The spectral radius of J is bounded by the maximum absolute row sum (Gershgorin).
+	double M[4], g[2];
+	localSystem(M, g);
+	std::vector<double> lower(m_nActive), diag(m_nActive), upper(m_nActive);
+	double rho = 0;
+	for (unsigned int i=0; i<m_nActive; ++i) {
+		jacobianCoefficients(i, lower[i], diag[i], upper[i]);
+		rho = std::max(rho, std::fabs(diag[i] + M[0]) + std::fabs(lower[i]) + std::fabs(upper[i]) + std::fabs(M[1]));
+		if (m_nVars == 2)
+			rho = std::max(rho, std::fabs(M[3]) + std::fabs(M[2]));
+	}
+	m_statistics.spectralRadius = rho;
+
+	// Initial step: second order Taylor term h^2/2 y'' equals the error weight (plateau values for
+	// the feed concentration, like the steady-state solver), with y'' = J y' for constant inlet.
+	N_Vector ydot = N_VClone(m_yStorage);
+	if (!ydot)
+		throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+	calculateDivergences(m_t, m_yStorage, ydot);
+	const double * f = N_VGetArrayPointer(ydot);
+	double h0 = m_tEnd;
+	for (unsigned int i=0; i<m_nActive; ++i) {
+		for (unsigned int k=0; k<m_nVars; ++k) {
+			unsigned int ik = i*m_nVars + k;
+			double ydd;
+			if (k == 0) {
+				ydd = (diag[i] + M[0])*f[ik];
+				if (i > 0)
+					ydd += lower[i]*f[ik - m_nVars];
+				if (i+1 < m_nActive)
+					ydd += upper[i]*f[ik + m_nVars];
+				if (m_nVars == 2)
+					ydd += M[1]*f[ik + 1];
+			}
+			else
+				ydd = M[2]*f[ik - 1] + M[3]*f[ik];
+			double w = m_relTol*((k == 0) ? m_input.Rc : m_input.Rs)*m_cFeed + m_input.absTol;
+			if (ydd != 0)
+				h0 = std::min(h0, std::sqrt(2*w/std::fabs(ydd)));
+		}
+	}
+	N_VDestroy(ydot);
+	h0 = std::max(h0, m_input.minDt);
+	m_statistics.initialStep = h0;
+	m_statistics.probed = true;
+
+	// The Adams method with functional iteration is cheaper per step, but its steps are limited by
+	// stability (functional iteration converges only for h rho < 1) and, for sharp concentration fronts,
+	// by accuracy much more than those of BDF. If the maximum step lies within the stability limit,
+	// both methods are tried on the first tenth of the simulation time and the cheaper one is used.
+	// The Adams trial is stopped once it has become more expensive than the BDF trial.
+	double hMax = std::min(m_input.maxDt, m_tEnd);
+	bool adams = false;
+	if (rho*hMax < 1 && m_nActive == m_n) {
+		double tProbe = m_t + 0.1*(m_tEnd - m_t);
+		m_statistics.probeCostBDF = probeCost(false, tProbe, std::numeric_limits<double>::max());
+		m_statistics.probeCostAdams = probeCost(true, tProbe, m_statistics.probeCostBDF);
+		adams = (m_statistics.probeCostAdams < m_statistics.probeCostBDF);
+	}
+	m_statistics.adams = adams;
+	m_statistics.newton = !adams;
+	m_statistics.maxOrder = adams ? 12 : 5;
+
+	// Convection-dominated transport (cell Peclet number > 2) has eigenvalues close to the imaginary axis,
+	// where BDF of order 3-5 is unstable; the stability limit detection reduces the order in this case.
+	double dx = m_input.L/m_n;
+	m_statistics.stabLimDet = !adams && m_input.v*dx > 2*m_input.D;
+}
+
+
+double Solver::probeCost(bool adams, double tProbe, double maxCost) {
+	FUNCID(Solver::probeCost);
+	m_statistics.adams = adams;
+	m_statistics.newton = !adams;
+	m_statistics.maxOrder = adams ? 12 : 5;
+
+	// integrate a copy of the initial state
+	N_Vector y0 = N_VClone(m_yStorage);
+	if (!y0)
+		throw IBK::Exception("Solution vector allocation error!", FUNC_ID);
+	N_VScale(1, m_yStorage, y0);
+	double t0 = m_t;
+	// restores the initial state, also if the trial integration throws,
+	// the trial counts are not part of the run statistics
+	auto restoreState = [&]() {
+		CVodeFree(&m_cvodeMem);
+		m_cvodeMem = nullptr;
+		m_statistics.clearCounters();
+		N_VScale(1, y0, m_yStorage);
+		N_VDestroy(y0);
+		m_t = t0;
+	};
+
+	double cost = 0;
+	try {
+		initCVODE(m_t, m_statistics.initialStep);
+		CVodeSetStopTime(m_cvodeMem, tProbe);
+		double t = m_t;
+		int result = CV_SUCCESS;
+		while (t < tProbe && cost < maxCost) {
+			result = CVode(m_cvodeMem, tProbe, m_yStorage, &t, CV_ONE_STEP);
+			if (result < 0)
+				break;
+			// each Newton iteration solves the band system (about the cost of a right-hand side evaluation)
+			SolverStatistics stats;
+			cvodeCounters(stats);
+			cost = stats.rhsEvals;
+			if (!adams)
+				cost += stats.nonlinIters + stats.linSetups;
+		}
+		if (result < 0 || t < tProbe)
+			cost = std::numeric_limits<double>::max();
+	}
+	catch (...) {
+		restoreState();
+		throw;
+	}
+	restoreState();
+	return cost;
+}
@@ -4,8 +4,9 @@ using namespace std;
 
 void SolverResults::clear() {
 	data.clear(); // also marks the solver results as invalid
-	ccProfiles.clear();
-	scProfiles.clear();
+	profiles.reset();
+	breakthroughT.clear();
+	probes.clear();
 }
 
 double SolverResults::calculateRSquare(const IBK::LinearSpline & other) {
@@ -2,10 +2,12 @@
 #define solverresults_h
 
 #include <vector>
+#include <memory>
 
 #include <IBK_LinearSpline.h>
 
 #include "solverinput.h"
+#include "profilestore.h"
 
 /// Contains all results from a solver run.
 class SolverResults {
@@ -21,9 +23,15 @@ public:
 	IBK::LinearSpline		data;
 	double					R2;
 
-	std::vector<std::vector<double> >	ccProfiles;
-	std::vector<std::vector<double> >	scProfiles;
-	std::vector<double>					tProfiles;
+	/// Concentration profiles, shared with the solver and other copies of the results (may be empty).
+	std::shared_ptr<const ProfileStore>	profiles;
+
+	/// First crossing times of SolverInput::breakthroughFractions in [h], -1 if not reached.
+	std::vector<double>					breakthroughT;
+
+	/// Concentrations at SolverInput::probePositions in [kg/m3] over time in [h], one series per probe
+	/// (empty if the run did not record probes).
+	std::vector<IBK::LinearSpline>		probes;
 
 };
 
@@ -0,0 +1,75 @@
+#include "solverstatistics.h"
+
+#include <limits>
+#include <ostream>
+
+SolverStatistics::SolverStatistics() :
+	adams(false),
+	newton(true),
+	stabLimDet(false),
+	maxOrder(5),
+	initialStep(0),
+	probed(false),
+	spectralRadius(0),
+	probeCostAdams(0),
+	probeCostBDF(0),
+	profileSnapshots(0),
+	profileBytes(0),
+	profileRawBytes(0)
+{
+	clearCounters();
+}
+
+
+void SolverStatistics::clearCounters() {
+	steps = 0;
+	rhsEvals = 0;
+	linSetups = 0;
+	errTestFails = 0;
+	nonlinIters = 0;
+	nonlinConvFails = 0;
+	stabLimOrderReds = 0;
+}
+
+
+void SolverStatistics::addCounters(const SolverStatistics & other) {
+	steps += other.steps;
+	rhsEvals += other.rhsEvals;
+	linSetups += other.linSetups;
+	errTestFails += other.errTestFails;
+	nonlinIters += other.nonlinIters;
+	nonlinConvFails += other.nonlinConvFails;
+	stabLimOrderReds += other.stabLimOrderReds;
+}
+
+
+void SolverStatistics::write(std::ostream & out) const {
+	out << "Integrator       : " << (adams ? "Adams-Moulton" : "BDF") << ", "
+		<< (newton ? "Newton" : "functional") << " iteration, max. order " << maxOrder
+		<< (stabLimDet ? ", stability limit detection" : "") << (probed ? " (automatic)" : "") << "\n";
+	out << "Initial step     : " << initialStep << " s\n";
+	if (probed) {
+		out << "Spectral radius  : " << spectralRadius << " 1/s\n";
+		if (probeCostAdams > 0) {
+			out << "Probe cost       : ";
+			if (probeCostAdams == std::numeric_limits<double>::max())
+				out << "aborted";
+			else
+				out << probeCostAdams;
+			out << " (Adams), " << probeCostBDF << " (BDF)\n";
+		}
+	}
+	out << "Steps            : " << steps << "\n";
+	out << "RHS evaluations  : " << rhsEvals << "\n";
+	out << "Linear setups    : " << linSetups << "\n";
+	out << "Error test fails : " << errTestFails << "\n";
+	out << "Nonlin. iters    : " << nonlinIters << "\n";
+	out << "Nonlin. failures : " << nonlinConvFails << "\n";
+	if (stabLimDet)
+		out << "Stab. order reds : " << stabLimOrderReds << "\n";
+	if (profileSnapshots > 0) {
+		out << "Profiles         : " << profileSnapshots << " snapshots, "
+			<< profileBytes/profileSnapshots << " bytes per snapshot (raw "
+			<< profileRawBytes/profileSnapshots << ")\n";
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef solverstatistics_h
+#define solverstatistics_h
+
+#include <iosfwd>
+#include <cstddef>
+
+/// Integrator configuration and counters of a solver run.
+class SolverStatistics {
+public:
+	/// Constructor, resets all counters.
+	SolverStatistics();
+
+	/// Resets the counters (the configuration is kept).
+	void clearCounters();
+
+	/// Adds the counters of other (e.g. of a previous CVODE instance).
+	void addCounters(const SolverStatistics & other);
+
+	/// Writes configuration and counters in human readable form.
+	void write(std::ostream & out) const;
+
+	// Integrator configuration
+	bool			adams;			///< True for the Adams-Moulton method, false for BDF.
+	bool			newton;			///< True for Newton iteration, false for functional (fixed-point) iteration.
+	bool			stabLimDet;		///< True if the BDF stability limit detection is enabled.
+	int				maxOrder;		///< Maximum method order.
+	double			initialStep;	///< Initial step size in s.
+	bool			probed;			///< True if the configuration was chosen automatically (SolverInput::INTEGRATOR_AUTO).
+	double			spectralRadius;	///< Estimated spectral radius of the Jacobian in 1/s (probe only).
+	double			probeCostAdams;	///< Cost of the Adams trial integration (RHS evaluation equivalents), 0 if not probed.
+	double			probeCostBDF;	///< Cost of the BDF trial integration (RHS evaluation equivalents), 0 if not probed.
+
+	// Counters
+	long int		steps;			///< Number of integrator steps.
+	long int		rhsEvals;		///< Number of right-hand side evaluations (including difference-quotient Jacobians).
+	long int		linSetups;		///< Number of linear solver setups (Jacobian/preconditioner updates).
+	long int		errTestFails;	///< Number of local error test failures.
+	long int		nonlinIters;	///< Number of nonlinear iterations.
+	long int		nonlinConvFails;	///< Number of nonlinear convergence failures.
+	long int		stabLimOrderReds;	///< Number of order reductions due to the stability limit detection.
+
+	// Outputs
+	unsigned int	profileSnapshots;	///< Number of stored profile snapshots.
+	size_t			profileBytes;		///< Size of the stored (encoded) profile snapshots in bytes.
+	size_t			profileRawBytes;	///< Size of the profile snapshots as raw doubles in bytes.
+};
+
+#endif // solverstatistics_h
@@ -0,0 +1,166 @@
+#include <cmath>
+#include <algorithm>
+
+#include <kinsol/kinsol.h>
+#include <kinsol/kinsol_band.h>
+
+#include <IBK_Exception.h>
+#include <IBK_StringUtils.h>
+
+#include "solver.h"
+
+/// Data passed to the KINSOL callback functions.
+struct SteadyStateSystem {
+	Solver *	solver;
+	double		t;		///< Time point in s that determines the inlet concentration.
+};
+
+
+// Wrapper function called from KINSOL, the steady state is the root of the divergences.
+static int f_steady(N_Vector y, N_Vector f, void *user_data) {
+	SteadyStateSystem * sys = static_cast<SteadyStateSystem*>(user_data);
+	return sys->solver->calculateDivergences(sys->t, y, f);
+}
+
+
+// Wrapper function called from KINSOL for the analytical band Jacobian.
+static int jac_steady(long int /*N*/, long int /*mupper*/, long int /*mlower*/, N_Vector /*u*/, N_Vector /*fu*/,
+					  DlsMat J, void *user_data, N_Vector /*tmp1*/, N_Vector /*tmp2*/)
+{
+	static_cast<SteadyStateSystem*>(user_data)->solver->steadyStateJacobian(J);
+	return 0;
+}
+
+
+void Solver::steadyStateJacobian(DlsMat J) const {
+	double M[4], g[2];
+	localSystem(M, g);
+	SetToZero(J);
+	// the steady state is non-negative, hence the Jacobian is computed without clipping
+	for (unsigned int i=0; i<m_nActive; ++i) {
+		double lower, diag, upper;
+		jacobianCoefficients(i, lower, diag, upper);
+		long int ic = i*m_nVars;
+		BAND_ELEM(J, ic, ic) = diag + M[0];
+		if (i > 0)
+			BAND_ELEM(J, ic, ic - m_nVars) = lower;
+		if (i+1 < m_nActive)
+			BAND_ELEM(J, ic, ic + m_nVars) = upper;
+		if (m_nVars == 2) {
+			BAND_ELEM(J, ic, ic + 1) = M[1];
+			BAND_ELEM(J, ic + 1, ic) = M[2];
+			BAND_ELEM(J, ic + 1, ic + 1) = M[3];
+		}
+	}
+}
+
+
+void Solver::solveSteadyState(double t, N_Vector y) {
+	FUNCID(Solver::solveSteadyState);
+	if (m_nActive != m_n)
+		throw IBK::Exception("The steady-state solver requires the whole domain to be active.", FUNC_ID);
+
+	unsigned int nEquations = m_n*m_nVars;
+	SteadyStateSystem sys;
+	sys.solver = this;
+	sys.t = t;
+
+	// Scaling: the state is scaled with the weights of the CVODE error test, using the plateau
+	// values for the inlet concentration as magnitudes. The residuals are scaled with the diagonal
+	// of the Jacobian, so that they are measured as state changes, too.
+	double cIn = std::max(0.0, inletConcentration(t));
+	N_Vector uScale = N_VClone(y);
+	N_Vector fScale = N_VClone(y);
+	if (!uScale || !fScale) {
+		if (uScale)
+			N_VDestroy(uScale);
+		if (fScale)
+			N_VDestroy(fScale);
+		throw IBK::Exception("Scaling vector allocation error!", FUNC_ID);
+	}
+	double M[4], g[2];
+	localSystem(M, g);
+	for (unsigned int i=0; i<m_n; ++i) {
+		double lower, diag, upper;
+		jacobianCoefficients(i, lower, diag, upper);
+		for (unsigned int k=0; k<m_nVars; ++k) {
+			double R = (k == 0) ? m_input.Rc : m_input.Rs;
+			double w = m_relTol*R*cIn + m_input.absTol;
+			double jdiag = std::fabs((k == 0) ? diag + M[0] : M[3]);
+			N_VGetArrayPointer(uScale)[i*m_nVars + k] = 1/w;
+			N_VGetArrayPointer(fScale)[i*m_nVars + k] = 1/(w*std::max(jdiag, 1e-30));
+		}
+	}
+
+	void * kinMem = KINCreate();
+	int result = KINInit(kinMem, f_steady, y);
+	if (result == KIN_SUCCESS) {
+		KINSetUserData(kinMem, (void*)&sys);
+		result = KINBand(kinMem, nEquations, m_nVars, m_nVars);
+		if (result != KINDLS_SUCCESS) {
+			KINFree(&kinMem);
+			N_VDestroy(uScale);
+			N_VDestroy(fScale);
+			throw IBK::Exception("KINBand init error (problem too large?)", FUNC_ID);
+		}
+	}
+	else {
+		KINFree(&kinMem);
+		N_VDestroy(uScale);
+		N_VDestroy(fScale);
+		throw IBK::Exception("KINInit init error.", FUNC_ID);
+	}
+	KINDlsSetBandJacFn(kinMem, jac_steady);
+	KINSetPrintLevel(kinMem, 0);
+	// the Jacobian is cheap, update it in every iteration
+	KINSetMaxSetupCalls(kinMem, 1);
+	// converged once the Newton correction is well below the integrator tolerances
+	KINSetFuncNormTol(kinMem, 1e-2);
+	KINSetScaledStepTol(kinMem, 1e-2);
+	KINSetNumMaxIters(kinMem, 50);
+	// the default limit is based on the initial guess (usually empty), permit steps up to ten times the plateau values
+	KINSetMaxNewtonStep(kinMem, 10*std::sqrt((double)nEquations)/m_relTol);
+
+	result = KINSol(kinMem, y, KIN_LINESEARCH, uScale, fScale);
+	KINFree(&kinMem);
+	N_VDestroy(uScale);
+	N_VDestroy(fScale);
+	if (result < 0)
+		throw IBK::Exception("Steady-state solver failed (KINSOL error code " + IBK::val2string(result) + ").", FUNC_ID);
+}
+
+
+bool Solver::constantInlet(double t) const {
+	if (m_cInletData.empty())
+		return true;
+	double c = inletConcentration(t);
+	if (inletConcentration(m_tEnd) != c)
+		return false;
+	// data points within [t, tEnd] must have the same value (spline in h),
+	// with periodic operation all data points are used again
+	const std::vector<double> & x = m_cInletData.x();
+	const std::vector<double> & y = m_cInletData.y();
+	bool periodic = (m_input.cyclePeriod > 0);
+	for (unsigned int i=0; i<x.size(); ++i) {
+		if ((periodic || (x[i] > t/3600 && x[i] < m_tEnd/3600)) && y[i] != c)
+			return false;
+	}
+	return true;
+}
+
+
+bool Solver::steadyStateReached() const {
+	if (m_ySteady == nullptr || m_nActive != m_n || !constantInlet(m_t))
+		return false;
+	// distance to the steady state in the norm of the CVODE error test
+	const double * y = N_VGetArrayPointer(m_yStorage);
+	const double * ys = N_VGetArrayPointer(m_ySteady);
+	unsigned int nEquations = m_n*m_nVars;
+	double norm = 0;
+	for (unsigned int i=0; i<nEquations; ++i) {
+		double w = m_relTol*std::fabs(ys[i]) + m_input.absTol;
+		double d = (y[i] - ys[i])/w;
+		norm += d*d;
+	}
+	return std::sqrt(norm/nEquations) < 1;
+}
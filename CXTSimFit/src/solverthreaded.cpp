@@ -0,0 +1,32 @@
+#include <algorithm>
+
+#include <IBK_openMP.h>
+
+#include "solver.h"
+
+void Solver::calculateDivergencesThreaded(double cIn, const double * y, double * ydot) {
+	double	Rc		= m_input.Rc;
+
+	// Each thread handles the elements [i0, i1) with divergenceKernel(). The upstream and downstream
+	// neighbor elements of a chunk (halo) are read directly from y instead of the shared arrays, hence
+	// the threads never wait for each other and the results do not depend on the number of threads.
+#if defined(_OPENMP)
+	#pragma omp parallel num_threads(m_threads)
+#endif
+	{
+#if defined(_OPENMP)
+		unsigned int nt = omp_get_num_threads();
+		unsigned int tid = omp_get_thread_num();
+#else
+		unsigned int nt = 1;
+		unsigned int tid = 0;
+#endif
+		unsigned int i0 = static_cast<unsigned int>((unsigned long long)m_nActive*tid/nt);
+		unsigned int i1 = static_cast<unsigned int>((unsigned long long)m_nActive*(tid+1)/nt);
+
+		// halo: inlet concentration for the first chunk, clipped mobile concentrations like in the kernel
+		double ccUp = (i0 == 0) ? cIn : std::max(0.0, y[(i0-1)*m_nVars]/Rc);
+		double ccDown = (i1 < m_nActive) ? std::max(0.0, y[i1*m_nVars]/Rc) : 0;
+		divergenceKernel(i0, i1, ccUp, ccDown, y, ydot);
+	}
+}
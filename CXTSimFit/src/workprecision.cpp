@@ -0,0 +1,177 @@
+#include "workprecision.h"
+
+#include <cmath>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <ostream>
+
+#include <IBK_Exception.h>
+#include <IBK_StopWatch.h>
+
+#include "solver.h"
+#include "parallelfor.h"
+
+WorkPrecision::WorkPrecision(unsigned int threads) :
+	m_referenceRefinement(2),
+	m_referenceTolFactor(0.01),
+	m_repeats(1),
+	m_referenceWallTime(0),
+	m_threads(threads),
+	m_cFeed(1)
+{
+	if (m_threads == 0)
+		m_threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+void WorkPrecision::run(const SolverInput & input) {
+	FUNCID(WorkPrecision::run);
+	if (input.steadyState == SolverInput::SS_CYCLIC || input.steadyState == SolverInput::SS_CYCLIC_DIRECT)
+		throw IBK::Exception("The work-precision study does not support the cyclic steady state.", FUNC_ID);
+
+	m_input = input;
+	// the study compares outlet curves of complete runs with the Solver, field outputs are not needed
+	m_input.pararealSlices = 1;
+	m_input.stopAtBreakthrough = false;
+	m_input.reducedOrderFit = false;
+	m_input.outputN = std::numeric_limits<unsigned int>::max();
+
+	if (m_n.empty())		m_n.push_back(input.n);
+	if (m_relTol.empty())	m_relTol.push_back(input.relTol);
+	if (m_absTol.empty())	m_absTol.push_back(input.absTol);
+	if (m_maxDt.empty())	m_maxDt.push_back(input.maxDt);
+
+	m_cFeed = input.cInlet;
+	if (!input.cInletData.empty())
+		m_cFeed = *std::max_element(input.cInletData.y().begin(), input.cInletData.y().end());
+	if (m_cFeed <= 0)
+		m_cFeed = 1;
+
+	// reference run
+	SolverInput ref = m_input;
+	ref.n = m_referenceRefinement*(*std::max_element(m_n.begin(), m_n.end()));
+	ref.relTol = m_referenceTolFactor*(*std::min_element(m_relTol.begin(), m_relTol.end()));
+	ref.absTol = m_referenceTolFactor*(*std::min_element(m_absTol.begin(), m_absTol.end()));
+	ref.maxDt = *std::min_element(m_maxDt.begin(), m_maxDt.end());
+	long int steps;
+	try {
+		simulate(ref, m_referenceC, m_referenceWallTime, steps);
+	}
+	catch (IBK::Exception & ex) {
+		throw IBK::Exception(ex, "Reference run failed.", FUNC_ID);
+	}
+
+	// sweep points, n varies slowest
+	m_points.clear();
+	for (unsigned int in=0; in<m_n.size(); ++in)
+		for (unsigned int ir=0; ir<m_relTol.size(); ++ir)
+			for (unsigned int ia=0; ia<m_absTol.size(); ++ia)
+				for (unsigned int im=0; im<m_maxDt.size(); ++im) {
+					Point p;
+					p.n = m_n[in];
+					p.relTol = m_relTol[ir];
+					p.absTol = m_absTol[ia];
+					p.maxDt = m_maxDt[im];
+					m_points.push_back(p);
+				}
+
+	// failed points are marked, the other points are completed
+	parallelFor(static_cast<unsigned int>(m_points.size()), m_threads, [&](unsigned int i) {
+		Point & p = m_points[i];
+		try {
+			std::vector<double> outletC;
+			p.wallTime = std::numeric_limits<double>::max();
+			for (unsigned int r=0; r<std::max(1u, m_repeats); ++r) {
+				double wallTime;
+				simulate(pointInput(i), outletC, wallTime, p.steps);
+				p.wallTime = std::min(p.wallTime, wallTime);
+			}
+			p.error = 0;
+			unsigned int nOut = std::min(outletC.size(), m_referenceC.size());
+			for (unsigned int k=0; k<nOut; ++k)
+				p.error = std::max(p.error, std::fabs(outletC[k] - m_referenceC[k])/m_cFeed);
+		}
+		catch (std::exception & ex) {
+			p.failed = true;
+			p.errmsg = ex.what();
+		}
+	});
+}
+
+
+int WorkPrecision::recommendation(double maxError) const {
+	int best = -1;
+	for (unsigned int i=0; i<m_points.size(); ++i) {
+		const Point & p = m_points[i];
+		if (p.failed || p.error > maxError)
+			continue;
+		if (best == -1 || p.wallTime < m_points[best].wallTime)
+			best = i;
+	}
+	return best;
+}
+
+
+void WorkPrecision::writeTable(std::ostream & out) const {
+	out << "# reference: n=" << m_referenceRefinement*(*std::max_element(m_n.begin(), m_n.end()))
+		<< ", wall time " << m_referenceWallTime << " s\n";
+	out << "# n\trelTol\tabsTol\tmaxDt [s]\terror [-]\twall time [s]\tsteps\n";
+	for (unsigned int i=0; i<m_points.size(); ++i) {
+		const Point & p = m_points[i];
+		out << p.n << "\t" << p.relTol << "\t" << p.absTol << "\t" << p.maxDt << "\t";
+		if (p.failed)
+			out << "# failed: " << p.errmsg << "\n";
+		else
+			out << p.error << "\t" << p.wallTime << "\t" << p.steps << "\n";
+	}
+}
+
+
+void WorkPrecision::writeGnuplot(std::ostream & out, const std::string & dataFile, const std::string & pngFile,
+								 double maxError) const
+{
+	out << "set terminal pngcairo size 1000,700\n";
+	out << "set output '" << pngFile << "'\n";
+	out << "set title 'Work-precision diagram'\n";
+	out << "set xlabel 'Wall time [s]'\n";
+	out << "set ylabel 'Max. outlet error / feed concentration [-]'\n";
+	out << "set logscale xy\n";
+	out << "set grid\n";
+	out << "set key outside right\n";
+	int best = recommendation(maxError);
+	if (best != -1)
+		out << "set label 1 'recommended' at " << m_points[best].wallTime << "," << m_points[best].error
+			<< " point pt 6 ps 3 offset 1,1\n";
+	// one series per grid, labels show the tolerance and maximum time step
+	out << "plot ";
+	for (unsigned int in=0; in<m_n.size(); ++in) {
+		out << "'" << dataFile << "' using ($1==" << m_n[in] << " ? $6 : 1/0):5 with points pt 7 title 'n = "
+			<< m_n[in] << "', \\\n     ";
+	}
+	out << "'" << dataFile << "' using 6:5:(sprintf('%g/%g', $2, $4)) with labels offset 0,-0.8 font ',7' notitle, \\\n     ";
+	out << maxError << " with lines dt 2 lc rgb 'red' title 'requested error'\n";
+}
+
+
+SolverInput WorkPrecision::pointInput(unsigned int i) const {
+	SolverInput input = m_input;
+	input.n = m_points[i].n;
+	input.relTol = m_points[i].relTol;
+	input.absTol = m_points[i].absTol;
+	input.maxDt = m_points[i].maxDt;
+	return input;
+}
+
+
+void WorkPrecision::simulate(const SolverInput & input, std::vector<double> & outletC, double & wallTime, long int & steps) {
+	IBK::StopWatch watch;
+	Solver solver;
+	solver.init(input);
+	solver.run();
+	wallTime = watch.stop()*1e-3;
+	outletC = solver.m_outletC;
+	steps = 0;
+	if (input.engine == SolverInput::ENGINE_CVODE)
+		steps = solver.statistics().steps;
+}
@@ -0,0 +1,85 @@
+#ifndef workprecision_h
+#define workprecision_h
+
+#include <vector>
+#include <string>
+#include <iosfwd>
+
+#include "solverinput.h"
+
+/// Work-precision study of the numerical settings (number of elements, tolerances and maximum time step)
+/// for a given solver input.
+///
+/// All combinations of the sweep values are simulated and compared with a reference run, which uses
+/// m_referenceRefinement times the largest number of elements, the tightest tolerances multiplied with
+/// m_referenceTolFactor and the smallest maximum time step. The error of a run is the maximum deviation of
+/// its outlet concentration from the reference at the output time points, relative to the feed
+/// concentration, i.e. it includes the discretization error of the grid.
+///
+/// The sweep points are simulated concurrently. Wall times are therefore affected by other runs sharing
+/// the memory bandwidth; with one thread (and several repeats) the timings are most reliable.
+class WorkPrecision {
+public:
+	/// Results of a single sweep point.
+	struct Point {
+		Point() : n(0), relTol(0), absTol(0), maxDt(0), error(-1), wallTime(0), steps(0), failed(false) {}
+
+		unsigned int	n;			///< Number of elements.
+		double			relTol;		///< Relative tolerance.
+		double			absTol;		///< Absolute tolerance.
+		double			maxDt;		///< Maximum time step in s.
+		double			error;		///< Maximum outlet error relative to the feed concentration.
+		double			wallTime;	///< Wall time of the run in s (minimum of all repeats).
+		long int		steps;		///< Number of integrator steps (ENGINE_CVODE only, 0 otherwise).
+		bool			failed;		///< True if the run failed.
+		std::string		errmsg;		///< Error message of a failed run.
+	};
+
+	/// Constructor.
+	/// @param threads Number of concurrent solver runs, 0 means number of cores.
+	WorkPrecision(unsigned int threads = 0);
+
+	/// Runs the reference simulation and all sweep points for the given input.
+	/// Sweep lists that are empty use the value of the input. Throws an IBK::Exception if the input
+	/// is not suitable or the reference run fails, failed sweep points are only marked.
+	void run(const SolverInput & input);
+
+	/// Returns the index of the fastest sweep point with an error not exceeding maxError, -1 if
+	/// no sweep point is accurate enough.
+	int recommendation(double maxError) const;
+
+	/// Writes the sweep points as table (tab separated, header lines start with '#').
+	void writeTable(std::ostream & out) const;
+
+	/// Writes a gnuplot script that plots error over wall time (work-precision diagram) of the
+	/// table in dataFile into a PNG file, with maxError as horizontal line.
+	void writeGnuplot(std::ostream & out, const std::string & dataFile, const std::string & pngFile,
+					  double maxError) const;
+
+	/// Returns the input of the given sweep point.
+	SolverInput pointInput(unsigned int i) const;
+
+	std::vector<unsigned int>	m_n;		///< Number of elements to sweep.
+	std::vector<double>			m_relTol;	///< Relative tolerances to sweep.
+	std::vector<double>			m_absTol;	///< Absolute tolerances to sweep.
+	std::vector<double>			m_maxDt;	///< Maximum time steps in s to sweep.
+
+	unsigned int		m_referenceRefinement;	///< Grid refinement of the reference run relative to the finest sweep grid.
+	double				m_referenceTolFactor;	///< Tolerance factor of the reference run relative to the tightest sweep tolerances.
+	unsigned int		m_repeats;				///< Number of runs per sweep point (the fastest counts).
+
+	std::vector<Point>	m_points;				///< Results of the last run.
+	double				m_referenceWallTime;	///< Wall time of the reference run in s.
+
+private:
+	/// Simulates input and returns the outlet concentrations (output time points) and the wall time in s.
+	/// Throws an IBK::Exception if the run fails.
+	static void simulate(const SolverInput & input, std::vector<double> & outletC, double & wallTime, long int & steps);
+
+	unsigned int			m_threads;		///< Number of concurrent solver runs.
+	SolverInput				m_input;		///< Base input (outputs, breakthrough stop and parallel-in-time disabled).
+	std::vector<double>		m_referenceC;	///< Outlet concentrations of the reference run.
+	double					m_cFeed;		///< Feed concentration used to scale the errors.
+};
+
+#endif // workprecision_h
@@ -0,0 +1,132 @@
+/// Checks that Solver::restoreCheckpoint() rejects inputs that change the solution up to the checkpoint
+/// (inlet concentration series and constant inlet concentration) and continues runs with unchanged input,
+/// with the same outlet series as an uninterrupted run. Returns EXIT_SUCCESS if all checks pass.
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <IBK_Exception.h>
+
+#include "solver.h"
+#include "solverinput.h"
+
+static const char * const CHECKPOINT_FILE = "checkpointtest.chk";
+
+/// Maximum deviation of the outlet concentrations of a continued run from those of the uninterrupted run,
+/// relative to the maximum outlet concentration. The restored CVODE state continues the same integration,
+/// deviations stay at round-off level and far below the integrator tolerance (relTol = 1e-5).
+static const double OUTLET_TOLERANCE = 1e-9;
+
+/// Input of a short break-through run with the inlet concentration series c (values at 0, 10 and 40 h).
+static SolverInput testInput(double c, double tEnd) {
+	SolverInput input;
+	input.model = SolverInput::DIFF_CONV_PARTITION;
+	input.n = 50;
+	input.A = 1;
+	input.L = 0.3;
+	input.q = 0.1;
+	input.p = 0.2;
+	input.v = 0.5;
+	input.D = 1e-6;
+	input.Rc = 1000;
+	input.muc = input.gammac = 0;
+	input.Rs = 1000;
+	input.mus = input.gammas = input.beta = 0;
+	input.cInlet = 71;
+	input.tEnd = tEnd;
+	input.maxDt = 300;
+	input.minDt = 1e-12;
+	double t[] = { 0, 10, 40 };
+	double cIn[] = { c, c, c };
+	input.cInletData.setValues(std::vector<double>(t, t + 3), std::vector<double>(cIn, cIn + 3));
+	return input;
+}
+
+/// Restores the checkpoint for input, returns true if the checkpoint was accepted.
+/// If solver is given, the continued run is kept there.
+static bool restore(const SolverInput & input, Solver * solver = nullptr) {
+	Solver localSolver;
+	if (solver == nullptr)
+		solver = &localSolver;
+	solver->init(input);
+	try {
+		solver->restoreCheckpoint(CHECKPOINT_FILE);
+		solver->run();
+	}
+	catch (IBK::Exception & ex) {
+		std::cout << "    rejected: " << ex.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/// Returns true if the outlet series of the continued run matches that of the uninterrupted run
+/// (same time points, concentrations within OUTLET_TOLERANCE).
+static bool sameOutlet(const Solver & continued, const Solver & uninterrupted) {
+	if (continued.m_outletT.size() != uninterrupted.m_outletT.size()) {
+		std::cout << "    " << continued.m_outletT.size() << " instead of " << uninterrupted.m_outletT.size()
+				  << " outputs" << std::endl;
+		return false;
+	}
+	double maxC = 0;
+	double maxDev = 0;
+	for (unsigned int i=0; i<uninterrupted.m_outletC.size(); ++i) {
+		if (std::fabs(continued.m_outletT[i] - uninterrupted.m_outletT[i]) > 1e-10) {
+			std::cout << "    output " << i << " at " << continued.m_outletT[i] << " h instead of "
+					  << uninterrupted.m_outletT[i] << " h" << std::endl;
+			return false;
+		}
+		maxC = std::max(maxC, uninterrupted.m_outletC[i]);
+		maxDev = std::max(maxDev, std::fabs(continued.m_outletC[i] - uninterrupted.m_outletC[i]));
+	}
+	std::cout << "    maximum deviation " << maxDev << " kg/m3 (maximum outlet concentration " << maxC << " kg/m3)" << std::endl;
+	return maxC > 0 && maxDev <= OUTLET_TOLERANCE*maxC;
+}
+
+/// Prints the result of a check and counts failures.
+static void check(bool passed, const std::string & name, unsigned int & failures) {
+	std::cout << (passed ? "passed: " : "FAILED: ") << name << std::endl;
+	if (!passed)
+		++failures;
+}
+
+int main() {
+	unsigned int failures = 0;
+	try {
+		// checkpoint at the end of a run over the first 5 h
+		Solver solver;
+		solver.init(testInput(1, 5*3600));
+		solver.setCheckpoints(CHECKPOINT_FILE, 0);
+		solver.run();
+
+		Solver continued;
+		bool accepted = restore(testInput(1, 10*3600), &continued);
+		check(accepted, "unchanged inlet series is continued", failures);
+		if (accepted) {
+			Solver uninterrupted;
+			uninterrupted.init(testInput(1, 10*3600));
+			uninterrupted.run();
+			check(sameOutlet(continued, uninterrupted), "continued run matches the uninterrupted run", failures);
+		}
+		check(!restore(testInput(5, 10*3600)), "other inlet series is rejected", failures);
+
+		SolverInput constantInlet = testInput(1, 10*3600);
+		constantInlet.cInlet = 50;
+		check(!restore(constantInlet), "other constant inlet concentration is rejected", failures);
+
+		SolverInput withoutSeries = testInput(1, 10*3600);
+		withoutSeries.cInletData.clear();
+		check(!restore(withoutSeries), "removed inlet series is rejected", failures);
+	}
+	catch (IBK::Exception & ex) {
+		std::cout << "FAILED: " << ex.what() << std::endl;
+		++failures;
+	}
+	std::remove(CHECKPOINT_FILE);
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
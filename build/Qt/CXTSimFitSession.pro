@@ -1,6 +1,10 @@
 TEMPLATE = subdirs
 
 SUBDIRS = CXTSimFit \
+		  CXTSimFitBench \
+		  CXTSimFitRun \
+		  CXTSimFitImportBench \
+		  CXTSimFitCheckpointTest \
 		  IBK \
 		  sundials \
 		  levmar \
@@ -8,9 +12,17 @@ SUBDIRS = CXTSimFit \
 
 	# where to find the sub projects
 CXTSimFit.file = ../../CXTSimFit/projects/Qt/CXTSimFit.pro
+CXTSimFitBench.file = ../../CXTSimFit/projects/Qt/CXTSimFitBench.pro
+CXTSimFitRun.file = ../../CXTSimFit/projects/Qt/CXTSimFitRun.pro
+CXTSimFitImportBench.file = ../../CXTSimFit/projects/Qt/CXTSimFitImportBench.pro
+CXTSimFitCheckpointTest.file = ../../CXTSimFit/projects/Qt/CXTSimFitCheckpointTest.pro
 IBK.file = ../../externals/IBK/projects/Qt/IBK.pro
 QNANChartWidget.file = ../../externals/QNANChartWidget/projects/Qt/QNANChartWidget.pro
 levmar.file = ../../externals/levmar/projects/Qt/levmar.pro
 sundials.file = ../../externals/sundials/projects/Qt/sundials.pro
 
 CXTSimFit.depends = IBK QNANChartWidget levmar sundials
+CXTSimFitBench.depends = IBK sundials
+CXTSimFitRun.depends = IBK sundials
+CXTSimFitImportBench.depends = IBK
+CXTSimFitCheckpointTest.depends = IBK sundials
@@ -26,6 +26,8 @@ INCLUDEPATH += \
 	../../src/src/cvode \
 	../../src/src/kinsol \
 	../../src/src/nvec_ser \
+	../../src/src/nvec_openmp \
+	../../src/src/nvec_simd \
 	../../../SuiteSparse/src/include
 
 HEADERS += \
@@ -69,7 +71,19 @@ HEADERS += \
 	../../src/src/cvode/cvode_impl.h \
 	../../src/src/cvode/cvode_spils_impl.h \
 	../../src/include/nvector/nvector_serial.h \
-	../../src/include/cvode/cvode_klu.h
+	../../src/include/nvector/nvector_openmp.h \
+	../../src/include/nvector/nvector_simd.h \
+	../../src/include/cvode/cvode_klu.h \
+	../../src/include/kinsol/kinsol.h \
+	../../src/include/kinsol/kinsol_band.h \
+	../../src/include/kinsol/kinsol_bbdpre.h \
+	../../src/include/kinsol/kinsol_dense.h \
+	../../src/include/kinsol/kinsol_direct.h \
+	../../src/include/kinsol/kinsol_spbcgs.h \
+	../../src/include/kinsol/kinsol_spfgmr.h \
+	../../src/include/kinsol/kinsol_spgmr.h \
+	../../src/include/kinsol/kinsol_spils.h \
+	../../src/include/kinsol/kinsol_sptfqmr.h
 
 SOURCES += \
 	../../src/src/cvode/cvode_band.c \
@@ -87,6 +101,7 @@ SOURCES += \
 	../../src/src/cvode/cvode_spils.c \
 	../../src/src/cvode/cvode_sptfqmr.c \
 	../../src/src/nvec_ser/nvector_serial.c \
+	../../src/src/nvec_simd/nvector_simd.c \
 	../../src/src/sundials/sundials_band.c \
 	../../src/src/sundials/sundials_btridiag.c \
 	../../src/src/sundials/sundials_dense.c \
@@ -101,29 +116,47 @@ SOURCES += \
 	../../src/src/sundials/sundials_timer.c \
 	../../src/src/sundials/sundials_sparse.c \
 	../../src/src/sundials/sundials_spfgmr.c \
-	../../src/src/cvode/cvode_sparse.c
-
-contains( OPTIONS, kinsol ) {
-	message(Enabling KINSOL in Sundials)
-SOURCES += \
+	../../src/src/cvode/cvode_sparse.c \
 	../../src/src/kinsol/kinsol.c \
 	../../src/src/kinsol/kinsol_band.c \
 	../../src/src/kinsol/kinsol_bbdpre.c \
 	../../src/src/kinsol/kinsol_dense.c \
 	../../src/src/kinsol/kinsol_direct.c \
 	../../src/src/kinsol/kinsol_io.c \
-	../../src/src/kinsol/kinsol_klu.c \
-	../../src/src/kinsol/kinsol_sparse.c \
 	../../src/src/kinsol/kinsol_spbcgs.c \
 	../../src/src/kinsol/kinsol_spfgmr.c \
 	../../src/src/kinsol/kinsol_spgmr.c \
 	../../src/src/kinsol/kinsol_spils.c \
-	../../src/src/kinsol/kinsol_sptfqmr.c \
+	../../src/src/kinsol/kinsol_sptfqmr.c
+
+# threaded vector of Solver::newVector(), only built with OpenMP (the pragmas would be unknown otherwise)
+contains( OPTIONS, openmp ) {
+SOURCES += \
+	../../src/src/nvec_openmp/nvector_openmp.c
+}
+
+# sparse direct solvers (KLU) of CVODE and KINSOL
+contains( OPTIONS, kinsol ) {
+	message(Enabling KLU solvers in Sundials)
+SOURCES += \
+	../../src/src/kinsol/kinsol_klu.c \
+	../../src/src/kinsol/kinsol_sparse.c \
 	../../src/src/cvode/cvode_klu.c
 
 LIBS += -lSuiteSparse
 }
 
+# AVX kernels of the SIMD vector (nvector_simd.c), the binaries require a CPU with AVX2 and FMA
+contains( OPTIONS, avx ) {
+	message(Enabling AVX kernels in Sundials)
+	win32-msvc* {
+		QMAKE_CFLAGS += /arch:AVX2
+	}
+	else {
+		QMAKE_CFLAGS += -mavx2 -mfma
+	}
+}
+
 contains( OPTIONS, lapack ) {
 		SOURCES +=
 	message(Enabling Lapack in Sundials)
@@ -0,0 +1,273 @@
+/*
+ * -----------------------------------------------------------------
+ * Acknowledgements: This NVECTOR module is based on the NVECTOR
+ *                   Serial module by Scott D. Cohen, Alan C.
+ *                   Hindmarsh, Radu Serban, and Aaron Collier
+ *                   @ LLNL
+ * -----------------------------------------------------------------
+ * LLNS Copyright Start
+ * Copyright (c) 2014, Lawrence Livermore National Security
+ * This work was performed under the auspices of the U.S. Department
+ * of Energy by Lawrence Livermore National Laboratory in part under
+ * Contract W-7405-Eng-48 and in part under Contract DE-AC52-07NA27344.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * All rights reserved.
+ * For details, see the LICENSE file.
+ * LLNS Copyright End
+ * -----------------------------------------------------------------
+ * This is the header file for the SIMD implementation of the
+ * NVECTOR module, a serial vector with
+ *
+ *   - data arrays aligned to NV_SIMD_ALIGNMENT bytes (cache line),
+ *   - a pool of data arrays shared by a vector and all its clones,
+ *     so that destroying and re-cloning vectors (e.g. when an
+ *     integrator is re-initialized) does not allocate memory,
+ *   - AVX kernels for the frequently used operations (FMA if
+ *     available), selected at compile time with -mavx/-mfma or
+ *     -march=native; without AVX the scalar loops are used,
+ *   - the fused operations N_VLinearCombination, N_VScaleAddMulti
+ *     and N_VLinearSumWrmsNorm, that need a single pass over the
+ *     vector data.
+ *
+ * Part I contains declarations specific to the SIMD
+ * implementation of the supplied NVECTOR module.
+ *
+ * Part II defines accessor macros that allow the user to
+ * efficiently use the type N_Vector without making explicit
+ * references to the underlying data structure.
+ *
+ * Part III contains the prototype for the constructor N_VNew_Simd
+ * as well as implementation-specific prototypes for various useful
+ * vector operations.
+ *
+ * Notes:
+ *
+ *   - The vector type ID is SUNDIALS_NVEC_CUSTOM.
+ *
+ *   - A vector and its clones share the pool of data arrays. The
+ *     pool is not protected by a lock, so vectors of the same
+ *     pool must not be created or destroyed concurrently by
+ *     different threads.
+ *
+ *   - N_Vector arguments to arithmetic vector operations need not
+ *     be distinct, except for the restrictions of the fused
+ *     operations documented in sundials_nvector.h.
+ * -----------------------------------------------------------------
+ */
+
+#ifndef _NVECTOR_SIMD_H
+#define _NVECTOR_SIMD_H
+
+#include <sundials/sundials_nvector.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+/*
+ * -----------------------------------------------------------------
+ * PART I: SIMD implementation of N_Vector
+ * -----------------------------------------------------------------
+ */
+
+/* alignment of the data arrays in bytes */
+#define NV_SIMD_ALIGNMENT 64
+
+/* maximum number of unused data arrays kept in a pool */
+#define NV_SIMD_POOL_SIZE 32
+
+/* pool of data arrays shared by a vector and its clones, the
+   pool is released when the last of its vectors is destroyed */
+
+struct _N_VectorPool_Simd {
+  long int length;
+  int refcount;
+  int nfree;
+  realtype *free_data[NV_SIMD_POOL_SIZE];
+};
+
+typedef struct _N_VectorPool_Simd *N_VectorPool_Simd;
+
+/* SIMD implementation of the N_Vector 'content' structure
+   contains the length of the vector, a pointer to an array
+   of 'realtype' components, a flag indicating ownership of
+   the data and the pool the data is taken from; the first three
+   members match the serial content (see SerializeNVector) */
+
+struct _N_VectorContent_Simd {
+  long int length;
+  booleantype own_data;
+  realtype *data;
+  N_VectorPool_Simd pool;
+};
+
+typedef struct _N_VectorContent_Simd *N_VectorContent_Simd;
+
+/*
+ * -----------------------------------------------------------------
+ * PART II: macros NV_CONTENT_SIMD, NV_DATA_SIMD, NV_OWN_DATA_SIMD,
+ *          NV_LENGTH_SIMD, and NV_Ith_SIMD
+ * -----------------------------------------------------------------
+ * The macros have the same meaning as the corresponding macros
+ * of the serial NVECTOR module (see nvector_serial.h).
+ * -----------------------------------------------------------------
+ */
+
+#define NV_CONTENT_SIMD(v)  ( (N_VectorContent_Simd)(v->content) )
+
+#define NV_LENGTH_SIMD(v)   ( NV_CONTENT_SIMD(v)->length )
+
+#define NV_OWN_DATA_SIMD(v) ( NV_CONTENT_SIMD(v)->own_data )
+
+#define NV_DATA_SIMD(v)     ( NV_CONTENT_SIMD(v)->data )
+
+#define NV_Ith_SIMD(v,i)    ( NV_DATA_SIMD(v)[i] )
+
+/*
+ * -----------------------------------------------------------------
+ * PART III: functions exported by nvector_simd
+ *
+ * CONSTRUCTORS:
+ *    N_VNew_Simd
+ *    N_VNewEmpty_Simd
+ *    N_VMake_Simd
+ *    N_VCloneVectorArray_Simd
+ *    N_VCloneVectorArrayEmpty_Simd
+ * DESTRUCTORS:
+ *    N_VDestroy_Simd
+ *    N_VDestroyVectorArray_Simd
+ * OTHER:
+ *    N_VGetLength_Simd
+ *    N_VPrint_Simd
+ * -----------------------------------------------------------------
+ */
+
+/*
+ * -----------------------------------------------------------------
+ * Function : N_VNew_Simd
+ * -----------------------------------------------------------------
+ * This function creates and allocates memory for a SIMD vector
+ * with a new pool of aligned data arrays.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT N_Vector N_VNew_Simd(long int vec_length);
+
+/*
+ * -----------------------------------------------------------------
+ * Function : N_VNewEmpty_Simd
+ * -----------------------------------------------------------------
+ * This function creates a new SIMD N_Vector with an empty (NULL)
+ * data array.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT N_Vector N_VNewEmpty_Simd(long int vec_length);
+
+/*
+ * -----------------------------------------------------------------
+ * Function : N_VMake_Simd
+ * -----------------------------------------------------------------
+ * This function creates a SIMD vector with a user-supplied data
+ * array. The array need not be aligned, clones of the vector use
+ * aligned arrays, though.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT N_Vector N_VMake_Simd(long int vec_length, realtype *v_data);
+
+/*
+ * -----------------------------------------------------------------
+ * Function : N_VCloneVectorArray_Simd
+ * -----------------------------------------------------------------
+ * This function creates an array of 'count' SIMD vectors by
+ * cloning a given vector w.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT N_Vector *N_VCloneVectorArray_Simd(int count, N_Vector w);
+
+/*
+ * -----------------------------------------------------------------
+ * Function : N_VCloneVectorArrayEmpty_Simd
+ * -----------------------------------------------------------------
+ * This function creates an array of 'count' SIMD vectors each
+ * with an empty (NULL) data array by cloning w.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT N_Vector *N_VCloneVectorArrayEmpty_Simd(int count, N_Vector w);
+
+/*
+ * -----------------------------------------------------------------
+ * Function : N_VDestroyVectorArray_Simd
+ * -----------------------------------------------------------------
+ * This function frees an array of SIMD vectors created with
+ * N_VCloneVectorArray_Simd or N_VCloneVectorArrayEmpty_Simd.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT void N_VDestroyVectorArray_Simd(N_Vector *vs, int count);
+
+/*
+ * -----------------------------------------------------------------
+ * Function : N_VGetLength_Simd
+ * -----------------------------------------------------------------
+ * This function returns number of vector elements.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT long int N_VGetLength_Simd(N_Vector v);
+
+/*
+ * -----------------------------------------------------------------
+ * Function : N_VPrint_Simd
+ * -----------------------------------------------------------------
+ * This function prints the content of a SIMD vector to stdout.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT void N_VPrint_Simd(N_Vector v);
+
+/*
+ * -----------------------------------------------------------------
+ * SIMD implementations of various useful vector operations
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT N_Vector_ID N_VGetVectorID_Simd(N_Vector v);
+SUNDIALS_EXPORT N_Vector N_VCloneEmpty_Simd(N_Vector w);
+SUNDIALS_EXPORT N_Vector N_VClone_Simd(N_Vector w);
+SUNDIALS_EXPORT void N_VDestroy_Simd(N_Vector v);
+SUNDIALS_EXPORT void N_VSpace_Simd(N_Vector v, long int *lrw, long int *liw);
+SUNDIALS_EXPORT realtype *N_VGetArrayPointer_Simd(N_Vector v);
+SUNDIALS_EXPORT void N_VSetArrayPointer_Simd(realtype *v_data, N_Vector v);
+SUNDIALS_EXPORT void N_VLinearSum_Simd(realtype a, N_Vector x, realtype b, N_Vector y, N_Vector z);
+SUNDIALS_EXPORT void N_VConst_Simd(realtype c, N_Vector z);
+SUNDIALS_EXPORT void N_VProd_Simd(N_Vector x, N_Vector y, N_Vector z);
+SUNDIALS_EXPORT void N_VDiv_Simd(N_Vector x, N_Vector y, N_Vector z);
+SUNDIALS_EXPORT void N_VScale_Simd(realtype c, N_Vector x, N_Vector z);
+SUNDIALS_EXPORT void N_VAbs_Simd(N_Vector x, N_Vector z);
+SUNDIALS_EXPORT void N_VInv_Simd(N_Vector x, N_Vector z);
+SUNDIALS_EXPORT void N_VAddConst_Simd(N_Vector x, realtype b, N_Vector z);
+SUNDIALS_EXPORT realtype N_VDotProd_Simd(N_Vector x, N_Vector y);
+SUNDIALS_EXPORT realtype N_VMaxNorm_Simd(N_Vector x);
+SUNDIALS_EXPORT realtype N_VWrmsNorm_Simd(N_Vector x, N_Vector w);
+SUNDIALS_EXPORT realtype N_VWrmsNormMask_Simd(N_Vector x, N_Vector w, N_Vector id);
+SUNDIALS_EXPORT realtype N_VMin_Simd(N_Vector x);
+SUNDIALS_EXPORT realtype N_VWL2Norm_Simd(N_Vector x, N_Vector w);
+SUNDIALS_EXPORT realtype N_VL1Norm_Simd(N_Vector x);
+SUNDIALS_EXPORT void N_VCompare_Simd(realtype c, N_Vector x, N_Vector z);
+SUNDIALS_EXPORT booleantype N_VInvTest_Simd(N_Vector x, N_Vector z);
+SUNDIALS_EXPORT booleantype N_VConstrMask_Simd(N_Vector c, N_Vector x, N_Vector m);
+SUNDIALS_EXPORT realtype N_VMinQuotient_Simd(N_Vector num, N_Vector denom);
+SUNDIALS_EXPORT void N_VLinearCombination_Simd(int nvec, realtype *c, N_Vector *X, N_Vector z);
+SUNDIALS_EXPORT void N_VScaleAddMulti_Simd(int nvec, realtype *a, N_Vector x, N_Vector *Y, N_Vector *Z);
+SUNDIALS_EXPORT realtype N_VLinearSumWrmsNorm_Simd(realtype a, N_Vector x, realtype b, N_Vector y,
+                                                   N_Vector z, N_Vector w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -114,6 +114,10 @@ struct _generic_N_Vector_Ops {
   booleantype (*nvinvtest)(N_Vector, N_Vector);
   booleantype (*nvconstrmask)(N_Vector, N_Vector, N_Vector);
   realtype    (*nvminquotient)(N_Vector, N_Vector);
+  /* optional fused operations, may be NULL (see N_VLinearCombination) */
+  void        (*nvlinearcombination)(int, realtype*, N_Vector*, N_Vector);
+  void        (*nvscaleaddmulti)(int, realtype*, N_Vector, N_Vector*, N_Vector*);
+  realtype    (*nvlinearsumwrmsnorm)(realtype, N_Vector, realtype, N_Vector, N_Vector, N_Vector);
 };
 
 /*
@@ -270,6 +274,27 @@ struct _generic_N_Vector {
  *   then the large value BIG_REAL is returned.
  *
  * -----------------------------------------------------------------
+ * Fused operations
+ *   The following operations combine several of the operations
+ *   above into a single pass over the vector data. An
+ *   implementation may leave the corresponding function pointers
+ *   NULL, then the generic routines fall back to the separate
+ *   operations.
+ *
+ * N_VLinearCombination
+ *   Performs the operation z = sum_{i=0}^{nvec-1} c[i]*X[i].
+ *   z may be identical to X[0], but not to any other X[i].
+ *
+ * N_VScaleAddMulti
+ *   Performs the operations Z[j] = a[j]*x + Y[j] for
+ *   j = 0, ..., nvec-1. Z[j] may be identical to Y[j].
+ *
+ * N_VLinearSumWrmsNorm
+ *   Performs the operation z = a*x + b*y and returns the
+ *   weighted root mean square norm of z with weight vector w.
+ *   z may be identical to x or y.
+ *
+ * -----------------------------------------------------------------
  *
  * The following table lists the vector functions used by
  * different modules in SUNDIALS. The symbols in the table
@@ -340,6 +365,12 @@ struct _generic_N_Vector {
  * -----------------------------------------------------------------
  * N_VMinQuotient                           S               S
  * -----------------------------------------------------------------
+ * N_VLinearCombination S
+ * -----------------------------------------------------------------
+ * N_VScaleAddMulti   S
+ * -----------------------------------------------------------------
+ * N_VLinearSumWrmsNorm S
+ * -----------------------------------------------------------------
  */
 
 SUNDIALS_EXPORT N_Vector_ID N_VGetVectorID(N_Vector w);
@@ -368,6 +399,10 @@ SUNDIALS_EXPORT void N_VCompare(realtype c, N_Vector x, N_Vector z);
 SUNDIALS_EXPORT booleantype N_VInvTest(N_Vector x, N_Vector z);
 SUNDIALS_EXPORT booleantype N_VConstrMask(N_Vector c, N_Vector x, N_Vector m);
 SUNDIALS_EXPORT realtype N_VMinQuotient(N_Vector num, N_Vector denom);
+SUNDIALS_EXPORT void N_VLinearCombination(int nvec, realtype *c, N_Vector *X, N_Vector z);
+SUNDIALS_EXPORT void N_VScaleAddMulti(int nvec, realtype *a, N_Vector x, N_Vector *Y, N_Vector *Z);
+SUNDIALS_EXPORT realtype N_VLinearSumWrmsNorm(realtype a, N_Vector x, realtype b, N_Vector y,
+                                              N_Vector z, N_Vector w);
 
 /*
  * -----------------------------------------------------------------
@@ -278,6 +278,7 @@ static void cvDecreaseBDF(CVodeMem cv_mem);
 static void cvRescale(CVodeMem cv_mem);
 
 static void cvPredict(CVodeMem cv_mem);
+static void cvPascalCombination(CVodeMem cv_mem, realtype sign);
 
 static void cvSet(CVodeMem cv_mem);
 static void cvSetAdams(CVodeMem cv_mem);
@@ -2297,11 +2298,42 @@ static void cvPredict(CVodeMem cv_mem)
   if (tstopset) {
     if ((tn - tstop)*h > ZERO) tn = tstop;
   }
+  if (zn[0]->ops->nvlinearcombination != NULL) {
+    cvPascalCombination(cv_mem, ONE);
+    return;
+  }
   for (k = 1; k <= q; k++)
     for (j = q; j >= k; j--)
       N_VLinearSum(ONE, zn[j-1], ONE, zn[j], zn[j-1]);
 }
 
+/*
+ * cvPascalCombination
+ *
+ * This routine multiplies the Nordsieck array zn by the Pascal
+ * matrix (sign = ONE, prediction) or by its inverse (sign = -ONE,
+ * restore) with one fused linear combination per column:
+ *   zn[j] = sum_{i=j}^{q} sign^(i-j) * C(i,j) * zn[i],  j = 0,...,q-1.
+ * The columns are updated in increasing order, so zn[j] is only
+ * overwritten after it was used for all lower columns. The
+ * result is the same as with the repeated pairwise sums in
+ * cvPredict and cvRestore, except for rounding.
+ */
+
+static void cvPascalCombination(CVodeMem cv_mem, realtype sign)
+{
+  int i, j;
+  realtype cvals[L_MAX];
+
+  for (j = 0; j < q; j++) {
+    /* binomial coefficients C(i,j) of column j, exact for q <= 12 */
+    cvals[0] = ONE;
+    for (i = j+1; i <= q; i++)
+      cvals[i-j] = sign * cvals[i-j-1] * i / (i-j);
+    N_VLinearCombination(q-j+1, cvals, zn+j, zn[j]);
+  }
+}
+
 /*
  * cvSet
  *
@@ -2617,8 +2649,7 @@ static int cvNlsFunctional(CVodeMem cv_mem)
     N_VScale(rl1, tempv, tempv);
     N_VLinearSum(ONE, zn[0], ONE, tempv, y);
     /* Get WRMS norm of current correction to use in convergence test */
-    N_VLinearSum(ONE, tempv, -ONE, acor, acor);
-    del = N_VWrmsNorm(acor, ewt);
+    del = N_VLinearSumWrmsNorm(ONE, tempv, -ONE, acor, acor, ewt);
     N_VScale(ONE, tempv, acor);
 
     /* Test for convergence.  If m > 0, an estimate of the convergence
@@ -2960,6 +2991,10 @@ static void cvRestore(CVodeMem cv_mem, realtype saved_t)
   int j, k;
 
   tn = saved_t;
+  if (zn[0]->ops->nvlinearcombination != NULL) {
+    cvPascalCombination(cv_mem, -ONE);
+    return;
+  }
   for (k = 1; k <= q; k++)
     for (j = q; j >= k; j--)
       N_VLinearSum(ONE, zn[j-1], -ONE, zn[j], zn[j-1]);
@@ -3073,7 +3108,7 @@ static booleantype cvDoErrorTest(CVodeMem cv_mem, int *nflagPtr,
 
 static void cvCompleteStep(CVodeMem cv_mem)
 {
-  int i, j;
+  int i;
 
   nst++;
   nscon++;
@@ -3084,9 +3119,8 @@ static void cvCompleteStep(CVodeMem cv_mem)
   if ((q==1) && (nst > 1)) tau[2] = tau[1];
   tau[1] = h;
 
-  /* Apply correction to column j of zn: l_j * Delta_n */
-  for (j=0; j <= q; j++)
-    N_VLinearSum(l[j], acor, ONE, zn[j], zn[j]);
+  /* Apply correction to all columns j of zn: l_j * Delta_n */
+  N_VScaleAddMulti(q+1, l, acor, zn, zn);
   qwait--;
   if ((qwait == 1) && (q != qmax)) {
     N_VScale(ONE, acor, zn[qmax]);
@@ -3193,8 +3227,7 @@ static realtype cvComputeEtaqp1(CVodeMem cv_mem)
   if (q != qmax) {
     if (saved_tq5 == ZERO) return(etaqp1);
     cquot = (tq[5] / saved_tq5) * SUNRpowerI(h/tau[2], L);
-    N_VLinearSum(-cquot, zn[qmax], ONE, acor, tempv);
-    dup = N_VWrmsNorm(tempv, ewt) * tq[3];
+    dup = N_VLinearSumWrmsNorm(-cquot, zn[qmax], ONE, acor, tempv, ewt) * tq[3];
     etaqp1 = ONE / (SUNRpowerR(BIAS3*dup, ONE/(L+1)) + ADDON);
   }
   return(etaqp1);
@@ -0,0 +1,1076 @@
+/*
+ * -----------------------------------------------------------------
+ * Acknowledgements: This NVECTOR module is based on the NVECTOR
+ *                   Serial module by Scott D. Cohen, Alan C.
+ *                   Hindmarsh, Radu Serban, and Aaron Collier
+ *                   @ LLNL
+ * -----------------------------------------------------------------
+ * LLNS Copyright Start
+ * Copyright (c) 2014, Lawrence Livermore National Security
+ * This work was performed under the auspices of the U.S. Department
+ * of Energy by Lawrence Livermore National Laboratory in part under
+ * Contract W-7405-Eng-48 and in part under Contract DE-AC52-07NA27344.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * All rights reserved.
+ * For details, see the LICENSE file.
+ * LLNS Copyright End
+ * -----------------------------------------------------------------
+ * This is the implementation file for the SIMD implementation
+ * of the NVECTOR package.
+ *
+ * The AVX kernels process 4 doubles per instruction, the remaining
+ * elements are handled by the scalar loop following each kernel.
+ * Unaligned loads/stores are used, since vectors created with
+ * N_VMake_Simd may hold user arrays; on aligned addresses they are
+ * as fast as the aligned instructions.
+ * -----------------------------------------------------------------
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L /* posix_memalign */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#include <nvector/nvector_simd.h>
+#include <sundials/sundials_math.h>
+
+#if defined(__AVX__) && defined(SUNDIALS_DOUBLE_PRECISION)
+#include <immintrin.h>
+#define NV_SIMD_AVX
+/* number of doubles per register */
+#define VW 4
+#if defined(__FMA__)
+#define VFMADD(a,b,c) _mm256_fmadd_pd(a,b,c)
+#else
+#define VFMADD(a,b,c) _mm256_add_pd(_mm256_mul_pd(a,b),c)
+#endif
+#endif
+
+#define ZERO   RCONST(0.0)
+#define HALF   RCONST(0.5)
+#define ONE    RCONST(1.0)
+#define ONEPT5 RCONST(1.5)
+
+/* maximum number of vectors processed together by the fused
+   operations, larger counts are processed in blocks */
+#define NV_SIMD_MAXVEC 16
+
+/* Private function prototypes */
+/* aligned allocation */
+static realtype *VAlloc_Simd(long int length);
+static void VFree_Simd(realtype *data);
+/* new pool with reference count 1 */
+static N_VectorPool_Simd VPoolNew_Simd(long int length);
+/* decrements the reference count, frees the pool if unused */
+static void VPoolRelease_Simd(N_VectorPool_Simd pool);
+/* takes an array from the pool or allocates a new one */
+static realtype *VPoolGet_Simd(N_VectorPool_Simd pool);
+/* returns an array to the pool */
+static void VPoolPut_Simd(N_VectorPool_Simd pool, realtype *data);
+#if defined(NV_SIMD_AVX)
+/* sum of the elements of a register */
+static realtype VHsum_Simd(__m256d v);
+#endif
+
+/*
+ * -----------------------------------------------------------------
+ * exported functions
+ * -----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ * Returns vector type ID. Used to identify vector implementation
+ * from abstract N_Vector interface.
+ */
+N_Vector_ID N_VGetVectorID_Simd(N_Vector v)
+{
+  return SUNDIALS_NVEC_CUSTOM;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function to create a new empty SIMD vector
+ */
+
+N_Vector N_VNewEmpty_Simd(long int length)
+{
+  N_Vector v;
+  N_Vector_Ops ops;
+  N_VectorContent_Simd content;
+
+  /* Create vector */
+  v = NULL;
+  v = (N_Vector) malloc(sizeof *v);
+  if (v == NULL) return(NULL);
+
+  /* Create vector operation structure */
+  ops = NULL;
+  ops = (N_Vector_Ops) malloc(sizeof(struct _generic_N_Vector_Ops));
+  if (ops == NULL) { free(v); return(NULL); }
+
+  ops->nvgetvectorid     = N_VGetVectorID_Simd;
+  ops->nvclone           = N_VClone_Simd;
+  ops->nvcloneempty      = N_VCloneEmpty_Simd;
+  ops->nvdestroy         = N_VDestroy_Simd;
+  ops->nvspace           = N_VSpace_Simd;
+  ops->nvgetarraypointer = N_VGetArrayPointer_Simd;
+  ops->nvsetarraypointer = N_VSetArrayPointer_Simd;
+  ops->nvlinearsum       = N_VLinearSum_Simd;
+  ops->nvconst           = N_VConst_Simd;
+  ops->nvprod            = N_VProd_Simd;
+  ops->nvdiv             = N_VDiv_Simd;
+  ops->nvscale           = N_VScale_Simd;
+  ops->nvabs             = N_VAbs_Simd;
+  ops->nvinv             = N_VInv_Simd;
+  ops->nvaddconst        = N_VAddConst_Simd;
+  ops->nvdotprod         = N_VDotProd_Simd;
+  ops->nvmaxnorm         = N_VMaxNorm_Simd;
+  ops->nvwrmsnormmask    = N_VWrmsNormMask_Simd;
+  ops->nvwrmsnorm        = N_VWrmsNorm_Simd;
+  ops->nvmin             = N_VMin_Simd;
+  ops->nvwl2norm         = N_VWL2Norm_Simd;
+  ops->nvl1norm          = N_VL1Norm_Simd;
+  ops->nvcompare         = N_VCompare_Simd;
+  ops->nvinvtest         = N_VInvTest_Simd;
+  ops->nvconstrmask      = N_VConstrMask_Simd;
+  ops->nvminquotient     = N_VMinQuotient_Simd;
+  ops->nvlinearcombination = N_VLinearCombination_Simd;
+  ops->nvscaleaddmulti     = N_VScaleAddMulti_Simd;
+  ops->nvlinearsumwrmsnorm = N_VLinearSumWrmsNorm_Simd;
+
+  /* Create content */
+  content = NULL;
+  content = (N_VectorContent_Simd) malloc(sizeof(struct _N_VectorContent_Simd));
+  if (content == NULL) { free(ops); free(v); return(NULL); }
+
+  content->length   = length;
+  content->own_data = FALSE;
+  content->data     = NULL;
+  content->pool     = VPoolNew_Simd(length);
+  if (content->pool == NULL) { free(content); free(ops); free(v); return(NULL); }
+
+  /* Attach content and ops */
+  v->content = content;
+  v->ops     = ops;
+
+  return(v);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function to create a new SIMD vector
+ */
+
+N_Vector N_VNew_Simd(long int length)
+{
+  N_Vector v;
+  realtype *data;
+
+  v = NULL;
+  v = N_VNewEmpty_Simd(length);
+  if (v == NULL) return(NULL);
+
+  /* Create data */
+  if (length > 0) {
+
+    /* Allocate memory */
+    data = VPoolGet_Simd(NV_CONTENT_SIMD(v)->pool);
+    if(data == NULL) { N_VDestroy_Simd(v); return(NULL); }
+
+    /* Attach data */
+    NV_OWN_DATA_SIMD(v) = TRUE;
+    NV_DATA_SIMD(v)     = data;
+
+  }
+
+  return(v);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function to create a SIMD N_Vector with user data component
+ */
+
+N_Vector N_VMake_Simd(long int length, realtype *v_data)
+{
+  N_Vector v;
+
+  v = NULL;
+  v = N_VNewEmpty_Simd(length);
+  if (v == NULL) return(NULL);
+
+  if (length > 0) {
+    /* Attach data */
+    NV_OWN_DATA_SIMD(v) = FALSE;
+    NV_DATA_SIMD(v)     = v_data;
+  }
+
+  return(v);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function to create an array of new SIMD vectors.
+ */
+
+N_Vector *N_VCloneVectorArray_Simd(int count, N_Vector w)
+{
+  N_Vector *vs;
+  int j;
+
+  if (count <= 0) return(NULL);
+
+  vs = NULL;
+  vs = (N_Vector *) malloc(count * sizeof(N_Vector));
+  if(vs == NULL) return(NULL);
+
+  for (j = 0; j < count; j++) {
+    vs[j] = NULL;
+    vs[j] = N_VClone_Simd(w);
+    if (vs[j] == NULL) {
+      N_VDestroyVectorArray_Simd(vs, j-1);
+      return(NULL);
+    }
+  }
+
+  return(vs);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function to create an array of new SIMD vectors with NULL data array.
+ */
+
+N_Vector *N_VCloneVectorArrayEmpty_Simd(int count, N_Vector w)
+{
+  N_Vector *vs;
+  int j;
+
+  if (count <= 0) return(NULL);
+
+  vs = NULL;
+  vs = (N_Vector *) malloc(count * sizeof(N_Vector));
+  if(vs == NULL) return(NULL);
+
+  for (j = 0; j < count; j++) {
+    vs[j] = NULL;
+    vs[j] = N_VCloneEmpty_Simd(w);
+    if (vs[j] == NULL) {
+      N_VDestroyVectorArray_Simd(vs, j-1);
+      return(NULL);
+    }
+  }
+
+  return(vs);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function to free an array created with N_VCloneVectorArray_Simd
+ */
+
+void N_VDestroyVectorArray_Simd(N_Vector *vs, int count)
+{
+  int j;
+
+  for (j = 0; j < count; j++) N_VDestroy_Simd(vs[j]);
+
+  free(vs); vs = NULL;
+
+  return;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function to return number of vector elements
+ */
+long int N_VGetLength_Simd(N_Vector v)
+{
+  return NV_LENGTH_SIMD(v);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Function to print the a SIMD vector
+ */
+
+void N_VPrint_Simd(N_Vector x)
+{
+  long int i, N;
+  realtype *xd;
+
+  xd = NULL;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+
+  for (i = 0; i < N; i++) {
+#if defined(SUNDIALS_EXTENDED_PRECISION)
+    printf("%35.32Lg\n", xd[i]);
+#elif defined(SUNDIALS_DOUBLE_PRECISION)
+    printf("%19.16g\n", xd[i]);
+#else
+    printf("%11.8g\n", xd[i]);
+#endif
+  }
+  printf("\n");
+
+  return;
+}
+
+/*
+ * -----------------------------------------------------------------
+ * implementation of vector operations
+ * -----------------------------------------------------------------
+ */
+
+N_Vector N_VCloneEmpty_Simd(N_Vector w)
+{
+  N_Vector v;
+  N_Vector_Ops ops;
+  N_VectorContent_Simd content;
+
+  if (w == NULL) return(NULL);
+
+  /* Create vector */
+  v = NULL;
+  v = (N_Vector) malloc(sizeof *v);
+  if (v == NULL) return(NULL);
+
+  /* Create vector operation structure */
+  ops = NULL;
+  ops = (N_Vector_Ops) malloc(sizeof(struct _generic_N_Vector_Ops));
+  if (ops == NULL) { free(v); return(NULL); }
+
+  ops->nvgetvectorid     = w->ops->nvgetvectorid;
+  ops->nvclone           = w->ops->nvclone;
+  ops->nvcloneempty      = w->ops->nvcloneempty;
+  ops->nvdestroy         = w->ops->nvdestroy;
+  ops->nvspace           = w->ops->nvspace;
+  ops->nvgetarraypointer = w->ops->nvgetarraypointer;
+  ops->nvsetarraypointer = w->ops->nvsetarraypointer;
+  ops->nvlinearsum       = w->ops->nvlinearsum;
+  ops->nvconst           = w->ops->nvconst;
+  ops->nvprod            = w->ops->nvprod;
+  ops->nvdiv             = w->ops->nvdiv;
+  ops->nvscale           = w->ops->nvscale;
+  ops->nvabs             = w->ops->nvabs;
+  ops->nvinv             = w->ops->nvinv;
+  ops->nvaddconst        = w->ops->nvaddconst;
+  ops->nvdotprod         = w->ops->nvdotprod;
+  ops->nvmaxnorm         = w->ops->nvmaxnorm;
+  ops->nvwrmsnormmask    = w->ops->nvwrmsnormmask;
+  ops->nvwrmsnorm        = w->ops->nvwrmsnorm;
+  ops->nvmin             = w->ops->nvmin;
+  ops->nvwl2norm         = w->ops->nvwl2norm;
+  ops->nvl1norm          = w->ops->nvl1norm;
+  ops->nvcompare         = w->ops->nvcompare;
+  ops->nvinvtest         = w->ops->nvinvtest;
+  ops->nvconstrmask      = w->ops->nvconstrmask;
+  ops->nvminquotient     = w->ops->nvminquotient;
+  ops->nvlinearcombination = w->ops->nvlinearcombination;
+  ops->nvscaleaddmulti     = w->ops->nvscaleaddmulti;
+  ops->nvlinearsumwrmsnorm = w->ops->nvlinearsumwrmsnorm;
+
+  /* Create content */
+  content = NULL;
+  content = (N_VectorContent_Simd) malloc(sizeof(struct _N_VectorContent_Simd));
+  if (content == NULL) { free(ops); free(v); return(NULL); }
+
+  content->length   = NV_LENGTH_SIMD(w);
+  content->own_data = FALSE;
+  content->data     = NULL;
+  /* share the pool of w */
+  content->pool     = NV_CONTENT_SIMD(w)->pool;
+  content->pool->refcount++;
+
+  /* Attach content and ops */
+  v->content = content;
+  v->ops     = ops;
+
+  return(v);
+}
+
+N_Vector N_VClone_Simd(N_Vector w)
+{
+  N_Vector v;
+  realtype *data;
+  long int length;
+
+  v = NULL;
+  v = N_VCloneEmpty_Simd(w);
+  if (v == NULL) return(NULL);
+
+  length = NV_LENGTH_SIMD(w);
+
+  /* Create data */
+  if (length > 0) {
+
+    /* Take memory from the pool */
+    data = VPoolGet_Simd(NV_CONTENT_SIMD(v)->pool);
+    if(data == NULL) { N_VDestroy_Simd(v); return(NULL); }
+
+    /* Attach data */
+    NV_OWN_DATA_SIMD(v) = TRUE;
+    NV_DATA_SIMD(v)     = data;
+
+  }
+
+  return(v);
+}
+
+void N_VDestroy_Simd(N_Vector v)
+{
+  if (NV_OWN_DATA_SIMD(v) == TRUE) {
+    VPoolPut_Simd(NV_CONTENT_SIMD(v)->pool, NV_DATA_SIMD(v));
+    NV_DATA_SIMD(v) = NULL;
+  }
+  VPoolRelease_Simd(NV_CONTENT_SIMD(v)->pool);
+  free(v->content); v->content = NULL;
+  free(v->ops); v->ops = NULL;
+  free(v); v = NULL;
+
+  return;
+}
+
+void N_VSpace_Simd(N_Vector v, long int *lrw, long int *liw)
+{
+  *lrw = NV_LENGTH_SIMD(v);
+  *liw = 1;
+
+  return;
+}
+
+realtype *N_VGetArrayPointer_Simd(N_Vector v)
+{
+  return((realtype *) NV_DATA_SIMD(v));
+}
+
+void N_VSetArrayPointer_Simd(realtype *v_data, N_Vector v)
+{
+  if (NV_LENGTH_SIMD(v) > 0) {
+    /* an own array is returned to the pool, v never releases v_data */
+    if (NV_OWN_DATA_SIMD(v) == TRUE)
+      VPoolPut_Simd(NV_CONTENT_SIMD(v)->pool, NV_DATA_SIMD(v));
+    NV_OWN_DATA_SIMD(v) = FALSE;
+    NV_DATA_SIMD(v) = v_data;
+  }
+
+  return;
+}
+
+void N_VLinearSum_Simd(realtype a, N_Vector x, realtype b, N_Vector y, N_Vector z)
+{
+  long int i, N;
+  realtype *xd, *yd, *zd;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  yd = NV_DATA_SIMD(y);
+  zd = NV_DATA_SIMD(z);
+
+  i = 0;
+#if defined(NV_SIMD_AVX)
+  {
+    __m256d va = _mm256_set1_pd(a);
+    __m256d vb = _mm256_set1_pd(b);
+    for (; i + VW <= N; i += VW)
+      _mm256_storeu_pd(zd+i, VFMADD(va, _mm256_loadu_pd(xd+i),
+                                    _mm256_mul_pd(vb, _mm256_loadu_pd(yd+i))));
+  }
+#endif
+  for (; i < N; i++)
+    zd[i] = (a*xd[i])+(b*yd[i]);
+
+  return;
+}
+
+void N_VConst_Simd(realtype c, N_Vector z)
+{
+  long int i, N;
+  realtype *zd;
+
+  N  = NV_LENGTH_SIMD(z);
+  zd = NV_DATA_SIMD(z);
+
+  i = 0;
+#if defined(NV_SIMD_AVX)
+  {
+    __m256d vc = _mm256_set1_pd(c);
+    for (; i + VW <= N; i += VW)
+      _mm256_storeu_pd(zd+i, vc);
+  }
+#endif
+  for (; i < N; i++) zd[i] = c;
+
+  return;
+}
+
+void N_VProd_Simd(N_Vector x, N_Vector y, N_Vector z)
+{
+  long int i, N;
+  realtype *xd, *yd, *zd;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  yd = NV_DATA_SIMD(y);
+  zd = NV_DATA_SIMD(z);
+
+  i = 0;
+#if defined(NV_SIMD_AVX)
+  for (; i + VW <= N; i += VW)
+    _mm256_storeu_pd(zd+i, _mm256_mul_pd(_mm256_loadu_pd(xd+i), _mm256_loadu_pd(yd+i)));
+#endif
+  for (; i < N; i++)
+    zd[i] = xd[i]*yd[i];
+
+  return;
+}
+
+void N_VDiv_Simd(N_Vector x, N_Vector y, N_Vector z)
+{
+  long int i, N;
+  realtype *xd, *yd, *zd;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  yd = NV_DATA_SIMD(y);
+  zd = NV_DATA_SIMD(z);
+
+  for (i = 0; i < N; i++)
+    zd[i] = xd[i]/yd[i];
+
+  return;
+}
+
+void N_VScale_Simd(realtype c, N_Vector x, N_Vector z)
+{
+  long int i, N;
+  realtype *xd, *zd;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  zd = NV_DATA_SIMD(z);
+
+  i = 0;
+#if defined(NV_SIMD_AVX)
+  {
+    __m256d vc = _mm256_set1_pd(c);
+    for (; i + VW <= N; i += VW)
+      _mm256_storeu_pd(zd+i, _mm256_mul_pd(vc, _mm256_loadu_pd(xd+i)));
+  }
+#endif
+  for (; i < N; i++)
+    zd[i] = c*xd[i];
+
+  return;
+}
+
+void N_VAbs_Simd(N_Vector x, N_Vector z)
+{
+  long int i, N;
+  realtype *xd, *zd;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  zd = NV_DATA_SIMD(z);
+
+  for (i = 0; i < N; i++)
+    zd[i] = SUNRabs(xd[i]);
+
+  return;
+}
+
+void N_VInv_Simd(N_Vector x, N_Vector z)
+{
+  long int i, N;
+  realtype *xd, *zd;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  zd = NV_DATA_SIMD(z);
+
+  for (i = 0; i < N; i++)
+    zd[i] = ONE/xd[i];
+
+  return;
+}
+
+void N_VAddConst_Simd(N_Vector x, realtype b, N_Vector z)
+{
+  long int i, N;
+  realtype *xd, *zd;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  zd = NV_DATA_SIMD(z);
+
+  for (i = 0; i < N; i++)
+    zd[i] = xd[i]+b;
+
+  return;
+}
+
+realtype N_VDotProd_Simd(N_Vector x, N_Vector y)
+{
+  long int i, N;
+  realtype sum, *xd, *yd;
+
+  sum = ZERO;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  yd = NV_DATA_SIMD(y);
+
+  i = 0;
+#if defined(NV_SIMD_AVX)
+  {
+    __m256d vsum = _mm256_setzero_pd();
+    for (; i + VW <= N; i += VW)
+      vsum = VFMADD(_mm256_loadu_pd(xd+i), _mm256_loadu_pd(yd+i), vsum);
+    sum = VHsum_Simd(vsum);
+  }
+#endif
+  for (; i < N; i++)
+    sum += xd[i]*yd[i];
+
+  return(sum);
+}
+
+realtype N_VMaxNorm_Simd(N_Vector x)
+{
+  long int i, N;
+  realtype max, *xd;
+
+  max = ZERO;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+
+  i = 0;
+#if defined(NV_SIMD_AVX)
+  {
+    __m256d vsign = _mm256_set1_pd(-0.0);
+    __m256d vmax = _mm256_setzero_pd();
+    realtype m[VW];
+    int k;
+    for (; i + VW <= N; i += VW)
+      vmax = _mm256_max_pd(vmax, _mm256_andnot_pd(vsign, _mm256_loadu_pd(xd+i)));
+    _mm256_storeu_pd(m, vmax);
+    for (k = 0; k < VW; k++)
+      if (m[k] > max) max = m[k];
+  }
+#endif
+  for (; i < N; i++) {
+    if (SUNRabs(xd[i]) > max) max = SUNRabs(xd[i]);
+  }
+
+  return(max);
+}
+
+realtype N_VWrmsNorm_Simd(N_Vector x, N_Vector w)
+{
+  long int i, N;
+  realtype sum, prodi, *xd, *wd;
+
+  sum = ZERO;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  wd = NV_DATA_SIMD(w);
+
+  i = 0;
+#if defined(NV_SIMD_AVX)
+  {
+    __m256d vsum = _mm256_setzero_pd();
+    __m256d vprod;
+    for (; i + VW <= N; i += VW) {
+      vprod = _mm256_mul_pd(_mm256_loadu_pd(xd+i), _mm256_loadu_pd(wd+i));
+      vsum = VFMADD(vprod, vprod, vsum);
+    }
+    sum = VHsum_Simd(vsum);
+  }
+#endif
+  for (; i < N; i++) {
+    prodi = xd[i]*wd[i];
+    sum += SUNSQR(prodi);
+  }
+
+  return(SUNRsqrt(sum/N));
+}
+
+realtype N_VWrmsNormMask_Simd(N_Vector x, N_Vector w, N_Vector id)
+{
+  long int i, N;
+  realtype sum, prodi, *xd, *wd, *idd;
+
+  sum = ZERO;
+
+  N   = NV_LENGTH_SIMD(x);
+  xd  = NV_DATA_SIMD(x);
+  wd  = NV_DATA_SIMD(w);
+  idd = NV_DATA_SIMD(id);
+
+  for (i = 0; i < N; i++) {
+    if (idd[i] > ZERO) {
+      prodi = xd[i]*wd[i];
+      sum += SUNSQR(prodi);
+    }
+  }
+
+  return(SUNRsqrt(sum / N));
+}
+
+realtype N_VMin_Simd(N_Vector x)
+{
+  long int i, N;
+  realtype min, *xd;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+
+  min = xd[0];
+
+  for (i = 1; i < N; i++) {
+    if (xd[i] < min) min = xd[i];
+  }
+
+  return(min);
+}
+
+realtype N_VWL2Norm_Simd(N_Vector x, N_Vector w)
+{
+  long int i, N;
+  realtype sum, prodi, *xd, *wd;
+
+  sum = ZERO;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  wd = NV_DATA_SIMD(w);
+
+  for (i = 0; i < N; i++) {
+    prodi = xd[i]*wd[i];
+    sum += SUNSQR(prodi);
+  }
+
+  return(SUNRsqrt(sum));
+}
+
+realtype N_VL1Norm_Simd(N_Vector x)
+{
+  long int i, N;
+  realtype sum, *xd;
+
+  sum = ZERO;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+
+  for (i = 0; i<N; i++)
+    sum += SUNRabs(xd[i]);
+
+  return(sum);
+}
+
+void N_VCompare_Simd(realtype c, N_Vector x, N_Vector z)
+{
+  long int i, N;
+  realtype *xd, *zd;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  zd = NV_DATA_SIMD(z);
+
+  for (i = 0; i < N; i++) {
+    zd[i] = (SUNRabs(xd[i]) >= c) ? ONE : ZERO;
+  }
+
+  return;
+}
+
+booleantype N_VInvTest_Simd(N_Vector x, N_Vector z)
+{
+  long int i, N;
+  realtype *xd, *zd;
+  booleantype no_zero_found;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  zd = NV_DATA_SIMD(z);
+
+  no_zero_found = TRUE;
+  for (i = 0; i < N; i++) {
+    if (xd[i] == ZERO)
+      no_zero_found = FALSE;
+    else
+      zd[i] = ONE/xd[i];
+  }
+
+  return no_zero_found;
+}
+
+booleantype N_VConstrMask_Simd(N_Vector c, N_Vector x, N_Vector m)
+{
+  long int i, N;
+  booleantype test;
+  realtype *cd, *xd, *md;
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+  cd = NV_DATA_SIMD(c);
+  md = NV_DATA_SIMD(m);
+
+  test = TRUE;
+
+  for (i = 0; i < N; i++) {
+    md[i] = ZERO;
+    if (cd[i] == ZERO) continue;
+    if (cd[i] > ONEPT5 || cd[i] < -ONEPT5) {
+      if ( xd[i]*cd[i] <= ZERO) { test = FALSE; md[i] = ONE; }
+      continue;
+    }
+    if ( cd[i] > HALF || cd[i] < -HALF) {
+      if (xd[i]*cd[i] < ZERO ) { test = FALSE; md[i] = ONE; }
+    }
+  }
+
+  return(test);
+}
+
+realtype N_VMinQuotient_Simd(N_Vector num, N_Vector denom)
+{
+  booleantype notEvenOnce;
+  long int i, N;
+  realtype *nd, *dd, min;
+
+  N  = NV_LENGTH_SIMD(num);
+  nd = NV_DATA_SIMD(num);
+  dd = NV_DATA_SIMD(denom);
+
+  notEvenOnce = TRUE;
+  min = BIG_REAL;
+
+  for (i = 0; i < N; i++) {
+    if (dd[i] == ZERO) continue;
+    else {
+      if (!notEvenOnce) min = SUNMIN(min, nd[i]/dd[i]);
+      else {
+        min = nd[i]/dd[i];
+        notEvenOnce = FALSE;
+      }
+    }
+  }
+
+  return(min);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * fused vector operations
+ * -----------------------------------------------------------------
+ */
+
+void N_VLinearCombination_Simd(int nvec, realtype *c, N_Vector *X, N_Vector z)
+{
+  long int i, N;
+  int k, k0, nblock;
+  realtype sum, *zd, *xd[NV_SIMD_MAXVEC];
+
+  N  = NV_LENGTH_SIMD(z);
+  zd = NV_DATA_SIMD(z);
+
+  /* the first block computes z, following blocks add to z (in case of
+     more than NV_SIMD_MAXVEC vectors); z may only be X[0] */
+  for (k0 = 0; k0 < nvec; k0 += NV_SIMD_MAXVEC) {
+    nblock = SUNMIN(nvec - k0, NV_SIMD_MAXVEC);
+    for (k = 0; k < nblock; k++)
+      xd[k] = NV_DATA_SIMD(X[k0+k]);
+
+    i = 0;
+#if defined(NV_SIMD_AVX)
+    for (; i + VW <= N; i += VW) {
+      __m256d vsum = (k0 == 0) ? _mm256_mul_pd(_mm256_set1_pd(c[0]), _mm256_loadu_pd(xd[0]+i))
+                               : VFMADD(_mm256_set1_pd(c[k0]), _mm256_loadu_pd(xd[0]+i),
+                                        _mm256_loadu_pd(zd+i));
+      for (k = 1; k < nblock; k++)
+        vsum = VFMADD(_mm256_set1_pd(c[k0+k]), _mm256_loadu_pd(xd[k]+i), vsum);
+      _mm256_storeu_pd(zd+i, vsum);
+    }
+#endif
+    for (; i < N; i++) {
+      sum = (k0 == 0) ? c[0]*xd[0][i] : c[k0]*xd[0][i] + zd[i];
+      for (k = 1; k < nblock; k++)
+        sum += c[k0+k]*xd[k][i];
+      zd[i] = sum;
+    }
+  }
+
+  return;
+}
+
+void N_VScaleAddMulti_Simd(int nvec, realtype *a, N_Vector x, N_Vector *Y, N_Vector *Z)
+{
+  long int i, N;
+  int j, j0, nblock;
+  realtype *xd, *yd[NV_SIMD_MAXVEC], *zd[NV_SIMD_MAXVEC];
+
+  N  = NV_LENGTH_SIMD(x);
+  xd = NV_DATA_SIMD(x);
+
+  for (j0 = 0; j0 < nvec; j0 += NV_SIMD_MAXVEC) {
+    nblock = SUNMIN(nvec - j0, NV_SIMD_MAXVEC);
+    for (j = 0; j < nblock; j++) {
+      yd[j] = NV_DATA_SIMD(Y[j0+j]);
+      zd[j] = NV_DATA_SIMD(Z[j0+j]);
+    }
+
+    /* x is read once for all vectors of the block */
+    i = 0;
+#if defined(NV_SIMD_AVX)
+    for (; i + VW <= N; i += VW) {
+      __m256d vx = _mm256_loadu_pd(xd+i);
+      for (j = 0; j < nblock; j++)
+        _mm256_storeu_pd(zd[j]+i, VFMADD(_mm256_set1_pd(a[j0+j]), vx, _mm256_loadu_pd(yd[j]+i)));
+    }
+#endif
+    for (; i < N; i++) {
+      for (j = 0; j < nblock; j++)
+        zd[j][i] = a[j0+j]*xd[i] + yd[j][i];
+    }
+  }
+
+  return;
+}
+
+realtype N_VLinearSumWrmsNorm_Simd(realtype a, N_Vector x, realtype b, N_Vector y,
+                                   N_Vector z, N_Vector w)
+{
+  long int i, N;
+  realtype sum, zi, prodi, *xd, *yd, *zd, *wd;
+
+  sum = ZERO;
+
+  N  = NV_LENGTH_SIMD(z);
+  xd = NV_DATA_SIMD(x);
+  yd = NV_DATA_SIMD(y);
+  zd = NV_DATA_SIMD(z);
+  wd = NV_DATA_SIMD(w);
+
+  i = 0;
+#if defined(NV_SIMD_AVX)
+  {
+    __m256d va = _mm256_set1_pd(a);
+    __m256d vb = _mm256_set1_pd(b);
+    __m256d vsum = _mm256_setzero_pd();
+    __m256d vz, vprod;
+    for (; i + VW <= N; i += VW) {
+      vz = VFMADD(va, _mm256_loadu_pd(xd+i), _mm256_mul_pd(vb, _mm256_loadu_pd(yd+i)));
+      _mm256_storeu_pd(zd+i, vz);
+      vprod = _mm256_mul_pd(vz, _mm256_loadu_pd(wd+i));
+      vsum = VFMADD(vprod, vprod, vsum);
+    }
+    sum = VHsum_Simd(vsum);
+  }
+#endif
+  for (; i < N; i++) {
+    zi = (a*xd[i])+(b*yd[i]);
+    zd[i] = zi;
+    prodi = zi*wd[i];
+    sum += SUNSQR(prodi);
+  }
+
+  return(SUNRsqrt(sum/N));
+}
+
+/*
+ * -----------------------------------------------------------------
+ * private functions
+ * -----------------------------------------------------------------
+ */
+
+static realtype *VAlloc_Simd(long int length)
+{
+  void *data;
+
+  data = NULL;
+#if defined(_WIN32)
+  data = _aligned_malloc(length * sizeof(realtype), NV_SIMD_ALIGNMENT);
+#else
+  if (posix_memalign(&data, NV_SIMD_ALIGNMENT, length * sizeof(realtype)) != 0)
+    data = NULL;
+#endif
+
+  return((realtype *) data);
+}
+
+static void VFree_Simd(realtype *data)
+{
+#if defined(_WIN32)
+  _aligned_free(data);
+#else
+  free(data);
+#endif
+
+  return;
+}
+
+static N_VectorPool_Simd VPoolNew_Simd(long int length)
+{
+  N_VectorPool_Simd pool;
+
+  pool = NULL;
+  pool = (N_VectorPool_Simd) malloc(sizeof(struct _N_VectorPool_Simd));
+  if (pool == NULL) return(NULL);
+
+  pool->length   = length;
+  pool->refcount = 1;
+  pool->nfree    = 0;
+
+  return(pool);
+}
+
+static void VPoolRelease_Simd(N_VectorPool_Simd pool)
+{
+  int j;
+
+  if (--pool->refcount > 0) return;
+
+  for (j = 0; j < pool->nfree; j++)
+    VFree_Simd(pool->free_data[j]);
+  free(pool);
+
+  return;
+}
+
+static realtype *VPoolGet_Simd(N_VectorPool_Simd pool)
+{
+  if (pool->nfree > 0)
+    return(pool->free_data[--pool->nfree]);
+
+  return(VAlloc_Simd(pool->length));
+}
+
+static void VPoolPut_Simd(N_VectorPool_Simd pool, realtype *data)
+{
+  if (data == NULL) return;
+
+  if (pool->nfree < NV_SIMD_POOL_SIZE)
+    pool->free_data[pool->nfree++] = data;
+  else
+    VFree_Simd(data);
+
+  return;
+}
+
+#if defined(NV_SIMD_AVX)
+static realtype VHsum_Simd(__m256d v)
+{
+  __m128d lo, hi;
+
+  lo = _mm256_castpd256_pd128(v);
+  hi = _mm256_extractf128_pd(v, 1);
+  lo = _mm_add_pd(lo, hi);
+  lo = _mm_add_sd(lo, _mm_unpackhi_pd(lo, lo));
+
+  return(_mm_cvtsd_f64(lo));
+}
+#endif
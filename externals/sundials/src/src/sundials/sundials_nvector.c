@@ -180,6 +180,47 @@ realtype N_VMinQuotient(N_Vector num, N_Vector denom)
   return((realtype) num->ops->nvminquotient(num, denom));
 }
 
+/*
+ * -----------------------------------------------------------------
+ * Fused operations, with fallback to the separate operations
+ * if the implementation does not provide them
+ * -----------------------------------------------------------------
+ */
+
+void N_VLinearCombination(int nvec, realtype *c, N_Vector *X, N_Vector z)
+{
+  int i;
+
+  if (z->ops->nvlinearcombination != NULL) {
+    z->ops->nvlinearcombination(nvec, c, X, z);
+    return;
+  }
+  z->ops->nvscale(c[0], X[0], z);
+  for (i = 1; i < nvec; i++)
+    z->ops->nvlinearsum(c[i], X[i], RCONST(1.0), z, z);
+}
+
+void N_VScaleAddMulti(int nvec, realtype *a, N_Vector x, N_Vector *Y, N_Vector *Z)
+{
+  int j;
+
+  if (x->ops->nvscaleaddmulti != NULL) {
+    x->ops->nvscaleaddmulti(nvec, a, x, Y, Z);
+    return;
+  }
+  for (j = 0; j < nvec; j++)
+    x->ops->nvlinearsum(a[j], x, RCONST(1.0), Y[j], Z[j]);
+}
+
+realtype N_VLinearSumWrmsNorm(realtype a, N_Vector x, realtype b, N_Vector y,
+                              N_Vector z, N_Vector w)
+{
+  if (z->ops->nvlinearsumwrmsnorm != NULL)
+    return(z->ops->nvlinearsumwrmsnorm(a, x, b, y, z, w));
+  z->ops->nvlinearsum(a, x, b, y, z);
+  return(z->ops->nvwrmsnorm(z, w));
+}
+
 /*
  * -----------------------------------------------------------------
  * Additional functions exported by the generic NVECTOR: